@@ -0,0 +1,171 @@
+// Closed-loop throughput of AsyncAgentClient against a running gMCP server.
+//
+// One thread starts --window requests; each completion immediately starts
+// the next, so exactly --window calls are in flight on --channels
+// connections for the whole run. Reports requests per second and the
+// send-to-reply latency. Raise --window until throughput stops growing to
+// find the server's capacity; latency then grows with the window.
+//
+// Usage: async_client_bench [--address HOST:PORT] [--channels N] [--window N]
+//                           [--seconds S] [--balancing round-robin|least-loaded]
+//                           [--workload tool|query]
+//
+// Start the server first, e.g. `gmcp_server --address=127.0.0.1:50051`.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include "client/async_agent_client.h"
+#include "server/metrics.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string address = "127.0.0.1:50051";
+    int channels = 4;
+    int window = 256;
+    double seconds = 10;
+    std::string balancing = "least-loaded";
+    std::string workload = "tool";
+};
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--address") == 0) {
+            options.address = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--channels") == 0) {
+            options.channels = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--window") == 0) {
+            options.window = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--seconds") == 0) {
+            options.seconds = std::atof(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--balancing") == 0) {
+            options.balancing = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--workload") == 0) {
+            options.workload = argv[i + 1];
+        }
+    }
+    return options;
+}
+
+// Keeps one request in flight per slot until the run ends
+class Loop {
+public:
+    Loop(const Options& options, Clock::time_point end)
+        : tool_(options.workload == "tool"), end_(end) {
+        invocation_.set_tool_id("calculator");
+        (*invocation_.mutable_arguments())["operation"] = "add";
+        (*invocation_.mutable_arguments())["a"] = "1";
+        (*invocation_.mutable_arguments())["b"] = "2";
+        query_.set_memory_id("default_store");
+        query_.set_query_type(gmcp::QueryType::GET);
+        query_.set_query("example_key");
+    }
+
+    void Start(gmcp::AsyncAgentClient* client, int window) {
+        client_ = client;
+        for (int i = 0; i < window; ++i) {
+            Send();
+        }
+    }
+
+    const gmcp::LatencyHistogram& latency() const { return latency_; }
+    uint64_t failures() const { return failures_.load(std::memory_order_relaxed); }
+
+private:
+    void Send() {
+        Clock::time_point start = Clock::now();
+        if (start >= end_) {
+            return;
+        }
+        if (tool_) {
+            client_->InvokeTool(invocation_, [this, start](const grpc::Status& status,
+                                                           gmcp::ToolResult&&) {
+                Done(status, start);
+            });
+        } else {
+            client_->QueryMemory(query_, [this, start](const grpc::Status& status,
+                                                       gmcp::MemoryResult&&) {
+                Done(status, start);
+            });
+        }
+    }
+
+    void Done(const grpc::Status& status, Clock::time_point start) {
+        latency_.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            Clock::now() - start).count());
+        if (!status.ok()) {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+        }
+        Send();
+    }
+
+    gmcp::AsyncAgentClient* client_ = nullptr;
+    const bool tool_;
+    const Clock::time_point end_;
+    gmcp::ToolInvocation invocation_;
+    gmcp::MemoryQuery query_;
+    gmcp::LatencyHistogram latency_;
+    std::atomic<uint64_t> failures_{0};
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options = ParseOptions(argc, argv);
+    options.channels = std::max(options.channels, 1);
+    options.window = std::max(options.window, 1);
+    if (options.seconds <= 0 ||
+        (options.balancing != "round-robin" && options.balancing != "least-loaded") ||
+        (options.workload != "tool" && options.workload != "query")) {
+        std::fprintf(stderr,
+                     "Usage: %s [--address HOST:PORT] [--channels N] [--window N]\n"
+                     "          [--seconds S] [--balancing round-robin|least-loaded]\n"
+                     "          [--workload tool|query]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    gmcp::AsyncAgentClient::Options client_options;
+    client_options.channels = options.channels;
+    client_options.balancing = options.balancing == "round-robin"
+                                   ? gmcp::AsyncAgentClient::Balancing::kRoundRobin
+                                   : gmcp::AsyncAgentClient::Balancing::kLeastLoaded;
+    auto end = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                  std::chrono::duration<double>(options.seconds));
+    Loop loop(options, end);
+    auto client = std::make_unique<gmcp::AsyncAgentClient>(options.address, client_options);
+    if (!client->WaitForConnected(std::chrono::seconds(5))) {
+        std::fprintf(stderr, "Cannot connect to %s\n", options.address.c_str());
+        return 1;
+    }
+    std::printf("Closed loop: %d in flight on %d channels (%s), %s workload against %s\n",
+                options.window, options.channels, options.balancing.c_str(),
+                options.workload.c_str(), options.address.c_str());
+
+    Clock::time_point start = Clock::now();
+    loop.Start(client.get(), options.window);
+    std::this_thread::sleep_until(end);
+    // Waits for the last calls, which stop sending once the run is over
+    client.reset();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    gmcp::LatencyHistogram::Snapshot snapshot = loop.latency().Collect();
+    std::printf("%12s %10s %10s %10s %10s %10s %10s\n", "req/s", "mean us", "p50 us", "p99 us",
+                "p99.9 us", "max us", "failed");
+    std::printf("%12.0f %10.1f %10.1f %10.1f %10.1f %10.1f %10llu\n", snapshot.count / seconds,
+                snapshot.count ? snapshot.sum_ns / 1e3 / snapshot.count : 0.0,
+                snapshot.Percentile(0.50) / 1e3, snapshot.Percentile(0.99) / 1e3,
+                snapshot.Percentile(0.999) / 1e3, snapshot.max_ns / 1e3,
+                static_cast<unsigned long long>(loop.failures()));
+    return 0;
+}
@@ -0,0 +1,117 @@
+// Publish-cost benchmark for EventBus subscription matching.
+//
+// Registers 10k subscribers (by default), each interested in one event type
+// and one "agent" metadata value, then publishes events with random type and
+// agent. With indexed matching the publish cost tracks the number of
+// subscribers that actually match, not the total; the second scenario makes
+// every subscriber match for comparison.
+//
+// Usage: event_bus_bench [--subscribers N] [--types T] [--agents A] [--events E]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "server/event_bus.h"
+
+namespace {
+
+struct Options {
+    int subscribers = 10000;
+    int types = 50;
+    int agents = 20;
+    int events = 200000;
+};
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--subscribers") == 0) {
+            options.subscribers = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--types") == 0) {
+            options.types = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--agents") == 0) {
+            options.agents = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--events") == 0) {
+            options.events = std::atoi(argv[i + 1]);
+        }
+    }
+    return options;
+}
+
+struct Result {
+    double ns_per_publish;
+    double deliveries_per_publish;
+};
+
+Result RunScenario(const Options& options, bool filtered) {
+    gmcp::EventBus::Options bus_options;
+    bus_options.queue_capacity = 16;
+    gmcp::EventBus bus(bus_options);
+
+    std::vector<std::shared_ptr<gmcp::EventBus::Subscription>> subscriptions;
+    for (int i = 0; i < options.subscribers; ++i) {
+        gmcp::EventSubscription request;
+        request.set_agent_id("subscriber_" + std::to_string(i));
+        if (filtered) {
+            request.add_event_types("type_" + std::to_string(i % options.types));
+            (*request.mutable_filters())["agent"] =
+                "agent_" + std::to_string((i / options.types) % options.agents);
+        }
+        subscriptions.push_back(bus.Subscribe(request));
+    }
+
+    // Pre-build events so only Publish is timed
+    std::mt19937 rng(42);
+    std::vector<gmcp::Event> events(1024);
+    for (auto& event : events) {
+        event.set_event_type("type_" + std::to_string(rng() % options.types));
+        (*event.mutable_metadata())["agent"] = "agent_" + std::to_string(rng() % options.agents);
+        (*event.mutable_metadata())["region"] = "us-east";
+        event.set_payload("payload");
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.events; ++i) {
+        bus.Publish(events[i % events.size()]);
+    }
+    double elapsed_ns = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count();
+
+    // Drained rings hold at most 16 events; count deliveries via drops + queue
+    uint64_t delivered = 0;
+    std::shared_ptr<const gmcp::Event> event;
+    for (auto& subscription : subscriptions) {
+        delivered += subscription->dropped();
+        while (subscription->TryPop(&event)) {
+            ++delivered;
+        }
+        bus.Unsubscribe(subscription);
+    }
+    return {elapsed_ns / options.events, static_cast<double>(delivered) / options.events};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options = ParseOptions(argc, argv);
+
+    std::printf("EventBus publish with %d subscribers, %d events\n",
+                options.subscribers, options.events);
+    std::printf("%-28s %14s %20s %16s\n", "scenario", "ns/publish", "deliveries/publish",
+                "ns/delivery");
+
+    Result filtered = RunScenario(options, true);
+    std::printf("%-28s %14.0f %20.1f %16.1f\n", "type+filter (indexed)", filtered.ns_per_publish,
+                filtered.deliveries_per_publish,
+                filtered.ns_per_publish / std::max(filtered.deliveries_per_publish, 1.0));
+
+    Result all = RunScenario(options, false);
+    std::printf("%-28s %14.0f %20.1f %16.1f\n", "all subscribers match", all.ns_per_publish,
+                all.deliveries_per_publish,
+                all.ns_per_publish / std::max(all.deliveries_per_publish, 1.0));
+    return 0;
+}
@@ -0,0 +1,346 @@
+// Open-loop load generator for a running gMCP server.
+//
+// Simulated agents each send requests on a fixed schedule, so the offered
+// load is --rate requests per second in total regardless of how fast the
+// server answers. Latency is measured from the time a request was *meant*
+// to be sent, not from when it was actually sent: when the server stalls, an
+// agent falls behind schedule and the requests it could not send on time
+// are charged the wait (coordinated-omission correction). The report shows
+// both the corrected latency and the raw send-to-reply latency. A large gap
+// between them means the server could not keep up with the offered rate.
+// Agents stop at the end of the run even when behind; requests that were
+// due but never sent are reported as unsent.
+//
+// Two paths are measured one after the other:
+//
+//   unary   InvokeTool / QueryMemory, one blocking call at a time per agent
+//   stream  StreamAgentMessages, one stream per agent; a writer sends on
+//           schedule and a reader matches replies by request_id
+//
+// Usage: gmcp_bench [--address HOST:PORT] [--agents N] [--rate R] [--seconds S]
+//                   [--warmup S] [--channels N] [--path unary|stream|both]
+//                   [--workload tool|query|mixed]
+//
+// Start the server first, e.g. `gmcp_server --address=127.0.0.1:50051`.
+
+#include <grpcpp/grpcpp.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gmcp.grpc.pb.h"
+#include "server/metrics.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string address = "127.0.0.1:50051";
+    int agents = 16;
+    // Requests per second across all agents
+    double rate = 10000;
+    double seconds = 10;
+    // Requests scheduled before this are sent but not recorded
+    double warmup = 1;
+    int channels = 4;
+    std::string path = "both";
+    std::string workload = "mixed";
+};
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--address") == 0) {
+            options.address = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--agents") == 0) {
+            options.agents = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--rate") == 0) {
+            options.rate = std::atof(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--seconds") == 0) {
+            options.seconds = std::atof(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--warmup") == 0) {
+            options.warmup = std::atof(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--channels") == 0) {
+            options.channels = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--path") == 0) {
+            options.path = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--workload") == 0) {
+            options.workload = argv[i + 1];
+        }
+    }
+    return options;
+}
+
+int64_t Nanos(Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+// Sleep until close to `deadline`, then spin the rest so timer slack does
+// not show up as latency
+void WaitUntil(Clock::time_point deadline) {
+    constexpr auto kSpin = std::chrono::microseconds(50);
+    if (Clock::now() < deadline - kSpin) {
+        std::this_thread::sleep_until(deadline - kSpin);
+    }
+    while (Clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+// Fixed send times of one agent: request n is due at start + n * interval
+struct Schedule {
+    Clock::time_point start;
+    Clock::duration interval;
+    Clock::time_point record_from;
+    Clock::time_point end;
+
+    Clock::time_point due(uint64_t n) const { return start + interval * n; }
+};
+
+struct Results {
+    gmcp::LatencyHistogram corrected;
+    gmcp::LatencyHistogram uncorrected;
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> errors{0};
+    // Due before the end of the run but never sent
+    std::atomic<uint64_t> unsent{0};
+};
+
+bool UsesTool(const Options& options, uint64_t n) {
+    return options.workload == "tool" || (options.workload == "mixed" && n % 2 == 0);
+}
+
+void FillToolInvocation(uint64_t n, gmcp::ToolInvocation* invocation) {
+    invocation->set_tool_id("calculator");
+    auto& arguments = *invocation->mutable_arguments();
+    arguments["operation"] = "add";
+    arguments["a"] = "1";
+    arguments["b"] = std::to_string(n);
+}
+
+void FillMemoryQuery(gmcp::MemoryQuery* query) {
+    query->set_memory_id("default_store");
+    query->set_query_type(gmcp::QueryType::GET);
+    query->set_query("example_key");
+}
+
+void RecordReply(const Schedule& schedule, uint64_t n, Clock::time_point sent_at,
+                 Clock::time_point replied_at, Results* results) {
+    Clock::time_point due = schedule.due(n);
+    if (due < schedule.record_from) {
+        return;
+    }
+    results->corrected.Record(Nanos(replied_at - due));
+    results->uncorrected.Record(Nanos(replied_at - sent_at));
+}
+
+void RunUnaryAgent(const Options& options, gmcp::AgentCoordination::Stub* stub,
+                   const Schedule& schedule, Results* results) {
+    gmcp::ToolInvocation invocation;
+    gmcp::ToolResult tool_result;
+    gmcp::MemoryQuery query;
+    gmcp::MemoryResult memory_result;
+    FillMemoryQuery(&query);
+
+    uint64_t n = 0;
+    for (; schedule.due(n) < schedule.end && Clock::now() < schedule.end; ++n) {
+        WaitUntil(schedule.due(n));
+        grpc::ClientContext context;
+        grpc::Status status;
+        Clock::time_point sent_at = Clock::now();
+        if (UsesTool(options, n)) {
+            FillToolInvocation(n, &invocation);
+            status = stub->InvokeTool(&context, invocation, &tool_result);
+        } else {
+            status = stub->QueryMemory(&context, query, &memory_result);
+        }
+        Clock::time_point replied_at = Clock::now();
+        results->sent.fetch_add(1, std::memory_order_relaxed);
+        if (!status.ok()) {
+            results->errors.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        RecordReply(schedule, n, sent_at, replied_at, results);
+    }
+    for (; schedule.due(n) < schedule.end; ++n) {
+        results->unsent.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void RunStreamAgent(const Options& options, int agent, gmcp::AgentCoordination::Stub* stub,
+                    const Schedule& schedule, Results* results) {
+    // Requests this agent will send; request_id is the index into send times
+    uint64_t total = 0;
+    while (schedule.due(total) < schedule.end) {
+        ++total;
+    }
+    std::vector<std::atomic<int64_t>> sent_ns(total);
+
+    grpc::ClientContext context;
+    auto stream = stub->StreamAgentMessages(&context);
+
+    std::thread writer([&] {
+        gmcp::AgentMessage message;
+        message.set_agent_id("bench_agent_" + std::to_string(agent));
+        gmcp::MemoryQuery query;
+        FillMemoryQuery(&query);
+        uint64_t n = 0;
+        for (; n < total && Clock::now() < schedule.end; ++n) {
+            WaitUntil(schedule.due(n));
+            message.set_request_id(std::to_string(n));
+            if (UsesTool(options, n)) {
+                message.set_type(gmcp::MessageType::TOOL_INVOCATION);
+                FillToolInvocation(n, message.mutable_tool_invocation());
+            } else {
+                message.set_type(gmcp::MessageType::MEMORY_QUERY);
+                *message.mutable_memory_query() = query;
+            }
+            sent_ns[n].store(Nanos(Clock::now().time_since_epoch()), std::memory_order_release);
+            results->sent.fetch_add(1, std::memory_order_relaxed);
+            // Blocks under flow control; the schedule keeps counting
+            if (!stream->Write(message)) {
+                ++n;
+                break;
+            }
+        }
+        results->unsent.fetch_add(total - n, std::memory_order_relaxed);
+        stream->WritesDone();
+    });
+
+    uint64_t received = 0;
+    gmcp::AgentMessage reply;
+    while (stream->Read(&reply)) {
+        Clock::time_point replied_at = Clock::now();
+        uint64_t n = std::strtoull(reply.request_id().c_str(), nullptr, 10);
+        if (n >= total) {
+            results->errors.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        ++received;
+        Clock::time_point sent_at(std::chrono::nanoseconds(
+            sent_ns[n].load(std::memory_order_acquire)));
+        RecordReply(schedule, n, sent_at, replied_at, results);
+    }
+    writer.join();
+    grpc::Status status = stream->Finish();
+    uint64_t sent = 0;
+    for (const auto& value : sent_ns) {
+        sent += value.load(std::memory_order_relaxed) != 0;
+    }
+    // Anything sent without a reply counts as an error
+    if (!status.ok() || received < sent) {
+        results->errors.fetch_add(sent - std::min(sent, received), std::memory_order_relaxed);
+    }
+}
+
+void PrintRow(const char* path, const char* kind, const gmcp::LatencyHistogram& histogram,
+              double rate) {
+    gmcp::LatencyHistogram::Snapshot snapshot = histogram.Collect();
+    std::printf("%-7s %-12s %10llu %10.0f %10.1f %10.1f %10.1f %10.1f %10.1f\n", path, kind,
+                static_cast<unsigned long long>(snapshot.count), rate,
+                snapshot.Percentile(0.50) / 1e3, snapshot.Percentile(0.90) / 1e3,
+                snapshot.Percentile(0.99) / 1e3, snapshot.Percentile(0.999) / 1e3,
+                snapshot.max_ns / 1e3);
+}
+
+void RunPath(const Options& options, bool streaming,
+             const std::vector<std::unique_ptr<gmcp::AgentCoordination::Stub>>& stubs) {
+    Results results;
+    // Give every thread time to start, then stagger agents across one interval
+    auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.agents / options.rate));
+    Clock::time_point start = Clock::now() + std::chrono::milliseconds(100);
+    Clock::time_point record_from =
+        start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(options.warmup));
+    Clock::time_point end = record_from + std::chrono::duration_cast<Clock::duration>(
+                                              std::chrono::duration<double>(options.seconds));
+
+    std::vector<std::thread> agents;
+    for (int agent = 0; agent < options.agents; ++agent) {
+        Schedule schedule{start + interval * agent / options.agents, interval, record_from, end};
+        gmcp::AgentCoordination::Stub* stub = stubs[agent % stubs.size()].get();
+        agents.emplace_back([&options, streaming, agent, stub, schedule, &results] {
+            if (streaming) {
+                RunStreamAgent(options, agent, stub, schedule, &results);
+            } else {
+                RunUnaryAgent(options, stub, schedule, &results);
+            }
+        });
+    }
+    for (auto& agent : agents) {
+        agent.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - record_from).count();
+
+    const char* path = streaming ? "stream" : "unary";
+    double achieved = results.corrected.Collect().count / elapsed;
+    PrintRow(path, "corrected", results.corrected, achieved);
+    PrintRow(path, "uncorrected", results.uncorrected, achieved);
+    uint64_t errors = results.errors.load();
+    if (errors > 0) {
+        std::printf("%-7s %llu of %llu requests failed\n", path,
+                    static_cast<unsigned long long>(errors),
+                    static_cast<unsigned long long>(results.sent.load()));
+    }
+    uint64_t unsent = results.unsent.load();
+    if (unsent > 0) {
+        std::printf("%-7s %llu requests were never sent: the server could not sustain the rate\n",
+                    path, static_cast<unsigned long long>(unsent));
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options = ParseOptions(argc, argv);
+    options.agents = std::max(options.agents, 1);
+    options.channels = std::clamp(options.channels, 1, options.agents);
+    if (options.rate <= 0 || options.seconds <= 0 ||
+        (options.path != "unary" && options.path != "stream" && options.path != "both") ||
+        (options.workload != "tool" && options.workload != "query" &&
+         options.workload != "mixed")) {
+        std::fprintf(stderr,
+                     "Usage: %s [--address HOST:PORT] [--agents N] [--rate R] [--seconds S]\n"
+                     "          [--warmup S] [--channels N] [--path unary|stream|both]\n"
+                     "          [--workload tool|query|mixed]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    // Separate subchannel pools make each channel its own connection
+    std::vector<std::unique_ptr<gmcp::AgentCoordination::Stub>> stubs;
+    for (int i = 0; i < options.channels; ++i) {
+        grpc::ChannelArguments arguments;
+        arguments.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+        auto channel = grpc::CreateCustomChannel(options.address,
+                                                 grpc::InsecureChannelCredentials(), arguments);
+        if (!channel->WaitForConnected(std::chrono::system_clock::now() +
+                                                    std::chrono::seconds(5))) {
+            std::fprintf(stderr, "Cannot connect to %s\n", options.address.c_str());
+            return 1;
+        }
+        stubs.push_back(gmcp::AgentCoordination::NewStub(channel));
+    }
+
+    std::printf("Open-loop load: %d agents on %d channels, %.0f req/s for %.1fs "
+                "(+%.1fs warm-up), %s workload against %s\n",
+                options.agents, options.channels, options.rate, options.seconds, options.warmup,
+                options.workload.c_str(), options.address.c_str());
+    std::printf("%-7s %-12s %10s %10s %10s %10s %10s %10s %10s\n", "path", "latency", "count",
+                "req/s", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+    if (options.path != "stream") {
+        RunPath(options, false, stubs);
+    }
+    if (options.path != "unary") {
+        RunPath(options, true, stubs);
+    }
+    return 0;
+}
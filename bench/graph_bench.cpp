@@ -0,0 +1,131 @@
+// Traversal throughput benchmark for the GRAPH memory store.
+//
+// Loads a random graph (each node gets --degree outgoing edges to uniformly
+// chosen targets), then times NEIGHBORS, k-hop BFS and SHORTEST_PATH
+// queries from random start nodes. Reports queries/s and, for BFS, the
+// number of nodes reached per second.
+//
+// Usage: graph_bench [--nodes N] [--degree D] [--hops H] [--queries Q]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "server/graph_store.h"
+
+namespace {
+
+struct Options {
+    size_t nodes = 1000000;
+    size_t degree = 16;
+    int hops = 2;
+    size_t queries = 1000;
+};
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--nodes") == 0) {
+            options.nodes = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--degree") == 0) {
+            options.degree = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--hops") == 0) {
+            options.hops = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--queries") == 0) {
+            options.queries = std::strtoull(argv[i + 1], nullptr, 10);
+        }
+    }
+    return options;
+}
+
+std::string NodeKey(size_t index) {
+    return "node_" + std::to_string(index);
+}
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Stats {
+    double queries_per_second;
+    double nodes_per_second;
+};
+
+// Results are capped at 10 entries so the timing measures the traversal,
+// not the copying of results
+Stats RunTraversals(const gmcp::GraphStore& store, const Options& options,
+                    gmcp::TraversalType type, int max_depth) {
+    std::mt19937_64 rng(99);
+    std::uniform_int_distribution<size_t> pick(0, options.nodes - 1);
+
+    gmcp::MemoryQuery query;
+    query.set_query_type(gmcp::QueryType::TRAVERSE);
+    query.set_limit(10);
+    gmcp::GraphTraversal* traversal = query.mutable_traversal();
+    traversal->set_type(type);
+    traversal->set_max_depth(max_depth);
+
+    size_t reached = 0;
+    gmcp::MemoryResult result;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.queries; ++i) {
+        traversal->set_start_key(NodeKey(pick(rng)));
+        traversal->set_target_key(NodeKey(pick(rng)));
+        result.Clear();
+        store.Query(query, &result);
+        reached += result.total_count();
+    }
+    double elapsed = Seconds(start);
+    return {options.queries / elapsed, reached / elapsed};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options = ParseOptions(argc, argv);
+    options.nodes = std::max<size_t>(options.nodes, 2);
+    options.queries = std::max<size_t>(options.queries, 1);
+
+    gmcp::GraphStore store;
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<size_t> pick(0, options.nodes - 1);
+    const char* relations[] = {"knows", "mentions", "derived_from", "part_of"};
+
+    std::printf("GRAPH traversal: %zu nodes, %zu edges per node, %d hops\n", options.nodes,
+                options.degree, options.hops);
+
+    auto load_start = std::chrono::steady_clock::now();
+    constexpr size_t kBatch = 10000;
+    for (size_t loaded = 0; loaded < options.nodes; loaded += kBatch) {
+        std::vector<gmcp::MemoryEntry> batch(std::min(kBatch, options.nodes - loaded));
+        for (size_t i = 0; i < batch.size(); ++i) {
+            batch[i].set_key(NodeKey(loaded + i));
+            for (size_t e = 0; e < options.degree; ++e) {
+                gmcp::GraphEdge* edge = batch[i].add_edges();
+                edge->set_target(NodeKey(pick(rng)));
+                edge->set_relation(relations[e % 4]);
+            }
+        }
+        store.PutBatch(std::move(batch));
+    }
+    store.Fold();
+    double load_seconds = Seconds(load_start);
+    std::printf("Loaded %zu edges in %.1fs (%.0f edges/s)\n\n", store.edge_count(), load_seconds,
+                store.edge_count() / load_seconds);
+
+    std::printf("%-16s %14s %16s\n", "traversal", "queries/s", "nodes reached/s");
+    Stats neighbors = RunTraversals(store, options, gmcp::TraversalType::NEIGHBORS, 1);
+    std::printf("%-16s %14.0f %16.0f\n", "neighbors", neighbors.queries_per_second,
+                neighbors.nodes_per_second);
+    Stats bfs = RunTraversals(store, options, gmcp::TraversalType::BFS, options.hops);
+    std::string bfs_name = "bfs " + std::to_string(options.hops) + "-hop";
+    std::printf("%-16s %14.0f %16.0f\n", bfs_name.c_str(), bfs.queries_per_second,
+                bfs.nodes_per_second);
+    Stats path = RunTraversals(store, options, gmcp::TraversalType::SHORTEST_PATH, 0);
+    std::printf("%-16s %14.0f %16s\n", "shortest path", path.queries_per_second, "-");
+    return 0;
+}
@@ -0,0 +1,154 @@
+// Mixed read/write benchmark for MemoryManager.
+//
+// Threads issue a mix of GET, LIST and Store operations against several
+// pre-populated stores and report throughput and speedup relative to a single
+// thread. Reads use shared shard locks and writes lock one shard of one
+// store, so throughput should scale with cores.
+//
+// Usage: memory_manager_bench [--max-threads N] [--stores N] [--keys N]
+//                             [--read-percent P] [--list-percent P] [--seconds S]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "server/memory_manager.h"
+
+namespace {
+
+struct Options {
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    int stores = 4;
+    int keys = 100000;
+    int read_percent = 90;
+    // Share of reads that are LIST (limit 100) rather than GET
+    int list_percent = 5;
+    double seconds = 1.0;
+};
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--max-threads") == 0) {
+            options.max_threads = static_cast<unsigned>(std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--stores") == 0) {
+            options.stores = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--keys") == 0) {
+            options.keys = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--read-percent") == 0) {
+            options.read_percent = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--list-percent") == 0) {
+            options.list_percent = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--seconds") == 0) {
+            options.seconds = std::atof(argv[i + 1]);
+        }
+    }
+    return options;
+}
+
+std::string StoreId(int index) {
+    return "store_" + std::to_string(index);
+}
+
+std::string Key(int index) {
+    return "key_" + std::to_string(index);
+}
+
+double RunMixed(gmcp::MemoryManager& manager, const Options& options, unsigned threads) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> total{0};
+    std::vector<std::thread> workers;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::mt19937 rng(t + 1);
+            std::uniform_int_distribution<int> store_dist(0, options.stores - 1);
+            std::uniform_int_distribution<int> key_dist(0, options.keys - 1);
+            std::uniform_int_distribution<int> percent(0, 99);
+
+            gmcp::MemoryQuery query;
+            gmcp::MemoryEntry entry;
+            entry.set_value("updated");
+            uint64_t ops = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::string store = StoreId(store_dist(rng));
+                std::string key = Key(key_dist(rng));
+                if (percent(rng) < options.read_percent) {
+                    query.set_memory_id(store);
+                    if (percent(rng) < options.list_percent) {
+                        query.set_query_type(gmcp::QueryType::LIST);
+                        query.set_limit(100);
+                    } else {
+                        query.set_query_type(gmcp::QueryType::GET);
+                        query.set_query(key);
+                    }
+                    manager.Query(query);
+                } else {
+                    entry.set_key(key);
+                    manager.Store(store, entry);
+                }
+                ++ops;
+            }
+            total.fetch_add(ops);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    stop = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(total.load()) / elapsed;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options = ParseOptions(argc, argv);
+    options.stores = std::max(options.stores, 1);
+    options.keys = std::max(options.keys, 1);
+
+    gmcp::MemoryManager manager;
+    for (int s = 0; s < options.stores; ++s) {
+        gmcp::MemoryRegistration registration;
+        registration.set_memory_id(StoreId(s));
+        registration.set_type(gmcp::MemoryType::KEY_VALUE);
+        manager.RegisterMemory(registration);
+
+        std::vector<gmcp::MemoryEntry> entries(options.keys);
+        for (int k = 0; k < options.keys; ++k) {
+            entries[k].set_key(Key(k));
+            entries[k].set_value("value_" + std::to_string(k));
+        }
+        manager.StoreBatch(StoreId(s), std::move(entries));
+    }
+
+    std::printf("MemoryManager mixed workload (%d stores x %d keys, %d%% reads, "
+                "%d%% of reads LIST, %.1fs per step)\n",
+                options.stores, options.keys, options.read_percent, options.list_percent,
+                options.seconds);
+    std::printf("%8s %16s %10s\n", "threads", "ops/s", "speedup");
+
+    std::vector<unsigned> steps;
+    for (unsigned threads = 1; threads < options.max_threads; threads *= 2) {
+        steps.push_back(threads);
+    }
+    steps.push_back(options.max_threads);
+
+    double baseline = 0.0;
+    for (unsigned threads : steps) {
+        double rate = RunMixed(manager, options, threads);
+        if (threads == 1) {
+            baseline = rate;
+        }
+        std::printf("%8u %16.0f %9.2fx\n", threads, rate, rate / baseline);
+    }
+    return 0;
+}
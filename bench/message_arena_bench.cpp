@@ -0,0 +1,221 @@
+// Allocation and latency benchmark for the agent stream message path.
+//
+// Replays the per-message work of StreamAgentMessages (parse the request,
+// invoke a tool or query a store, serialize the reply) two ways:
+//
+//   heap   - the previous path: heap messages, results returned by value and
+//            copied into the reply, reply moved through the outbox
+//   arena  - the current path: request and reply on a pooled arena slot and
+//            results built in place in the reply
+//
+// Every operator new is counted, so the report shows heap allocations per
+// message alongside p50/p99 latency.
+//
+// Usage: message_arena_bench [--iterations N] [--entries N] [--value-bytes N]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <new>
+#include <string>
+#include <vector>
+#include "server/memory_manager.h"
+#include "server/message_arena_pool.h"
+#include "server/tool_manager.h"
+
+namespace {
+
+std::atomic<uint64_t> allocation_count{0};
+
+void* CountedAlloc(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(size_t size) { return CountedAlloc(size); }
+void* operator new[](size_t size) { return CountedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct Options {
+    int iterations = 200000;
+    // Entries returned by each LIST query
+    int entries = 32;
+    int value_bytes = 64;
+};
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--iterations") == 0) {
+            options.iterations = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--entries") == 0) {
+            options.entries = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--value-bytes") == 0) {
+            options.value_bytes = std::atoi(argv[i + 1]);
+        }
+    }
+    return options;
+}
+
+double Percentile(std::vector<double> values, double p) {
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+    return values[index];
+}
+
+struct Report {
+    double allocations_per_message;
+    double p50_us;
+    double p99_us;
+    double messages_per_second;
+};
+
+// Runs `handle(wire, out)` once per iteration on the serialized request
+template <typename Handle>
+Report Measure(const std::string& wire, int iterations, Handle&& handle) {
+    std::string out;
+    std::vector<double> latency_us;
+    latency_us.reserve(iterations);
+    // Warm up pools, arenas and the store's read path
+    for (int i = 0; i < 1000; ++i) {
+        handle(wire, &out);
+    }
+
+    uint64_t allocations = 0;
+    auto run_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        uint64_t before = allocation_count.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        handle(wire, &out);
+        auto end = std::chrono::steady_clock::now();
+        allocations += allocation_count.load(std::memory_order_relaxed) - before;
+        latency_us.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                   run_start).count();
+    return {static_cast<double>(allocations) / iterations, Percentile(latency_us, 0.50),
+            Percentile(latency_us, 0.99), iterations / elapsed};
+}
+
+// Serialize into a reused buffer, as gRPC does into its own byte buffers
+void Serialize(const gmcp::AgentMessage& message, std::string* out) {
+    out->resize(message.ByteSizeLong());
+    message.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(out->data()));
+}
+
+void PrintRow(const char* workload, const char* path, const Report& report) {
+    std::printf("%-12s %-6s %12.1f %10.2f %10.2f %14.0f\n", workload, path,
+                report.allocations_per_message, report.p50_us, report.p99_us,
+                report.messages_per_second);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options = ParseOptions(argc, argv);
+    options.iterations = std::max(options.iterations, 1);
+
+    gmcp::ToolManager tools;
+    gmcp::ToolRegistration echo;
+    echo.set_tool_id("echo");
+    tools.RegisterTool(echo, [](const std::map<std::string, std::string>& args) {
+        return args.at("text");
+    });
+
+    gmcp::MemoryManager memory;
+    gmcp::MemoryRegistration registration;
+    registration.set_memory_id("kv");
+    registration.set_type(gmcp::MemoryType::KEY_VALUE);
+    memory.RegisterMemory(registration);
+    std::vector<gmcp::MemoryEntry> entries(options.entries);
+    for (int i = 0; i < options.entries; ++i) {
+        entries[i].set_key("key_" + std::to_string(i));
+        entries[i].set_value(std::string(options.value_bytes, 'v'));
+        (*entries[i].mutable_metadata())["source"] = "bench";
+    }
+    memory.StoreBatch("kv", std::move(entries));
+
+    gmcp::AgentMessage tool_request;
+    tool_request.set_agent_id("bench_agent");
+    tool_request.set_request_id("req_1");
+    tool_request.set_type(gmcp::MessageType::TOOL_INVOCATION);
+    tool_request.mutable_tool_invocation()->set_tool_id("echo");
+    (*tool_request.mutable_tool_invocation()->mutable_arguments())["text"] = "hello";
+
+    gmcp::AgentMessage query_request;
+    query_request.set_agent_id("bench_agent");
+    query_request.set_request_id("req_2");
+    query_request.set_type(gmcp::MessageType::MEMORY_QUERY);
+    query_request.mutable_memory_query()->set_memory_id("kv");
+    query_request.mutable_memory_query()->set_query_type(gmcp::QueryType::LIST);
+    query_request.mutable_memory_query()->set_limit(options.entries);
+
+    // Previous path: by-value results copied into a heap reply that is then
+    // moved through the stream's outbox
+    std::deque<gmcp::AgentMessage> outbox;
+    auto heap_path = [&](const std::string& wire, std::string* out) {
+        gmcp::AgentMessage message;
+        message.ParseFromString(wire);
+        gmcp::AgentMessage response;
+        response.set_request_id(message.request_id());
+        if (message.type() == gmcp::MessageType::TOOL_INVOCATION) {
+            gmcp::ToolResult result = tools.InvokeTool(message.tool_invocation());
+            response.set_type(gmcp::MessageType::TOOL_RESULT);
+            *response.mutable_tool_result() = result;
+        } else {
+            gmcp::MemoryResult result = memory.Query(message.memory_query());
+            response.set_type(gmcp::MessageType::MEMORY_RESULT);
+            *response.mutable_memory_result() = result;
+        }
+        outbox.push_back(std::move(response));
+        gmcp::AgentMessage next = std::move(outbox.front());
+        outbox.pop_front();
+        Serialize(next, out);
+    };
+
+    // Current path: one pooled arena slot per message, results built in place
+    gmcp::MessageArenaPool arenas;
+    auto arena_path = [&](const std::string& wire, std::string* out) {
+        gmcp::MessageArenaPool::Slot* slot = arenas.Acquire();
+        gmcp::AgentMessage* message = slot->request();
+        message->ParseFromString(wire);
+        gmcp::AgentMessage* response = slot->response();
+        response->set_request_id(message->request_id());
+        if (message->type() == gmcp::MessageType::TOOL_INVOCATION) {
+            response->set_type(gmcp::MessageType::TOOL_RESULT);
+            tools.InvokeTool(message->tool_invocation(), response->mutable_tool_result());
+        } else {
+            response->set_type(gmcp::MessageType::MEMORY_RESULT);
+            memory.Query(message->memory_query(), response->mutable_memory_result());
+        }
+        Serialize(*response, out);
+        arenas.Release(slot);
+    };
+
+    std::string tool_wire = tool_request.SerializeAsString();
+    std::string query_wire = query_request.SerializeAsString();
+
+    std::printf("Agent stream message path (%d messages per run, LIST of %d entries x %d bytes)\n",
+                options.iterations, options.entries, options.value_bytes);
+    std::printf("%-12s %-6s %12s %10s %10s %14s\n", "workload", "path", "allocs/msg", "p50 us",
+                "p99 us", "msgs/s");
+    PrintRow("tool", "heap", Measure(tool_wire, options.iterations, heap_path));
+    PrintRow("tool", "arena", Measure(tool_wire, options.iterations, arena_path));
+    PrintRow("query", "heap", Measure(query_wire, options.iterations, heap_path));
+    PrintRow("query", "arena", Measure(query_wire, options.iterations, arena_path));
+    return 0;
+}
@@ -0,0 +1,269 @@
+// Single-threaded latency microbenchmarks for the server's hot-path calls.
+//
+// Each case runs one operation back to back and times it in batches, so
+// clock reads do not dominate sub-microsecond operations. Per-operation
+// latency (batch time / batch size) is recorded into the server's own
+// LatencyHistogram and reported as mean, p50, p99 and p99.9:
+//
+//   tool.*      ToolManager::InvokeTool (echo, calculator taking a std::map,
+//               calculator taking typed arguments, calculator served from
+//               the result cache, unknown tool)
+//   memory.*    MemoryManager::Store and Query (GET, LIST, SEARCH) on a
+//               key-value store of --keys entries
+//   event.*     EventBus::Publish with --subscribers subscribers, matching
+//               none, one, or a fan-out of 16 of them
+//
+// Usage: gmcp_microbench [--iterations N] [--max-seconds S] [--keys N]
+//                        [--subscribers N] [--filter TEXT]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "server/event_bus.h"
+#include "server/memory_manager.h"
+#include "server/metrics.h"
+#include "server/tool_manager.h"
+
+namespace {
+
+struct Options {
+    int iterations = 200000;
+    int keys = 10000;
+    int subscribers = 1000;
+    // Cases stop early once they have run this long
+    double max_seconds = 2;
+    // Only run cases whose name contains this text
+    std::string filter;
+};
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--iterations") == 0) {
+            options.iterations = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--keys") == 0) {
+            options.keys = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--subscribers") == 0) {
+            options.subscribers = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--max-seconds") == 0) {
+            options.max_seconds = std::atof(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--filter") == 0) {
+            options.filter = argv[i + 1];
+        }
+    }
+    return options;
+}
+
+// Operations per timing sample
+constexpr int kBatch = 32;
+
+class Runner {
+public:
+    explicit Runner(const Options& options) : options_(options) {
+        std::printf("%-24s %10s %10s %10s %10s %14s\n", "case", "mean ns", "p50 ns", "p99 ns",
+                    "p99.9 ns", "ops/s");
+    }
+
+    // Calls op(i) for i in [0, iterations) after a short warm-up
+    template <typename Op>
+    void Run(const char* name, Op&& op) {
+        if (!options_.filter.empty() && std::strstr(name, options_.filter.c_str()) == nullptr) {
+            return;
+        }
+        for (int i = 0; i < std::min(options_.iterations / 10, 1000); ++i) {
+            op(i);
+        }
+
+        gmcp::LatencyHistogram histogram;
+        int samples = std::max(1, options_.iterations / kBatch);
+        auto run_start = std::chrono::steady_clock::now();
+        auto deadline = run_start + std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::duration<double>(options_.max_seconds));
+        int sample = 0;
+        for (; sample < samples && std::chrono::steady_clock::now() < deadline; ++sample) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = sample * kBatch; i < (sample + 1) * kBatch; ++i) {
+                op(i);
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            histogram.Record(static_cast<uint64_t>(elapsed) / kBatch);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                       run_start).count();
+
+        gmcp::LatencyHistogram::Snapshot snapshot = histogram.Collect();
+        std::printf("%-24s %10.1f %10llu %10llu %10llu %14.0f\n", name,
+                    static_cast<double>(snapshot.sum_ns) / snapshot.count,
+                    static_cast<unsigned long long>(snapshot.Percentile(0.50)),
+                    static_cast<unsigned long long>(snapshot.Percentile(0.99)),
+                    static_cast<unsigned long long>(snapshot.Percentile(0.999)),
+                    static_cast<double>(sample) * kBatch / seconds);
+    }
+
+private:
+    const Options& options_;
+};
+
+std::string Key(int index) {
+    return "key_" + std::to_string(index);
+}
+
+void BenchTools(Runner& runner) {
+    gmcp::ToolManager tools;
+    gmcp::ToolRegistration echo;
+    echo.set_tool_id("echo");
+    tools.RegisterTool(echo, [](const std::map<std::string, std::string>& args) {
+        return args.at("text");
+    });
+    gmcp::ToolRegistration calculator;
+    calculator.set_tool_id("calculator");
+    auto add = [](const std::map<std::string, std::string>& args) {
+        return std::to_string(std::stod(args.at("a")) + std::stod(args.at("b")));
+    };
+    tools.RegisterTool(calculator, add);
+    // The same tool bound to its parameter schema
+    gmcp::ToolRegistration typed = calculator;
+    typed.set_tool_id("calculator_typed");
+    for (const char* name : {"a", "b"}) {
+        gmcp::ToolParameter* parameter = typed.add_parameters();
+        parameter->set_name(name);
+        parameter->set_type("number");
+        parameter->set_required(true);
+    }
+    tools.RegisterTool(typed, [](const gmcp::ToolArguments& args, const gmcp::CancellationToken&) {
+        return std::to_string(args.number(0) + args.number(1));
+    });
+    // The same tool answered from the result cache
+    calculator.set_tool_id("calculator_cached");
+    calculator.set_cacheable(true);
+    tools.RegisterTool(calculator, add);
+
+    gmcp::ToolInvocation echo_call;
+    echo_call.set_tool_id("echo");
+    (*echo_call.mutable_arguments())["text"] = "hello";
+    gmcp::ToolInvocation calculator_call;
+    calculator_call.set_tool_id("calculator");
+    (*calculator_call.mutable_arguments())["a"] = "12.5";
+    (*calculator_call.mutable_arguments())["b"] = "30";
+    gmcp::ToolInvocation typed_call = calculator_call;
+    typed_call.set_tool_id("calculator_typed");
+    gmcp::ToolInvocation cached_call = calculator_call;
+    cached_call.set_tool_id("calculator_cached");
+    gmcp::ToolInvocation missing_call;
+    missing_call.set_tool_id("missing");
+
+    gmcp::ToolResult result;
+    runner.Run("tool.invoke.echo", [&](int) { tools.InvokeTool(echo_call, &result); });
+    runner.Run("tool.invoke.calculator",
+               [&](int) { tools.InvokeTool(calculator_call, &result); });
+    runner.Run("tool.invoke.typed", [&](int) { tools.InvokeTool(typed_call, &result); });
+    runner.Run("tool.invoke.cached", [&](int) { tools.InvokeTool(cached_call, &result); });
+    runner.Run("tool.invoke.unknown", [&](int) { tools.InvokeTool(missing_call, &result); });
+}
+
+void BenchMemory(Runner& runner, int keys) {
+    gmcp::MemoryManager memory;
+    gmcp::MemoryRegistration registration;
+    registration.set_memory_id("kv");
+    registration.set_type(gmcp::MemoryType::KEY_VALUE);
+    memory.RegisterMemory(registration);
+    std::vector<gmcp::MemoryEntry> entries(keys);
+    for (int i = 0; i < keys; ++i) {
+        entries[i].set_key(Key(i));
+        entries[i].set_value(std::string(64, 'v'));
+    }
+    memory.StoreBatch("kv", std::move(entries));
+
+    // Pre-build requests so only the call itself is timed
+    std::vector<gmcp::MemoryEntry> writes(keys);
+    std::vector<gmcp::MemoryQuery> gets(keys);
+    for (int i = 0; i < keys; ++i) {
+        writes[i].set_key(Key(i));
+        writes[i].set_value(std::string(64, 'w'));
+        gets[i].set_memory_id("kv");
+        gets[i].set_query_type(gmcp::QueryType::GET);
+        gets[i].set_query(Key(i));
+    }
+    gmcp::MemoryQuery list;
+    list.set_memory_id("kv");
+    list.set_query_type(gmcp::QueryType::LIST);
+    list.set_limit(32);
+    gmcp::MemoryQuery search;
+    search.set_memory_id("kv");
+    search.set_query_type(gmcp::QueryType::SEARCH);
+    search.set_query("key_12");
+    search.set_limit(10);
+
+    gmcp::MemoryResult result;
+    runner.Run("memory.store", [&](int i) { memory.Store("kv", writes[i % keys]); });
+    runner.Run("memory.query.get", [&](int i) {
+        result.Clear();
+        memory.Query(gets[i % keys], &result);
+    });
+    runner.Run("memory.query.list", [&](int) {
+        result.Clear();
+        memory.Query(list, &result);
+    });
+    runner.Run("memory.query.search", [&](int) {
+        result.Clear();
+        memory.Query(search, &result);
+    });
+}
+
+void BenchEvents(Runner& runner, int subscribers) {
+    gmcp::EventBus bus;
+    std::vector<std::shared_ptr<gmcp::EventBus::Subscription>> subscriptions;
+    subscriptions.reserve(subscribers);
+    for (int i = 0; i < subscribers; ++i) {
+        gmcp::EventSubscription request;
+        request.set_agent_id("agent_" + std::to_string(i));
+        request.add_event_types("type_" + std::to_string(i));
+        // The first 16 subscribers also share one type, for the fan-out case
+        if (i < 16) {
+            request.add_event_types("broadcast");
+        }
+        subscriptions.push_back(bus.Subscribe(request));
+    }
+
+    auto make_event = [](const std::string& type) {
+        gmcp::Event event;
+        event.set_event_type(type);
+        event.set_source_agent_id("bench");
+        event.set_payload(std::string(64, 'p'));
+        return event;
+    };
+    gmcp::Event unmatched = make_event("nobody");
+    gmcp::Event single = make_event("type_0");
+    gmcp::Event broadcast = make_event("broadcast");
+
+    // Nobody drains the queues; drop-oldest keeps them at capacity
+    runner.Run("event.publish.none", [&](int) { bus.Publish(unmatched); });
+    runner.Run("event.publish.one", [&](int) { bus.Publish(single); });
+    runner.Run("event.publish.fanout16", [&](int) { bus.Publish(broadcast); });
+
+    for (const auto& subscription : subscriptions) {
+        bus.Unsubscribe(subscription);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options = ParseOptions(argc, argv);
+    options.iterations = std::max(options.iterations, kBatch);
+    options.keys = std::max(options.keys, 1);
+    options.subscribers = std::max(options.subscribers, 16);
+
+    std::printf("Hot-path microbenchmarks (%d operations per case, %d keys, %d subscribers)\n",
+                options.iterations, options.keys, options.subscribers);
+    Runner runner(options);
+    BenchTools(runner);
+    BenchMemory(runner, options.keys);
+    BenchEvents(runner, options.subscribers);
+    return 0;
+}
@@ -0,0 +1,199 @@
+// Contention benchmark for ToolManager::InvokeTool.
+//
+// Runs a fixed-cost tool from 1..N threads and reports throughput and
+// speedup relative to a single thread. A background thread keeps registering
+// new tools during the run to show registration never stalls invocations.
+//
+// A second run sends a herd of identical invocations of a slow tool from
+// --herd-callers threads, with and without single-flight coalescing, and
+// counts how often the tool actually executed.
+//
+// Usage: tool_manager_bench [--max-threads N] [--work-ns NS] [--seconds S]
+//                           [--herd-callers N] [--herd-work-us US]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "server/tool_manager.h"
+
+namespace {
+
+struct Options {
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    long work_ns = 2000;
+    double seconds = 1.0;
+    int herd_callers = 32;
+    long herd_work_us = 1000;
+};
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--max-threads") == 0) {
+            options.max_threads = static_cast<unsigned>(std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--work-ns") == 0) {
+            options.work_ns = std::atol(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--seconds") == 0) {
+            options.seconds = std::atof(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--herd-callers") == 0) {
+            options.herd_callers = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--herd-work-us") == 0) {
+            options.herd_work_us = std::atol(argv[i + 1]);
+        }
+    }
+    return options;
+}
+
+// Busy-wait so the tool burns CPU like a real computation would
+std::string SpinFor(long work_ns) {
+    auto until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(work_ns);
+    while (std::chrono::steady_clock::now() < until) {
+    }
+    return "done";
+}
+
+double RunInvocations(gmcp::ToolManager& manager, unsigned threads, double seconds) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> total{0};
+    std::vector<std::thread> workers;
+
+    gmcp::ToolInvocation invocation;
+    invocation.set_tool_id("spin");
+    invocation.set_request_id("bench");
+    (*invocation.mutable_arguments())["input"] = "value";
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            uint64_t calls = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                manager.InvokeTool(invocation);
+                ++calls;
+            }
+            total.fetch_add(calls);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(total.load()) / elapsed;
+}
+
+struct HerdReport {
+    uint64_t executions;
+    uint64_t coalesced;
+    double seconds;
+};
+
+// `callers` threads invoke the same slow tool with the same arguments in
+// rounds, all released at once
+HerdReport RunHerd(bool coalesce, int callers, long work_us, double seconds) {
+    gmcp::ToolManager::Options manager_options;
+    manager_options.coalesce = coalesce;
+    gmcp::ToolManager manager(manager_options);
+    std::atomic<uint64_t> executions{0};
+    gmcp::ToolRegistration slow;
+    slow.set_tool_id("slow");
+    manager.RegisterTool(slow, [&executions, work_us](const std::map<std::string, std::string>&) {
+        executions.fetch_add(1);
+        return SpinFor(work_us * 1000);
+    });
+
+    gmcp::ToolInvocation invocation;
+    invocation.set_tool_id("slow");
+    (*invocation.mutable_arguments())["input"] = "value";
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < callers; ++t) {
+        workers.emplace_back([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                manager.InvokeTool(invocation);
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return {executions.load(), manager.coalesced_count(), elapsed};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options = ParseOptions(argc, argv);
+
+    gmcp::ToolManager manager;
+    gmcp::ToolRegistration spin;
+    spin.set_tool_id("spin");
+    spin.set_name("Spin");
+    long work_ns = options.work_ns;
+    manager.RegisterTool(spin, [work_ns](const std::map<std::string, std::string>&) {
+        return SpinFor(work_ns);
+    });
+
+    // Registration churn running alongside the invocations
+    std::atomic<bool> stop_churn{false};
+    std::atomic<uint64_t> registrations{0};
+    std::thread churn([&] {
+        while (!stop_churn.load(std::memory_order_relaxed)) {
+            gmcp::ToolRegistration tool;
+            tool.set_tool_id("churn_" + std::to_string(registrations.load() % 256));
+            manager.RegisterTool(tool, [](const std::map<std::string, std::string>&) {
+                return std::string();
+            });
+            registrations.fetch_add(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    std::printf("ToolManager::InvokeTool contention (work=%ldns, %.1fs per step)\n",
+                options.work_ns, options.seconds);
+    std::printf("%8s %16s %10s\n", "threads", "invocations/s", "speedup");
+
+    std::vector<unsigned> steps;
+    for (unsigned threads = 1; threads < options.max_threads; threads *= 2) {
+        steps.push_back(threads);
+    }
+    steps.push_back(options.max_threads);
+
+    double baseline = 0.0;
+    for (unsigned threads : steps) {
+        double rate = RunInvocations(manager, threads, options.seconds);
+        if (threads == 1) {
+            baseline = rate;
+        }
+        std::printf("%8u %16.0f %9.2fx\n", threads, rate, rate / baseline);
+    }
+
+    stop_churn = true;
+    churn.join();
+    std::printf("Registration attempts during run: %llu\n",
+                static_cast<unsigned long long>(registrations.load()));
+
+    std::printf("\nIdentical invocations of a %ldus tool from %d threads (%.1fs each)\n",
+                options.herd_work_us, options.herd_callers, options.seconds);
+    std::printf("%-10s %12s %12s %14s\n", "coalesce", "executions", "coalesced", "answers/s");
+    for (bool coalesce : {false, true}) {
+        HerdReport report =
+            RunHerd(coalesce, options.herd_callers, options.herd_work_us, options.seconds);
+        std::printf("%-10s %12llu %12llu %14.0f\n", coalesce ? "on" : "off",
+                    static_cast<unsigned long long>(report.executions),
+                    static_cast<unsigned long long>(report.coalesced),
+                    (report.executions + report.coalesced) / report.seconds);
+    }
+    return 0;
+}
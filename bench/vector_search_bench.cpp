@@ -0,0 +1,193 @@
+// Recall and latency benchmark for VECTOR_STORE similarity search.
+//
+// Loads N vectors into a VectorStore, then runs the same queries exactly
+// (SIMD scan) and through the HNSW graph at several ef_search values,
+// reporting per-query latency percentiles and recall@k against the exact
+// results. Vectors and queries are drawn around random cluster centers, like
+// real embeddings; --clusters 0 draws them independently, which is the worst
+// case for any ANN index.
+//
+// Usage: vector_search_bench [--vectors N] [--dim D] [--queries Q] [--k K]
+//                            [--clusters C] [--metric cosine|l2|dot]
+//                            [--hnsw-m M] [--ef-construction EF]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "server/vector_kernels.h"
+#include "server/vector_store.h"
+
+namespace {
+
+struct Options {
+    size_t vectors = 1000000;
+    size_t dim = 128;
+    size_t queries = 200;
+    int k = 10;
+    size_t clusters = 1000;
+    std::string metric = "cosine";
+    size_t hnsw_m = 16;
+    size_t ef_construction = 200;
+};
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--vectors") == 0) {
+            options.vectors = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--dim") == 0) {
+            options.dim = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--queries") == 0) {
+            options.queries = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--k") == 0) {
+            options.k = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--clusters") == 0) {
+            options.clusters = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--metric") == 0) {
+            options.metric = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--hnsw-m") == 0) {
+            options.hnsw_m = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--ef-construction") == 0) {
+            options.ef_construction = std::strtoull(argv[i + 1], nullptr, 10);
+        }
+    }
+    return options;
+}
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double Percentile(std::vector<double> values, double p) {
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+    return values[index];
+}
+
+struct Run {
+    std::vector<std::vector<std::string>> keys;
+    std::vector<double> latency_us;
+};
+
+Run RunQueries(const gmcp::VectorStore& store, const std::vector<gmcp::MemoryQuery>& queries) {
+    Run run;
+    for (const auto& query : queries) {
+        auto start = std::chrono::steady_clock::now();
+        gmcp::MemoryResult result;
+        store.Query(query, &result);
+        run.latency_us.push_back(Seconds(start) * 1e6);
+
+        std::vector<std::string> keys;
+        for (const auto& entry : result.entries()) {
+            keys.push_back(entry.key());
+        }
+        run.keys.push_back(std::move(keys));
+    }
+    return run;
+}
+
+double Recall(const Run& exact, const Run& approximate) {
+    size_t found = 0;
+    size_t total = 0;
+    for (size_t i = 0; i < exact.keys.size(); ++i) {
+        std::set<std::string> truth(exact.keys[i].begin(), exact.keys[i].end());
+        for (const auto& key : approximate.keys[i]) {
+            found += truth.count(key);
+        }
+        total += truth.size();
+    }
+    return total == 0 ? 0.0 : static_cast<double>(found) / total;
+}
+
+void Report(const char* name, const Run& run, double recall) {
+    std::printf("%-14s %10.1f %10.1f %10.1f %9.4f\n", name, Percentile(run.latency_us, 0.5),
+                Percentile(run.latency_us, 0.99), 1e6 / Percentile(run.latency_us, 0.5), recall);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options = ParseOptions(argc, argv);
+    options.dim = std::max<size_t>(options.dim, 1);
+    options.queries = std::max<size_t>(options.queries, 1);
+
+    gmcp::VectorStore::Options store_options;
+    store_options.dimension = options.dim;
+    if (options.metric == "l2") {
+        store_options.metric = gmcp::VectorMetric::kL2;
+    } else if (options.metric == "dot") {
+        store_options.metric = gmcp::VectorMetric::kDot;
+    }
+    store_options.hnsw_options.m = options.hnsw_m;
+    store_options.hnsw_options.ef_construction = options.ef_construction;
+    gmcp::VectorStore store(store_options);
+
+    std::mt19937 rng(1234);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::vector<std::vector<float>> centers(options.clusters, std::vector<float>(options.dim));
+    for (auto& center : centers) {
+        for (auto& value : center) {
+            value = normal(rng);
+        }
+    }
+    std::uniform_int_distribution<size_t> pick(0, std::max<size_t>(options.clusters, 1) - 1);
+    constexpr float kClusterSpread = 0.3f;
+    auto random_vector = [&](auto* field) {
+        const std::vector<float>* center = centers.empty() ? nullptr : &centers[pick(rng)];
+        for (size_t d = 0; d < options.dim; ++d) {
+            field->Add(center ? (*center)[d] + kClusterSpread * normal(rng) : normal(rng));
+        }
+    };
+
+    std::printf("VECTOR_STORE search: %zu vectors x %zu dims, %zu clusters, metric=%s, "
+                "kernels=%s\n",
+                options.vectors, options.dim, options.clusters, options.metric.c_str(),
+                gmcp::VectorKernelImplementation());
+
+    auto build_start = std::chrono::steady_clock::now();
+    constexpr size_t kBatch = 10000;
+    for (size_t loaded = 0; loaded < options.vectors; loaded += kBatch) {
+        std::vector<gmcp::MemoryEntry> batch(std::min(kBatch, options.vectors - loaded));
+        for (size_t i = 0; i < batch.size(); ++i) {
+            batch[i].set_key("vec_" + std::to_string(loaded + i));
+            random_vector(batch[i].mutable_embedding());
+        }
+        store.PutBatch(std::move(batch));
+    }
+    double build_seconds = Seconds(build_start);
+    std::printf("Loaded and indexed in %.1fs (%.0f vectors/s)\n\n", build_seconds,
+                options.vectors / build_seconds);
+
+    std::vector<gmcp::MemoryQuery> queries(options.queries);
+    for (auto& query : queries) {
+        query.set_query_type(gmcp::QueryType::SEARCH);
+        query.set_limit(options.k);
+        random_vector(query.mutable_query_embedding());
+    }
+
+    std::printf("%-14s %10s %10s %10s %9s\n", "search", "p50 us", "p99 us", "qps@p50",
+                "recall@k");
+
+    for (auto& query : queries) {
+        (*query.mutable_filters())["exact"] = "true";
+    }
+    Run exact = RunQueries(store, queries);
+    Report("exact", exact, 1.0);
+
+    for (size_t ef : {16, 32, 64, 128, 256, 512}) {
+        for (auto& query : queries) {
+            query.mutable_filters()->erase("exact");
+            (*query.mutable_filters())["ef_search"] = std::to_string(ef);
+        }
+        Run approximate = RunQueries(store, queries);
+        std::string name = "hnsw ef=" + std::to_string(ef);
+        Report(name.c_str(), approximate, Recall(exact, approximate));
+    }
+    return 0;
+}
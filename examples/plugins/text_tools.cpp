@@ -0,0 +1,79 @@
+// Example native tool plugin.
+//
+//   word_count  Counts the words of `text` (cacheable)
+//   sleep       Waits `ms` milliseconds, stopping early when cancelled
+//
+// Build it with the server (target gmcp_text_tools) and start the server
+// with --plugin-dir pointing at a directory holding the .so file.
+
+#include <cctype>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "tool_plugin.h"
+
+namespace {
+
+std::string_view Argument(const gmcp_argument* arguments, size_t count, const char* key) {
+    const gmcp_string_view* value = gmcp_find_argument(arguments, count, key);
+    return value ? std::string_view(value->data, value->size) : std::string_view();
+}
+
+void Fail(gmcp_call* call, std::string_view message) {
+    call->fail(call, message.data(), message.size());
+}
+
+void WordCount(void*, const gmcp_argument* arguments, size_t count, gmcp_call* call) {
+    std::string_view text = Argument(arguments, count, "text");
+    size_t words = 0;
+    bool in_word = false;
+    for (char c : text) {
+        bool space = std::isspace(static_cast<unsigned char>(c)) != 0;
+        words += !space && !in_word;
+        in_word = !space;
+    }
+    std::string result = std::to_string(words);
+    call->write(call, result.data(), result.size());
+}
+
+void Sleep(void*, const gmcp_argument* arguments, size_t count, gmcp_call* call) {
+    std::string ms(Argument(arguments, count, "ms"));
+    if (ms.empty() || ms.find_first_not_of("0123456789") != std::string::npos) {
+        Fail(call, "ms must be a non-negative integer");
+        return;
+    }
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::stoll(ms));
+    while (std::chrono::steady_clock::now() < end) {
+        if (call->cancelled(call)) {
+            Fail(call, "cancelled");
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    call->write(call, "slept", 5);
+}
+
+const gmcp_tool_parameter kWordCountParameters[] = {
+    {"text", "string", 1, "Text to count the words of"},
+};
+
+const gmcp_tool_parameter kSleepParameters[] = {
+    {"ms", "number", 1, "Milliseconds to wait"},
+};
+
+const gmcp_tool_descriptor kTools[] = {
+    {"word_count", "Word count", "Counts whitespace-separated words", "number",
+     kWordCountParameters, 1, /*cacheable=*/1, /*cache_ttl_ms=*/0, /*max_concurrency=*/0,
+     WordCount, nullptr},
+    {"sleep", "Sleep", "Waits for a while; honours cancellation", "string", kSleepParameters,
+     1, /*cacheable=*/0, /*cache_ttl_ms=*/0, /*max_concurrency=*/4, Sleep, nullptr},
+};
+
+const gmcp_plugin kPlugin = {GMCP_PLUGIN_ABI_VERSION, kTools, sizeof(kTools) / sizeof(kTools[0])};
+
+} // namespace
+
+extern "C" GMCP_PLUGIN_EXPORT const gmcp_plugin* gmcp_plugin_describe(void) {
+    return &kPlugin;
+}
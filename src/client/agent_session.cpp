@@ -0,0 +1,287 @@
+#include "agent_session.h"
+#include <chrono>
+#include <vector>
+#include "common/logging.h"
+
+namespace gmcp {
+
+namespace {
+
+// Fallback for messages nobody waits for; one line per message, built only
+// when debug logging is on
+void LogMessage(const AgentMessage& message) {
+    switch (message.type()) {
+        case MessageType::TOOL_RESULT: {
+            const auto& result = message.tool_result();
+            GMCP_LOG(kDebug) << "Tool result from " << message.agent_id() << " ["
+                             << message.request_id() << "]: "
+                             << (result.success() ? result.result() : result.error_message())
+                             << " (" << result.execution_time_ms() << " ms)";
+            break;
+        }
+
+        case MessageType::MEMORY_RESULT: {
+            const auto& result = message.memory_result();
+            GMCP_LOG(kDebug) << "Memory result from " << message.agent_id() << " ["
+                             << message.request_id() << "]: " << result.entries_size() << " of "
+                             << result.total_count() << " entries";
+            for (const auto& entry : result.entries()) {
+                GMCP_LOG(kDebug) << "  " << entry.key() << " = " << entry.value();
+            }
+            break;
+        }
+
+        case MessageType::TEXT:
+            GMCP_LOG(kDebug) << "Text from " << message.agent_id() << ": "
+                             << message.text_message();
+            break;
+
+        default:
+            GMCP_LOG(kWarning) << "Unknown message type " << message.type();
+            break;
+    }
+}
+
+// Why the server would not reply to a message, or null if it would
+const char* Unanswerable(const AgentMessage& message) {
+    switch (message.type()) {
+        case MessageType::TEXT:
+            return nullptr;
+        case MessageType::TOOL_INVOCATION:
+            return message.has_tool_invocation() ? nullptr
+                                                 : "TOOL_INVOCATION without a tool_invocation";
+        case MessageType::MEMORY_QUERY:
+            return message.has_memory_query() ? nullptr : "MEMORY_QUERY without a memory_query";
+        default:
+            return "the server only answers TEXT, TOOL_INVOCATION and MEMORY_QUERY";
+    }
+}
+
+} // namespace
+
+AgentSession::AgentSession(AgentCoordination::Stub* stub, const std::string& agent_id)
+    : AgentSession(stub, agent_id, Options()) {
+}
+
+AgentSession::AgentSession(AgentCoordination::Stub* stub, const std::string& agent_id,
+                           const Options& options)
+    : options_(options), agent_id_(agent_id) {
+    stream_ = stub->StreamAgentMessages(&context_);
+    receive_thread_ = std::thread(&AgentSession::Receive, this);
+    if (options_.request_timeout.count() > 0) {
+        timer_thread_ = std::thread(&AgentSession::ExpireRequests, this);
+    }
+}
+
+AgentSession::~AgentSession() {
+    Close();
+}
+
+std::string AgentSession::NextRequestId() {
+    return options_.request_id_prefix +
+           std::to_string(next_request_.fetch_add(1, std::memory_order_relaxed) + 1);
+}
+
+void AgentSession::Request(AgentMessage message, Callback done) {
+    // No reply would ever complete it, and it would hold a slot until the
+    // session ends
+    if (const char* reason = Unanswerable(message)) {
+        done(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                          std::string("Request gets no reply: ") + reason),
+             AgentMessage());
+        return;
+    }
+    if (message.request_id().empty()) {
+        message.set_request_id(message.has_tool_invocation() &&
+                                       !message.tool_invocation().request_id().empty()
+                                   ? message.tool_invocation().request_id()
+                                   : NextRequestId());
+    }
+    if (message.agent_id().empty()) {
+        message.set_agent_id(agent_id_);
+    }
+    if (message.timestamp() == 0) {
+        message.set_timestamp(std::chrono::system_clock::now().time_since_epoch().count());
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // The receive and timer threads free the window, so a callback
+        // sending a follow-up request must not wait for it
+        std::thread::id caller = std::this_thread::get_id();
+        if (options_.max_in_flight > 0 && caller != receive_thread_.get_id() &&
+            caller != timer_thread_.get_id()) {
+            window_cv_.wait(lock, [this] {
+                return closing_ || finished_ || pending_.size() < options_.max_in_flight;
+            });
+        }
+        if (closing_ || finished_) {
+            lock.unlock();
+            done(grpc::Status(grpc::StatusCode::UNAVAILABLE, "Session is closed"), AgentMessage());
+            return;
+        }
+        uint64_t serial = ++next_serial_;
+        if (!pending_.try_emplace(message.request_id(), Pending{std::move(done), serial}).second) {
+            lock.unlock();
+            done(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                              "Request id already in flight: " + message.request_id()),
+                 AgentMessage());
+            return;
+        }
+        if (options_.request_timeout.count() > 0) {
+            deadlines_.push_back(
+                {Clock::now() + options_.request_timeout, message.request_id(), serial});
+            if (deadlines_.size() == 1) {
+                timer_cv_.notify_one();
+            }
+        }
+    }
+
+    // A failed write means the stream broke; the receive thread then fails
+    // every pending request, this one included
+    Write(message);
+}
+
+std::future<AgentSession::Reply> AgentSession::Request(AgentMessage message) {
+    auto promise = std::make_shared<std::promise<Reply>>();
+    auto future = promise->get_future();
+    Request(std::move(message), [promise](const grpc::Status& status, AgentMessage&& reply) {
+        promise->set_value({status, std::move(reply)});
+    });
+    return future;
+}
+
+bool AgentSession::Send(const AgentMessage& message) {
+    return Write(message);
+}
+
+bool AgentSession::Write(const AgentMessage& message) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (writes_closed_) {
+        return false;
+    }
+    return stream_->Write(message);
+}
+
+grpc::Status AgentSession::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    window_cv_.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        if (!writes_closed_) {
+            writes_closed_ = true;
+            stream_->WritesDone();
+        }
+    }
+    if (receive_thread_.joinable()) {
+        receive_thread_.join();
+    }
+    if (timer_thread_.joinable()) {
+        timer_thread_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+void AgentSession::Cancel() {
+    context_.TryCancel();
+}
+
+size_t AgentSession::in_flight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+void AgentSession::Receive() {
+    while (true) {
+        AgentMessage message;
+        if (!stream_->Read(&message)) {
+            break;
+        }
+        Callback done;
+        if (!message.request_id().empty()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = pending_.find(message.request_id());
+            if (it != pending_.end()) {
+                done = std::move(it->second.done);
+                pending_.erase(it);
+            }
+        }
+        if (done) {
+            window_cv_.notify_one();
+            done(grpc::Status::OK, std::move(message));
+        } else if (options_.on_unmatched) {
+            options_.on_unmatched(std::move(message));
+        } else {
+            LogMessage(message);
+        }
+    }
+
+    // No write may overlap Finish
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        writes_closed_ = true;
+    }
+    grpc::Status status = stream_->Finish();
+    if (!status.ok() && status.error_code() != grpc::StatusCode::CANCELLED) {
+        GMCP_LOG(kWarning) << "Agent stream ended: " << status.error_message();
+    }
+
+    std::unordered_map<std::string, Pending> unanswered;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+        status_ = status;
+        unanswered.swap(pending_);
+        deadlines_.clear();
+    }
+    window_cv_.notify_all();
+    timer_cv_.notify_all();
+    grpc::Status failure =
+        status.ok() ? grpc::Status(grpc::StatusCode::UNAVAILABLE, "Stream ended before the reply")
+                    : status;
+    for (auto& [request_id, pending] : unanswered) {
+        pending.done(failure, AgentMessage());
+    }
+}
+
+void AgentSession::ExpireRequests() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!finished_) {
+        if (deadlines_.empty()) {
+            timer_cv_.wait(lock);
+            continue;
+        }
+        Clock::time_point now = Clock::now();
+        if (deadlines_.front().at > now) {
+            timer_cv_.wait_until(lock, deadlines_.front().at);
+            continue;
+        }
+        std::vector<Callback> expired;
+        while (!deadlines_.empty() && deadlines_.front().at <= now) {
+            const Deadline& deadline = deadlines_.front();
+            auto it = pending_.find(deadline.request_id);
+            if (it != pending_.end() && it->second.serial == deadline.serial) {
+                expired.push_back(std::move(it->second.done));
+                pending_.erase(it);
+            }
+            deadlines_.pop_front();
+        }
+        if (expired.empty()) {
+            continue;
+        }
+        lock.unlock();
+        window_cv_.notify_all();
+        for (auto& done : expired) {
+            done(grpc::Status(grpc::StatusCode::DEADLINE_EXCEEDED,
+                              "No reply within the request timeout"),
+                 AgentMessage());
+        }
+        lock.lock();
+    }
+}
+
+} // namespace gmcp
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <grpcpp/grpcpp.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "gmcp.grpc.pb.h"
+
+namespace gmcp {
+
+// One long-lived StreamAgentMessages stream carrying many concurrent
+// requests. Each request is tagged with a request_id, and the reply that
+// echoes it completes that request's callback or future, whatever order the
+// server answers in.
+//
+// At most `max_in_flight` requests wait for replies at once; further
+// Request() calls block until one completes, so a fast sender cannot queue
+// unbounded work on the server. Callbacks run on the session's receive
+// thread (or its timer thread, for requests that time out): keep them short
+// and do not wait on other requests of the same session in them.
+class AgentSession {
+public:
+    struct Options {
+        // Requests awaiting a reply at once (0 = unbounded). Matches the
+        // server's default --stream-window.
+        size_t max_in_flight = 64;
+        // A request without a reply this long after it was sent fails with
+        // DEADLINE_EXCEEDED and frees its slot; a reply arriving later goes
+        // to on_unmatched (0 = wait until the session ends)
+        std::chrono::milliseconds request_timeout{0};
+        // Prepended to the counter that numbers requests without an id
+        std::string request_id_prefix = "req_";
+        // Receives messages that match no pending request, such as replies
+        // to Send(). Logged at debug when unset.
+        std::function<void(AgentMessage&&)> on_unmatched;
+    };
+
+    struct Reply {
+        grpc::Status status;
+        AgentMessage message;
+    };
+
+    // `status` is OK when the reply arrived; tool failures are reported in
+    // the reply itself. Otherwise it is the stream's error, or UNAVAILABLE
+    // when the session closed first.
+    using Callback = std::function<void(const grpc::Status&, AgentMessage&&)>;
+
+    AgentSession(AgentCoordination::Stub* stub, const std::string& agent_id);
+    AgentSession(AgentCoordination::Stub* stub, const std::string& agent_id,
+                 const Options& options);
+    // Closes the stream
+    ~AgentSession();
+
+    AgentSession(const AgentSession&) = delete;
+    AgentSession& operator=(const AgentSession&) = delete;
+
+    // Send `message` and complete `done` with its reply. Fills in the
+    // agent_id, timestamp and request_id when unset; a tool invocation's own
+    // request_id is used when the message has none. Fails with
+    // INVALID_ARGUMENT, without sending, if the request_id is already in
+    // flight or the server would not answer the message: only TEXT, and
+    // TOOL_INVOCATION or MEMORY_QUERY carrying their payload, get replies.
+    void Request(AgentMessage message, Callback done);
+    std::future<Reply> Request(AgentMessage message);
+
+    // Send without waiting for a reply; the reply goes to on_unmatched
+    bool Send(const AgentMessage& message);
+
+    // Next request id: the prefix and a per-session counter
+    std::string NextRequestId();
+
+    // Stop sending and wait for the server to answer everything in flight.
+    // Requests it leaves unanswered fail. Returns the stream's status.
+    grpc::Status Close();
+
+    // Abort the stream; pending requests fail with CANCELLED
+    void Cancel();
+
+    // Requests awaiting a reply
+    size_t in_flight() const;
+
+    const std::string& agent_id() const { return agent_id_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        Callback done;
+        // Tells a request apart from a later one reusing its id
+        uint64_t serial;
+    };
+
+    struct Deadline {
+        Clock::time_point at;
+        std::string request_id;
+        uint64_t serial;
+    };
+
+    bool Write(const AgentMessage& message);
+    void Receive();
+    // Fail requests whose timeout passed; runs on timer_thread_
+    void ExpireRequests();
+
+    const Options options_;
+    const std::string agent_id_;
+    grpc::ClientContext context_;
+    std::unique_ptr<grpc::ClientReaderWriter<AgentMessage, AgentMessage>> stream_;
+    std::atomic<uint64_t> next_request_{0};
+
+    // Serializes writes; also guards the end of writing
+    std::mutex write_mutex_;
+    bool writes_closed_ = false;
+
+    mutable std::mutex mutex_;
+    // Signalled when a request completes or the session ends
+    std::condition_variable window_cv_;
+    std::unordered_map<std::string, Pending> pending_;
+    uint64_t next_serial_ = 0;
+    // Every request has the same timeout, so deadlines are in send order;
+    // entries of requests already answered are skipped when they come due
+    std::deque<Deadline> deadlines_;
+    std::condition_variable timer_cv_;
+    bool closing_ = false;
+    bool finished_ = false;
+    grpc::Status status_;
+
+    std::thread receive_thread_;
+    std::thread timer_thread_;
+};
+
+} // namespace gmcp
@@ -0,0 +1,252 @@
+#include "async_agent_client.h"
+#include <algorithm>
+
+namespace gmcp {
+
+namespace {
+
+// Client whose completions the current thread drains, if any
+thread_local const AsyncAgentClient* draining = nullptr;
+
+} // namespace
+
+// One RPC in flight; its address is the completion queue tag
+class AsyncAgentClient::Call {
+public:
+    virtual ~Call() = default;
+
+    // Hand the outcome to the caller; runs on a completion thread
+    virtual void Complete() = 0;
+
+    grpc::ClientContext context;
+    grpc::Status status;
+    Connection* connection = nullptr;
+};
+
+template <typename Response>
+class AsyncAgentClient::TypedCall final : public Call {
+public:
+    explicit TypedCall(Callback<Response> done) : done_(std::move(done)) {}
+
+    void Complete() override { done_(status, std::move(response)); }
+
+    Response response;
+    std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> reader;
+
+private:
+    Callback<Response> done_;
+};
+
+namespace {
+
+template <typename Response>
+std::pair<std::future<AsyncAgentClient::Reply<Response>>, AsyncAgentClient::Callback<Response>>
+MakeFuture() {
+    auto promise = std::make_shared<std::promise<AsyncAgentClient::Reply<Response>>>();
+    auto future = promise->get_future();
+    return {std::move(future), [promise](const grpc::Status& status, Response&& response) {
+                promise->set_value({status, std::move(response)});
+            }};
+}
+
+} // namespace
+
+AsyncAgentClient::AsyncAgentClient(const std::string& address)
+    : AsyncAgentClient(address, Options()) {
+}
+
+AsyncAgentClient::AsyncAgentClient(const std::string& address, const Options& options)
+    : options_(options) {
+    size_t channels = std::max<size_t>(options_.channels, 1);
+    size_t threads = options_.completion_threads;
+    if (threads == 0) {
+        threads = std::min<size_t>(channels, std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    for (size_t i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<grpc::CompletionQueue>());
+    }
+    for (size_t i = 0; i < channels; ++i) {
+        // A local subchannel pool makes each channel its own connection
+        grpc::ChannelArguments arguments;
+        arguments.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+        auto connection = std::make_unique<Connection>();
+        connection->channel =
+            grpc::CreateCustomChannel(address, grpc::InsecureChannelCredentials(), arguments);
+        connection->stub = AgentCoordination::NewStub(connection->channel);
+        connection->queue = queues_[i % threads].get();
+        connections_.push_back(std::move(connection));
+    }
+    for (auto& queue : queues_) {
+        threads_.emplace_back([this, queue = queue.get()] { Drain(queue); });
+    }
+}
+
+AsyncAgentClient::~AsyncAgentClient() {
+    {
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        ++waiters_;
+        idle_cv_.wait(lock, [this] { return in_flight_.load() == 0; });
+        --waiters_;
+    }
+    for (auto& queue : queues_) {
+        queue->Shutdown();
+    }
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+bool AsyncAgentClient::WaitForConnected(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::system_clock::now() + timeout;
+    for (auto& connection : connections_) {
+        if (!connection->channel->WaitForConnected(deadline)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string AsyncAgentClient::NextRequestId() {
+    return options_.request_id_prefix +
+           std::to_string(next_request_.fetch_add(1, std::memory_order_relaxed) + 1);
+}
+
+AsyncAgentClient::Connection& AsyncAgentClient::PickConnection() {
+    if (options_.balancing == Balancing::kRoundRobin || connections_.size() == 1) {
+        size_t next = next_connection_.fetch_add(1, std::memory_order_relaxed);
+        return *connections_[next % connections_.size()];
+    }
+    // Start the scan at a rotating offset so ties spread evenly
+    size_t start = next_connection_.fetch_add(1, std::memory_order_relaxed);
+    Connection* best = nullptr;
+    int64_t best_load = 0;
+    for (size_t i = 0; i < connections_.size(); ++i) {
+        Connection* connection = connections_[(start + i) % connections_.size()].get();
+        int64_t load = connection->in_flight.load(std::memory_order_relaxed);
+        if (!best || load < best_load) {
+            best = connection;
+            best_load = load;
+        }
+    }
+    return *best;
+}
+
+void AsyncAgentClient::Admit() {
+    // Only completion threads free capacity, so a callback issuing a
+    // follow-up call must not wait for it
+    if (options_.max_in_flight == 0 || draining == this) {
+        in_flight_.fetch_add(1);
+        return;
+    }
+    size_t current = in_flight_.load();
+    while (true) {
+        if (current < options_.max_in_flight) {
+            if (in_flight_.compare_exchange_weak(current, current + 1)) {
+                return;
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        ++waiters_;
+        idle_cv_.wait(lock, [&] {
+            current = in_flight_.load();
+            return current < options_.max_in_flight;
+        });
+        --waiters_;
+    }
+}
+
+template <typename Request, typename Response, typename Prepare>
+void AsyncAgentClient::Start(const Request& request, Prepare prepare,
+                             Callback<Response> done) {
+    Admit();
+    Connection& connection = PickConnection();
+    auto* call = new TypedCall<Response>(std::move(done));
+    call->connection = &connection;
+    if (options_.timeout.count() > 0) {
+        call->context.set_deadline(std::chrono::system_clock::now() + options_.timeout);
+    }
+    connection.in_flight.fetch_add(1, std::memory_order_relaxed);
+    call->reader = prepare(connection.stub.get(), &call->context, request, connection.queue);
+    call->reader->StartCall();
+    call->reader->Finish(&call->response, &call->status, call);
+}
+
+void AsyncAgentClient::Drain(grpc::CompletionQueue* queue) {
+    draining = this;
+    void* tag = nullptr;
+    bool ok = false;
+    while (queue->Next(&tag, &ok)) {
+        auto* call = static_cast<Call*>(tag);
+        call->connection->in_flight.fetch_sub(1, std::memory_order_relaxed);
+        call->Complete();
+        delete call;
+        in_flight_.fetch_sub(1);
+        // Waiters register before re-checking the count, so one that this
+        // load misses sees the decrement instead
+        if (waiters_ > 0) {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            idle_cv_.notify_all();
+        }
+    }
+}
+
+void AsyncAgentClient::InvokeTool(ToolInvocation invocation, Callback<ToolResult> done) {
+    if (invocation.request_id().empty()) {
+        invocation.set_request_id(NextRequestId());
+    }
+    Start<ToolInvocation, ToolResult>(
+        invocation,
+        [](AgentCoordination::Stub* stub, grpc::ClientContext* context,
+           const ToolInvocation& request, grpc::CompletionQueue* queue) {
+            return stub->PrepareAsyncInvokeTool(context, request, queue);
+        },
+        std::move(done));
+}
+
+std::future<AsyncAgentClient::Reply<ToolResult>> AsyncAgentClient::InvokeTool(
+    ToolInvocation invocation) {
+    auto [future, done] = MakeFuture<ToolResult>();
+    InvokeTool(std::move(invocation), std::move(done));
+    return std::move(future);
+}
+
+void AsyncAgentClient::QueryMemory(const MemoryQuery& query, Callback<MemoryResult> done) {
+    Start<MemoryQuery, MemoryResult>(
+        query,
+        [](AgentCoordination::Stub* stub, grpc::ClientContext* context,
+           const MemoryQuery& request, grpc::CompletionQueue* queue) {
+            return stub->PrepareAsyncQueryMemory(context, request, queue);
+        },
+        std::move(done));
+}
+
+std::future<AsyncAgentClient::Reply<MemoryResult>> AsyncAgentClient::QueryMemory(
+    const MemoryQuery& query) {
+    auto [future, done] = MakeFuture<MemoryResult>();
+    QueryMemory(query, std::move(done));
+    return std::move(future);
+}
+
+void AsyncAgentClient::StoreMemory(const MemoryWrite& write, Callback<StoreResponse> done) {
+    Start<MemoryWrite, StoreResponse>(
+        write,
+        [](AgentCoordination::Stub* stub, grpc::ClientContext* context,
+           const MemoryWrite& request, grpc::CompletionQueue* queue) {
+            return stub->PrepareAsyncStoreMemory(context, request, queue);
+        },
+        std::move(done));
+}
+
+void AsyncAgentClient::GetStats(Callback<StatsResponse> done) {
+    Start<StatsRequest, StatsResponse>(
+        StatsRequest(),
+        [](AgentCoordination::Stub* stub, grpc::ClientContext* context,
+           const StatsRequest& request, grpc::CompletionQueue* queue) {
+            return stub->PrepareAsyncGetStats(context, request, queue);
+        },
+        std::move(done));
+}
+
+} // namespace gmcp
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <grpcpp/grpcpp.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gmcp.grpc.pb.h"
+
+namespace gmcp {
+
+// Non-blocking client for the unary RPCs. Calls return immediately and
+// complete through a callback or a future, so one thread can keep any
+// number of requests in flight.
+//
+// Requests are spread over a pool of channels, each its own HTTP/2
+// connection, picked round-robin or by fewest calls in flight. Completions
+// are drained by a few threads, each polling its own CompletionQueue, and
+// callbacks run on those threads: keep them short and never block in them.
+class AsyncAgentClient {
+public:
+    enum class Balancing {
+        kRoundRobin,
+        // Channel with the fewest calls in flight
+        kLeastLoaded,
+    };
+
+    struct Options {
+        // Connections to the server
+        size_t channels = 4;
+        // Threads draining completions (0 = one per channel, at most one
+        // per core)
+        size_t completion_threads = 0;
+        Balancing balancing = Balancing::kLeastLoaded;
+        // Deadline of each call (0 = none)
+        std::chrono::milliseconds timeout{0};
+        // Calls in flight at once; further calls block until one completes
+        // (0 = unbounded). Calls made from a callback are never held, since
+        // blocking a completion thread could deadlock the client.
+        size_t max_in_flight = 0;
+        // Prepended to the counter that numbers requests without an id
+        std::string request_id_prefix = "req_";
+    };
+
+    template <typename Response>
+    struct Reply {
+        grpc::Status status;
+        Response response;
+    };
+
+    template <typename Response>
+    using Callback = std::function<void(const grpc::Status&, Response&&)>;
+
+    explicit AsyncAgentClient(const std::string& address);
+    AsyncAgentClient(const std::string& address, const Options& options);
+    // Waits for calls in flight to complete
+    ~AsyncAgentClient();
+
+    AsyncAgentClient(const AsyncAgentClient&) = delete;
+    AsyncAgentClient& operator=(const AsyncAgentClient&) = delete;
+
+    // Wait up to `timeout` for every channel to connect
+    bool WaitForConnected(std::chrono::milliseconds timeout);
+
+    // Invocations without a request_id get the next one from the counter
+    void InvokeTool(ToolInvocation invocation, Callback<ToolResult> done);
+    std::future<Reply<ToolResult>> InvokeTool(ToolInvocation invocation);
+
+    void QueryMemory(const MemoryQuery& query, Callback<MemoryResult> done);
+    std::future<Reply<MemoryResult>> QueryMemory(const MemoryQuery& query);
+
+    void StoreMemory(const MemoryWrite& write, Callback<StoreResponse> done);
+
+    void GetStats(Callback<StatsResponse> done);
+
+    // Next request id: the prefix and a per-client counter
+    std::string NextRequestId();
+
+    // Calls started but not yet completed
+    size_t in_flight() const { return in_flight_.load(std::memory_order_relaxed); }
+
+private:
+    struct Connection {
+        std::shared_ptr<grpc::Channel> channel;
+        std::unique_ptr<AgentCoordination::Stub> stub;
+        grpc::CompletionQueue* queue;
+        std::atomic<int64_t> in_flight{0};
+    };
+
+    class Call;
+    template <typename Response>
+    class TypedCall;
+
+    // Start an RPC; `prepare` calls the matching Stub::PrepareAsync* method
+    template <typename Request, typename Response, typename Prepare>
+    void Start(const Request& request, Prepare prepare, Callback<Response> done);
+
+    Connection& PickConnection();
+    void Admit();
+    void Drain(grpc::CompletionQueue* queue);
+
+    const Options options_;
+    std::vector<std::unique_ptr<grpc::CompletionQueue>> queues_;
+    std::vector<std::unique_ptr<Connection>> connections_;
+    std::atomic<size_t> next_connection_{0};
+    std::atomic<uint64_t> next_request_{0};
+
+    std::atomic<size_t> in_flight_{0};
+    std::mutex idle_mutex_;
+    // Signalled when a call completes while someone waits for capacity or
+    // for the client to go idle
+    std::condition_variable idle_cv_;
+    std::atomic<size_t> waiters_{0};
+
+    std::vector<std::thread> threads_;
+};
+
+} // namespace gmcp
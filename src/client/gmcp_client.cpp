@@ -1,11 +1,12 @@
 #include "gmcp_client.h"
-#include <iostream>
+#include <algorithm>
 #include <chrono>
+#include "common/logging.h"
 
 namespace gmcp {
 
 AgentClient::AgentClient(std::shared_ptr<grpc::Channel> channel)
-    : stub_(AgentCoordination::NewStub(channel)), streaming_(false) {
+    : stub_(AgentCoordination::NewStub(channel)) {
 }
 
 AgentClient::~AgentClient() {
@@ -19,10 +20,10 @@ bool AgentClient::RegisterTool(const ToolRegistration& tool) {
     grpc::Status status = stub_->RegisterTool(&context, tool, &response);
     
     if (status.ok()) {
-        std::cout << "Tool registration: " << response.message() << std::endl;
+        GMCP_LOG(kInfo) << "Tool registration: " << response.message();
         return response.success();
     } else {
-        std::cerr << "RPC failed: " << status.error_message() << std::endl;
+        GMCP_LOG(kError) << "RPC failed: " << status.error_message();
         return false;
     }
 }
@@ -34,10 +35,10 @@ bool AgentClient::RegisterMemory(const MemoryRegistration& memory) {
     grpc::Status status = stub_->RegisterMemory(&context, memory, &response);
     
     if (status.ok()) {
-        std::cout << "Memory registration: " << response.message() << std::endl;
+        GMCP_LOG(kInfo) << "Memory registration: " << response.message();
         return response.success();
     } else {
-        std::cerr << "RPC failed: " << status.error_message() << std::endl;
+        GMCP_LOG(kError) << "RPC failed: " << status.error_message();
         return false;
     }
 }
@@ -49,8 +50,8 @@ ToolResult AgentClient::InvokeTool(const std::string& tool_id,
     ToolResult result;
     
     invocation.set_tool_id(tool_id);
-    invocation.set_request_id("req_" + std::to_string(
-        std::chrono::system_clock::now().time_since_epoch().count()));
+    invocation.set_request_id(
+        "req_" + std::to_string(next_request_.fetch_add(1, std::memory_order_relaxed) + 1));
     
     for (const auto& [key, value] : args) {
         (*invocation.mutable_arguments())[key] = value;
@@ -59,7 +60,7 @@ ToolResult AgentClient::InvokeTool(const std::string& tool_id,
     grpc::Status status = stub_->InvokeTool(&context, invocation, &result);
     
     if (!status.ok()) {
-        std::cerr << "RPC failed: " << status.error_message() << std::endl;
+        GMCP_LOG(kError) << "RPC failed: " << status.error_message();
     }
     
     return result;
@@ -78,38 +79,171 @@ MemoryResult AgentClient::QueryMemory(const std::string& memory_id,
     mem_query.set_query(query);
     mem_query.set_limit(limit);
     
-    grpc::Status status = stub_->QueryMemory(&context, mem_query, &result);
+    return QueryMemory(mem_query);
+}
+
+MemoryResult AgentClient::QueryMemory(const MemoryQuery& query) {
+    grpc::ClientContext context;
+    MemoryResult result;
+    
+    grpc::Status status = stub_->QueryMemory(&context, query, &result);
     
     if (!status.ok()) {
-        std::cerr << "RPC failed: " << status.error_message() << std::endl;
+        GMCP_LOG(kError) << "RPC failed: " << status.error_message();
     }
     
     return result;
 }
 
+size_t AgentClient::StreamQueryMemory(const MemoryQuery& query,
+                                      const std::function<bool(const MemoryResult&)>& on_chunk) {
+    grpc::ClientContext context;
+    std::unique_ptr<grpc::ClientReader<MemoryResult>> reader(
+        stub_->StreamQueryMemory(&context, query));
+    
+    size_t received = 0;
+    MemoryResult chunk;
+    while (reader->Read(&chunk)) {
+        received += chunk.entries_size();
+        if (!on_chunk(chunk)) {
+            context.TryCancel();
+            break;
+        }
+    }
+    
+    grpc::Status status = reader->Finish();
+    if (!status.ok() && status.error_code() != grpc::StatusCode::CANCELLED) {
+        GMCP_LOG(kError) << "RPC failed: " << status.error_message();
+    }
+    
+    return received;
+}
+
+std::vector<ToolResult> AgentClient::InvokeToolBatch(
+    const std::vector<ToolInvocation>& invocations) {
+    grpc::ClientContext context;
+    ToolInvocationBatch batch;
+    ToolResultBatch response;
+    
+    for (const auto& invocation : invocations) {
+        *batch.add_invocations() = invocation;
+    }
+    
+    grpc::Status status = stub_->InvokeToolBatch(&context, batch, &response);
+    
+    if (!status.ok()) {
+        GMCP_LOG(kError) << "RPC failed: " << status.error_message();
+    }
+    
+    return {response.results().begin(), response.results().end()};
+}
+
+std::vector<MemoryResult> AgentClient::QueryMemoryBatch(const std::vector<MemoryQuery>& queries) {
+    grpc::ClientContext context;
+    MemoryQueryBatch batch;
+    MemoryResultBatch response;
+    
+    for (const auto& query : queries) {
+        *batch.add_queries() = query;
+    }
+    
+    grpc::Status status = stub_->QueryMemoryBatch(&context, batch, &response);
+    
+    if (!status.ok()) {
+        GMCP_LOG(kError) << "RPC failed: " << status.error_message();
+    }
+    
+    return {response.results().begin(), response.results().end()};
+}
+
+StatsResponse AgentClient::GetStats() {
+    grpc::ClientContext context;
+    StatsRequest request;
+    StatsResponse response;
+    
+    grpc::Status status = stub_->GetStats(&context, request, &response);
+    
+    if (!status.ok()) {
+        GMCP_LOG(kError) << "RPC failed: " << status.error_message();
+    }
+    
+    return response;
+}
+
+bool AgentClient::StoreMemory(const std::string& memory_id,
+                              const std::vector<MemoryEntry>& entries) {
+    grpc::ClientContext context;
+    MemoryWrite write;
+    StoreResponse response;
+    
+    write.set_memory_id(memory_id);
+    for (const auto& entry : entries) {
+        *write.add_entries() = entry;
+    }
+    
+    grpc::Status status = stub_->StoreMemory(&context, write, &response);
+    
+    if (!status.ok()) {
+        GMCP_LOG(kError) << "RPC failed: " << status.error_message();
+        return false;
+    }
+    
+    return response.success();
+}
+
+IngestSummary AgentClient::IngestMemory(const std::string& memory_id,
+                                        const std::vector<MemoryEntry>& entries,
+                                        size_t chunk_size) {
+    grpc::ClientContext context;
+    IngestSummary summary;
+    auto writer = stub_->IngestMemory(&context, &summary);
+    
+    chunk_size = std::max<size_t>(chunk_size, 1);
+    MemoryWrite write;
+    write.set_memory_id(memory_id);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        *write.add_entries() = entries[i];
+        if (write.entries_size() == static_cast<int>(chunk_size) || i + 1 == entries.size()) {
+            if (!writer->Write(write)) {
+                break;
+            }
+            write.clear_entries();
+        }
+    }
+    writer->WritesDone();
+    
+    grpc::Status status = writer->Finish();
+    
+    if (!status.ok()) {
+        GMCP_LOG(kError) << "RPC failed: " << status.error_message();
+    }
+    
+    return summary;
+}
+
+std::unique_ptr<AgentSession> AgentClient::OpenSession(const std::string& agent_id,
+                                                      const AgentSession::Options& options) {
+    return std::make_unique<AgentSession>(stub_.get(), agent_id, options);
+}
+
 void AgentClient::StartStreaming(const std::string& agent_id) {
-    if (streaming_) {
-        std::cout << "Already streaming" << std::endl;
+    if (session_) {
+        GMCP_LOG(kWarning) << "Already streaming";
         return;
     }
     
-    stream_context_ = std::make_unique<grpc::ClientContext>();
-    stream_ = stub_->StreamAgentMessages(stream_context_.get());
-    streaming_ = true;
-    
-    // Start receive thread
-    receive_thread_ = std::make_unique<std::thread>(&AgentClient::ReceiveMessages, this);
+    session_ = OpenSession(agent_id);
     
-    std::cout << "Started bidirectional streaming for agent: " << agent_id << std::endl;
+    GMCP_LOG(kInfo) << "Started bidirectional streaming for agent: " << agent_id;
 }
 
 bool AgentClient::SendMessage(const AgentMessage& message) {
-    if (!streaming_ || !stream_) {
-        std::cerr << "Not streaming" << std::endl;
+    if (!session_) {
+        GMCP_LOG(kError) << "Not streaming";
         return false;
     }
     
-    return stream_->Write(message);
+    return session_->Send(message);
 }
 
 void AgentClient::SubscribeEvents(const std::string& agent_id,
@@ -125,85 +259,32 @@ void AgentClient::SubscribeEvents(const std::string& agent_id,
     std::unique_ptr<grpc::ClientReader<Event>> reader(
         stub_->SubscribeEvents(&context, subscription));
     
-    std::cout << "Subscribed to events for agent: " << agent_id << std::endl;
+    GMCP_LOG(kInfo) << "Subscribed to events for agent: " << agent_id;
     
     Event event;
     while (reader->Read(&event)) {
-        std::cout << "Event received: " << event.event_type() 
-                  << " from " << event.source_agent_id() << std::endl;
+        GMCP_LOG(kDebug) << "Event received: " << event.event_type() << " from "
+                         << event.source_agent_id();
     }
     
     grpc::Status status = reader->Finish();
     if (!status.ok()) {
-        std::cerr << "Event subscription ended: " << status.error_message() << std::endl;
+        GMCP_LOG(kWarning) << "Event subscription ended: " << status.error_message();
     }
 }
 
 void AgentClient::StopStreaming() {
-    if (!streaming_) {
+    if (!session_) {
         return;
     }
     
-    streaming_ = false;
-    
-    if (stream_) {
-        stream_->WritesDone();
-    }
-    
-    if (receive_thread_ && receive_thread_->joinable()) {
-        receive_thread_->join();
-    }
-    
-    if (stream_) {
-        grpc::Status status = stream_->Finish();
-        if (!status.ok()) {
-            std::cerr << "Stream ended with error: " << status.error_message() << std::endl;
-        }
+    grpc::Status status = session_->Close();
+    session_.reset();
+    if (!status.ok()) {
+        GMCP_LOG(kError) << "Stream ended with error: " << status.error_message();
     }
     
-    std::cout << "Stopped streaming" << std::endl;
-}
-
-void AgentClient::ReceiveMessages() {
-    AgentMessage message;
-    while (streaming_ && stream_->Read(&message)) {
-        std::cout << "\n=== Received message from server ===" << std::endl;
-        std::cout << "Agent: " << message.agent_id() << std::endl;
-        std::cout << "Type: " << message.type() << std::endl;
-        
-        switch (message.type()) {
-            case MessageType::TOOL_RESULT:
-                if (message.has_tool_result()) {
-                    const auto& result = message.tool_result();
-                    std::cout << "Tool Result: " << std::endl;
-                    std::cout << "  Success: " << (result.success() ? "yes" : "no") << std::endl;
-                    std::cout << "  Result: " << result.result() << std::endl;
-                    std::cout << "  Execution time: " << result.execution_time_ms() << "ms" << std::endl;
-                }
-                break;
-            
-            case MessageType::MEMORY_RESULT:
-                if (message.has_memory_result()) {
-                    const auto& result = message.memory_result();
-                    std::cout << "Memory Result: " << std::endl;
-                    std::cout << "  Total count: " << result.total_count() << std::endl;
-                    std::cout << "  Entries: " << result.entries_size() << std::endl;
-                    for (const auto& entry : result.entries()) {
-                        std::cout << "    " << entry.key() << " = " << entry.value() << std::endl;
-                    }
-                }
-                break;
-            
-            case MessageType::TEXT:
-                std::cout << "Text: " << message.text_message() << std::endl;
-                break;
-            
-            default:
-                std::cout << "Unknown message type" << std::endl;
-                break;
-        }
-        std::cout << "====================================\n" << std::endl;
-    }
+    GMCP_LOG(kInfo) << "Stopped streaming";
 }
 
 } // namespace gmcp
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <grpcpp/grpcpp.h>
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <string>
-#include <thread>
+#include <vector>
+#include "agent_session.h"
 #include "gmcp.grpc.pb.h"
 
 namespace gmcp {
@@ -29,10 +32,41 @@ public:
                             const std::string& query,
                             int limit = 10);
     
+    // Query memory with every MemoryQuery field available, e.g. to resume
+    // from a previous result's next_cursor
+    MemoryResult QueryMemory(const MemoryQuery& query);
+    
+    // Stream all results of a query in chunks of `query.limit()` entries.
+    // `on_chunk` returning false cancels the stream. Returns the number of
+    // entries received.
+    size_t StreamQueryMemory(const MemoryQuery& query,
+                             const std::function<bool(const MemoryResult&)>& on_chunk);
+    
+    // Invoke several tools in one round-trip; results follow request order
+    std::vector<ToolResult> InvokeToolBatch(const std::vector<ToolInvocation>& invocations);
+    
+    // Run several memory queries in one round-trip; results follow request order
+    std::vector<MemoryResult> QueryMemoryBatch(const std::vector<MemoryQuery>& queries);
+    
+    // Write entries to a memory store
+    bool StoreMemory(const std::string& memory_id, const std::vector<MemoryEntry>& entries);
+    
+    // Stream entries to a memory store in chunks of `chunk_size` per message
+    IngestSummary IngestMemory(const std::string& memory_id,
+                               const std::vector<MemoryEntry>& entries,
+                               size_t chunk_size = 256);
+    
+    // Server latency histograms, counters and gauges
+    StatsResponse GetStats();
+    
+    // Open a multiplexed stream whose requests complete with their replies
+    std::unique_ptr<AgentSession> OpenSession(
+        const std::string& agent_id, const AgentSession::Options& options = AgentSession::Options());
+    
     // Start bidirectional streaming
     void StartStreaming(const std::string& agent_id);
     
-    // Send a message through the stream
+    // Send a message through the stream; replies are logged at debug
     bool SendMessage(const AgentMessage& message);
     
     // Subscribe to events
@@ -44,14 +78,11 @@ public:
 
 private:
     std::unique_ptr<AgentCoordination::Stub> stub_;
+    // Numbers requests; timestamps can collide between calls
+    std::atomic<uint64_t> next_request_{0};
     
-    // Streaming state
-    std::unique_ptr<grpc::ClientContext> stream_context_;
-    std::unique_ptr<grpc::ClientReaderWriter<AgentMessage, AgentMessage>> stream_;
-    std::unique_ptr<std::thread> receive_thread_;
-    bool streaming_;
-    
-    void ReceiveMessages();
+    // Stream opened by StartStreaming
+    std::unique_ptr<AgentSession> session_;
 };
 
 } // namespace gmcp
@@ -1,9 +1,8 @@
 #include <iostream>
 #include <memory>
 #include <string>
-#include <thread>
-#include <chrono>
 #include <grpcpp/grpcpp.h>
+#include "common/logging.h"
 #include "gmcp_client.h"
 
 void PrintMenu() {
@@ -19,29 +18,57 @@ void PrintMenu() {
     std::cout << "Enter choice: ";
 }
 
+void PrintReply(const gmcp::AgentSession::Reply& reply) {
+    if (!reply.status.ok()) {
+        std::cout << "  Failed: " << reply.status.error_message() << std::endl;
+        return;
+    }
+    const gmcp::AgentMessage& message = reply.message;
+    switch (message.type()) {
+        case gmcp::MessageType::TOOL_RESULT: {
+            const auto& result = message.tool_result();
+            std::cout << "  [" << message.request_id() << "] "
+                      << (result.success() ? result.result() : result.error_message()) << " ("
+                      << result.execution_time_ms() << " ms)" << std::endl;
+            break;
+        }
+        
+        case gmcp::MessageType::MEMORY_RESULT: {
+            const auto& result = message.memory_result();
+            std::cout << "  [" << message.request_id() << "] " << result.entries_size() << " of "
+                      << result.total_count() << " entries" << std::endl;
+            for (const auto& entry : result.entries()) {
+                std::cout << "    " << entry.key() << " = " << entry.value() << std::endl;
+            }
+            break;
+        }
+        
+        default:
+            std::cout << "  [" << message.request_id() << "] " << message.text_message()
+                      << std::endl;
+            break;
+    }
+}
+
 void RunDemo(gmcp::AgentClient& client) {
     std::cout << "\n=== Running Demo Sequence ===" << std::endl;
     
     // Start bidirectional streaming
     std::cout << "\n1. Starting bidirectional streaming..." << std::endl;
-    client.StartStreaming("demo_agent");
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    auto session = client.OpenSession("demo_agent");
     
     // Send a text message
     std::cout << "\n2. Sending text message..." << std::endl;
     gmcp::AgentMessage text_msg;
-    text_msg.set_agent_id("demo_agent");
-    text_msg.set_timestamp(std::chrono::system_clock::now().time_since_epoch().count());
     text_msg.set_type(gmcp::MessageType::TEXT);
     text_msg.set_text_message("Hello from gMCP client!");
-    client.SendMessage(text_msg);
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    PrintReply(session->Request(text_msg).get());
     
-    // Invoke calculator tool through streaming
-    std::cout << "\n3. Invoking calculator tool (10 + 5)..." << std::endl;
+    // The tool call and the query share the stream; both are sent before
+    // either reply is awaited
+    std::cout << "\n3. Invoking calculator tool (10 + 5) and querying memory store..."
+              << std::endl;
     gmcp::AgentMessage tool_msg;
-    tool_msg.set_agent_id("demo_agent");
-    tool_msg.set_timestamp(std::chrono::system_clock::now().time_since_epoch().count());
     tool_msg.set_type(gmcp::MessageType::TOOL_INVOCATION);
     
     auto* invocation = tool_msg.mutable_tool_invocation();
@@ -51,14 +78,7 @@ void RunDemo(gmcp::AgentClient& client) {
     (*invocation->mutable_arguments())["a"] = "10";
     (*invocation->mutable_arguments())["b"] = "5";
     
-    client.SendMessage(tool_msg);
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    
-    // Query memory through streaming
-    std::cout << "\n4. Querying memory store..." << std::endl;
     gmcp::AgentMessage mem_msg;
-    mem_msg.set_agent_id("demo_agent");
-    mem_msg.set_timestamp(std::chrono::system_clock::now().time_since_epoch().count());
     mem_msg.set_type(gmcp::MessageType::MEMORY_QUERY);
     
     auto* query = mem_msg.mutable_memory_query();
@@ -66,22 +86,35 @@ void RunDemo(gmcp::AgentClient& client) {
     query->set_query_type(gmcp::QueryType::LIST);
     query->set_limit(10);
     
-    client.SendMessage(mem_msg);
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    auto tool_reply = session->Request(tool_msg);
+    auto mem_reply = session->Request(mem_msg);
+    PrintReply(tool_reply.get());
+    PrintReply(mem_reply.get());
     
     // Stop streaming
-    std::cout << "\n5. Stopping streaming..." << std::endl;
-    client.StopStreaming();
+    std::cout << "\n4. Stopping streaming..." << std::endl;
+    session->Close();
     
     std::cout << "\nDemo completed!" << std::endl;
 }
 
 int main(int argc, char** argv) {
     std::string server_address = "localhost:50051";
+    gmcp::LogLevel log_level = gmcp::LogLevel::kInfo;
     
-    if (argc > 1) {
-        server_address = argv[1];
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--log-level=", 0) == 0) {
+            if (!gmcp::ParseLogLevel(arg.substr(12), &log_level)) {
+                std::cerr << "Usage: " << argv[0]
+                          << " [--log-level=debug|info|warning|error|off] [address]" << std::endl;
+                return 1;
+            }
+        } else {
+            server_address = arg;
+        }
     }
+    gmcp::Logger::Instance().set_level(log_level);
     
     std::cout << "Connecting to gMCP server at " << server_address << std::endl;
     
@@ -167,7 +200,7 @@ int main(int argc, char** argv) {
             }
             
             case 5: {
-                client.StartStreaming("interactive_agent");
+                auto session = client.OpenSession("interactive_agent");
                 
                 std::cout << "Enter message (or 'quit' to stop): ";
                 std::string msg;
@@ -175,19 +208,16 @@ int main(int argc, char** argv) {
                 
                 while (msg != "quit") {
                     gmcp::AgentMessage message;
-                    message.set_agent_id("interactive_agent");
-                    message.set_timestamp(
-                        std::chrono::system_clock::now().time_since_epoch().count());
                     message.set_type(gmcp::MessageType::TEXT);
                     message.set_text_message(msg);
                     
-                    client.SendMessage(message);
+                    PrintReply(session->Request(message).get());
                     
                     std::cout << "Enter message (or 'quit' to stop): ";
                     std::getline(std::cin, msg);
                 }
                 
-                client.StopStreaming();
+                session->Close();
                 break;
             }
             
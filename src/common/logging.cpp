@@ -0,0 +1,309 @@
+#include "logging.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <streambuf>
+
+namespace gmcp {
+
+namespace {
+
+// Per-thread ring size; a power of two
+constexpr size_t kBufferBytes = 64 << 10;
+// Longer lines are truncated so one line can never fill a ring
+constexpr size_t kMaxLineBytes = kBufferBytes / 4;
+// How often the writer drains when nobody wakes it
+constexpr auto kDrainInterval = std::chrono::milliseconds(20);
+
+// Record header: u32 length | u8 level | i64 time (ns since epoch)
+constexpr size_t kRecordHeader = sizeof(uint32_t) + sizeof(uint8_t) + sizeof(int64_t);
+
+const char* LevelTag(LogLevel level) {
+    switch (level) {
+        case LogLevel::kDebug: return "DEBUG";
+        case LogLevel::kInfo: return "INFO ";
+        case LogLevel::kWarning: return "WARN ";
+        case LogLevel::kError: return "ERROR";
+        default: return "     ";
+    }
+}
+
+// Appends "YYYY-MM-DD HH:MM:SS.uuuuuu " in local time
+void AppendTimestamp(int64_t time_ns, std::string* out) {
+    std::time_t seconds = static_cast<std::time_t>(time_ns / 1000000000);
+    std::tm local;
+    localtime_r(&seconds, &local);
+    char text[40];
+    size_t length = std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local);
+    length += std::snprintf(text + length, sizeof(text) - length, ".%06d ",
+                            static_cast<int>(time_ns % 1000000000 / 1000));
+    out->append(text, length);
+}
+
+} // namespace
+
+bool ParseLogLevel(std::string_view name, LogLevel* level) {
+    if (name == "debug") {
+        *level = LogLevel::kDebug;
+    } else if (name == "info") {
+        *level = LogLevel::kInfo;
+    } else if (name == "warning" || name == "warn") {
+        *level = LogLevel::kWarning;
+    } else if (name == "error") {
+        *level = LogLevel::kError;
+    } else if (name == "off") {
+        *level = LogLevel::kOff;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Single-producer, single-consumer byte ring owned by one logging thread. The
+// owner pushes records; whoever holds the logger's drain mutex pops them.
+class Logger::ThreadBuffer {
+public:
+    ThreadBuffer() : data_(new char[kBufferBytes]) {}
+
+    // Producer side; false if the record does not fit
+    bool Push(LogLevel level, int64_t time_ns, std::string_view message) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        uint64_t tail = tail_.load(std::memory_order_acquire);
+        size_t size = kRecordHeader + message.size();
+        if (kBufferBytes - (head - tail) < size) {
+            return false;
+        }
+        uint32_t length = static_cast<uint32_t>(message.size());
+        uint8_t level_byte = static_cast<uint8_t>(level);
+        CopyIn(head, &length, sizeof(length));
+        CopyIn(head + 4, &level_byte, sizeof(level_byte));
+        CopyIn(head + 5, &time_ns, sizeof(time_ns));
+        CopyIn(head + kRecordHeader, message.data(), message.size());
+        head_.store(head + size, std::memory_order_release);
+        return true;
+    }
+
+    // Bytes queued; an estimate from the producer side
+    size_t used() const {
+        return head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_relaxed);
+    }
+
+    // Consumer side: calls fn(level, time_ns, message) for each queued record
+    template <typename Fn>
+    void Drain(std::string* scratch, Fn&& fn) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        while (tail < head) {
+            uint32_t length;
+            uint8_t level_byte;
+            int64_t time_ns;
+            CopyOut(tail, &length, sizeof(length));
+            CopyOut(tail + 4, &level_byte, sizeof(level_byte));
+            CopyOut(tail + 5, &time_ns, sizeof(time_ns));
+            scratch->resize(length);
+            CopyOut(tail + kRecordHeader, scratch->data(), length);
+            fn(static_cast<LogLevel>(level_byte), time_ns, std::string_view(*scratch));
+            tail += kRecordHeader + length;
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    // Set when the owning thread exits; the buffer is dropped once drained
+    std::atomic<bool> retired{false};
+
+private:
+    void CopyIn(uint64_t position, const void* source, size_t size) {
+        size_t offset = position & (kBufferBytes - 1);
+        size_t first = std::min(size, kBufferBytes - offset);
+        std::memcpy(data_.get() + offset, source, first);
+        std::memcpy(data_.get(), static_cast<const char*>(source) + first, size - first);
+    }
+
+    void CopyOut(uint64_t position, void* target, size_t size) const {
+        size_t offset = position & (kBufferBytes - 1);
+        size_t first = std::min(size, kBufferBytes - offset);
+        std::memcpy(target, data_.get() + offset, first);
+        std::memcpy(static_cast<char*>(target) + first, data_.get(), size - first);
+    }
+
+    std::unique_ptr<char[]> data_;
+    // Written by the producer only
+    alignas(64) std::atomic<uint64_t> head_{0};
+    // Written by the consumer only
+    alignas(64) std::atomic<uint64_t> tail_{0};
+};
+
+Logger& Logger::Instance() {
+    static Logger* logger = [] {
+        auto* instance = new Logger();
+        std::atexit([] { Logger::Instance().Flush(); });
+        return instance;
+    }();
+    return *logger;
+}
+
+Logger::Logger() : output_(stderr) {
+    writer_ = std::thread([this] { WriterLoop(); });
+    writer_.detach();
+}
+
+Logger::ThreadBuffer* Logger::LocalBuffer() {
+    struct Holder {
+        std::shared_ptr<ThreadBuffer> buffer;
+        ~Holder() {
+            if (buffer) {
+                buffer->retired.store(true, std::memory_order_release);
+            }
+        }
+    };
+    thread_local Holder holder;
+    if (!holder.buffer) {
+        holder.buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers_.push_back(holder.buffer);
+    }
+    return holder.buffer.get();
+}
+
+void Logger::Write(LogLevel level, std::string_view message) {
+    if (message.size() > kMaxLineBytes) {
+        message = message.substr(0, kMaxLineBytes);
+    }
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    ThreadBuffer* buffer = LocalBuffer();
+    if (!buffer->Push(level, now, message)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Errors go out promptly; otherwise only wake the writer before the ring fills
+    if (level >= LogLevel::kError || buffer->used() > kBufferBytes / 2) {
+        wake_cv_.notify_one();
+    }
+}
+
+void Logger::Flush() {
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    DrainLocked();
+}
+
+void Logger::WriterLoop() {
+    std::unique_lock<std::mutex> wake_lock(wake_mutex_);
+    while (true) {
+        wake_cv_.wait_for(wake_lock, kDrainInterval);
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+        DrainLocked();
+    }
+}
+
+void Logger::DrainLocked() {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers = buffers_;
+    }
+
+    formatted_.clear();
+    std::string scratch;
+    bool any_retired = false;
+    for (const auto& buffer : buffers) {
+        // Read the flag first: a retired thread pushes nothing after it
+        bool retired = buffer->retired.load(std::memory_order_acquire);
+        buffer->Drain(&scratch, [this](LogLevel level, int64_t time_ns, std::string_view line) {
+            AppendTimestamp(time_ns, &formatted_);
+            formatted_.append(LevelTag(level));
+            formatted_.push_back(' ');
+            formatted_.append(line);
+            formatted_.push_back('\n');
+        });
+        any_retired = any_retired || retired;
+    }
+
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reported_drops_) {
+        formatted_.append(std::to_string(dropped - reported_drops_) +
+                          " log lines dropped (logging faster than it can be written)\n");
+        reported_drops_ = dropped;
+    }
+
+    if (!formatted_.empty()) {
+        FILE* output = output_.load(std::memory_order_relaxed);
+        std::fwrite(formatted_.data(), 1, formatted_.size(), output);
+        std::fflush(output);
+    }
+
+    if (any_retired) {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                      [](const std::shared_ptr<ThreadBuffer>& buffer) {
+                                          return buffer->retired.load(
+                                                     std::memory_order_acquire) &&
+                                                 buffer->used() == 0;
+                                      }),
+                       buffers_.end());
+    }
+}
+
+namespace internal {
+
+// Appends everything streamed into it to one string
+class LineBuffer : public std::streambuf {
+public:
+    std::string& line() { return line_; }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (ch != traits_type::eof()) {
+            line_.push_back(static_cast<char>(ch));
+        }
+        return ch;
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize size) override {
+        line_.append(data, static_cast<size_t>(size));
+        return size;
+    }
+
+private:
+    std::string line_;
+};
+
+struct LineStream {
+    LineBuffer buffer;
+    std::ostream stream{&buffer};
+    bool busy = false;
+};
+
+} // namespace internal
+
+LogLine::LogLine(LogLevel level) : level_(level) {
+    thread_local internal::LineStream local;
+    if (local.busy) {
+        nested_ = std::make_unique<internal::LineStream>();
+        line_ = nested_.get();
+    } else {
+        line_ = &local;
+    }
+    line_->busy = true;
+}
+
+LogLine::~LogLine() {
+    std::string& line = line_->buffer.line();
+    Logger::Instance().Write(level_, line);
+    line.clear();
+    // Undo any manipulators so the next line starts from default formatting
+    std::ostream& stream = line_->stream;
+    stream.clear();
+    stream.flags(std::ios_base::dec | std::ios_base::skipws);
+    stream.precision(6);
+    stream.width(0);
+    stream.fill(' ');
+    line_->busy = false;
+}
+
+std::ostream& LogLine::stream() {
+    return line_->stream;
+}
+
+} // namespace gmcp
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace gmcp {
+
+enum class LogLevel : uint8_t {
+    kDebug = 0,
+    kInfo = 1,
+    kWarning = 2,
+    kError = 3,
+    kOff = 4,
+};
+
+// Parses "debug", "info", "warning", "error" or "off"
+bool ParseLogLevel(std::string_view name, LogLevel* level);
+
+// Asynchronous leveled logger shared by the server and the client.
+//
+// Each thread appends finished lines to its own single-producer ring buffer
+// with no lock and no syscall; a background thread drains every ring,
+// formats the lines and writes them to the output in one call per round.
+// When a ring is full the line is dropped and counted rather than blocking
+// the caller, and the writer reports how many were lost. Lines keep their
+// order per thread; lines of different threads may interleave out of order
+// within one drain round, but each carries its own timestamp.
+//
+// Disabled levels cost one relaxed atomic load, so per-message logging is
+// left at kDebug and the default level (kInfo) stays quiet under load.
+class Logger {
+public:
+    // The process-wide logger. It is never destroyed, so threads may log
+    // until exit; queued lines are flushed by an exit handler.
+    static Logger& Instance();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    // Minimum level written; may be changed at any time
+    void set_level(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    LogLevel level() const { return level_.load(std::memory_order_relaxed); }
+
+    bool Enabled(LogLevel level) const {
+        return level != LogLevel::kOff && level >= level_.load(std::memory_order_relaxed);
+    }
+
+    // Stream lines are written to (default stderr)
+    void set_output(FILE* output) { output_.store(output, std::memory_order_relaxed); }
+
+    // Queue one line without blocking
+    void Write(LogLevel level, std::string_view message);
+
+    // Write every line queued so far and wait until it reaches the output
+    void Flush();
+
+    // Lines lost to full buffers since startup
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    class ThreadBuffer;
+
+    Logger();
+
+    ThreadBuffer* LocalBuffer();
+    void WriterLoop();
+    // Drains every buffer to the output; caller holds drain_mutex_
+    void DrainLocked();
+
+    std::atomic<LogLevel> level_{LogLevel::kInfo};
+    std::atomic<FILE*> output_;
+    std::atomic<uint64_t> dropped_{0};
+
+    std::mutex buffers_mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+
+    std::mutex drain_mutex_;
+    std::string formatted_;
+    uint64_t reported_drops_ = 0;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::thread writer_;
+};
+
+namespace internal {
+struct LineStream;
+} // namespace internal
+
+// Collects one line through operator<< and queues it when destroyed. The
+// stream and its buffer are reused per thread, so building a line does not
+// allocate once the thread has logged a line of similar length.
+class LogLine {
+public:
+    explicit LogLine(LogLevel level);
+    ~LogLine();
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    std::ostream& stream();
+
+private:
+    LogLevel level_;
+    internal::LineStream* line_;
+    // Only used when a line is built while formatting another on this thread
+    std::unique_ptr<internal::LineStream> nested_;
+};
+
+namespace internal {
+// Lets GMCP_LOG expand to a single expression of type void
+struct LogVoidify {
+    void operator&(std::ostream&) {}
+};
+} // namespace internal
+
+} // namespace gmcp
+
+// GMCP_LOG(kInfo) << "Registered tool: " << name;
+// Arguments are not evaluated when the level is disabled.
+#define GMCP_LOG(level)                                                          \
+    !::gmcp::Logger::Instance().Enabled(::gmcp::LogLevel::level)                 \
+        ? (void)0                                                                \
+        : ::gmcp::internal::LogVoidify() &                                       \
+              ::gmcp::LogLine(::gmcp::LogLevel::level).stream()
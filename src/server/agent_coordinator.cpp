@@ -0,0 +1,439 @@
+#include "agent_coordinator.h"
+#include <chrono>
+#include <utility>
+#include "common/logging.h"
+
+namespace gmcp {
+
+AgentCoordinator::AgentCoordinator() : AgentCoordinator(Options()) {
+}
+
+AgentCoordinator::AgentCoordinator(const Options& options)
+    : options_(options),
+      metrics_(std::make_unique<ServerMetrics>()),
+      tool_manager_(std::make_unique<ToolManager>(options.tools)),
+      memory_manager_(std::make_unique<MemoryManager>(options.memory)),
+      event_bus_(std::make_unique<EventBus>(options.events)),
+      executor_(std::make_unique<WorkStealingExecutor>(options.executor_threads)) {
+    if (options_.stream_window == 0) {
+        options_.stream_window = 1;
+    }
+}
+
+AgentCoordinator::~AgentCoordinator() = default;
+
+bool AgentCoordinator::HandleAgentMessage(const AgentMessage& message, AgentMessage* response,
+                                          const CancellationToken& cancel) {
+    ScopedLatency latency(metrics_->rpc(ServerMetrics::Rpc::kStreamMessage));
+    metrics_->agent_messages.fetch_add(1, std::memory_order_relaxed);
+    bool has_response = false;
+    
+    // Process message based on type
+    response->set_agent_id("server");
+    response->set_request_id(!message.request_id().empty() || !message.has_tool_invocation()
+                                 ? message.request_id()
+                                 : message.tool_invocation().request_id());
+    response->set_timestamp(
+        std::chrono::system_clock::now().time_since_epoch().count());
+    
+    switch (message.type()) {
+        case MessageType::TOOL_INVOCATION: {
+            if (message.has_tool_invocation()) {
+                response->set_type(MessageType::TOOL_RESULT);
+                RunTool(message.tool_invocation(), response->mutable_tool_result(), cancel);
+                has_response = true;
+            }
+            break;
+        }
+        
+        case MessageType::MEMORY_QUERY: {
+            if (message.has_memory_query()) {
+                response->set_type(MessageType::MEMORY_RESULT);
+                RunQuery(message.memory_query(), response->mutable_memory_result());
+                has_response = true;
+            }
+            break;
+        }
+        
+        case MessageType::TEXT: {
+            // Echo back text messages
+            response->set_type(MessageType::TEXT);
+            response->set_text_message("Echo: " + message.text_message());
+            has_response = true;
+            break;
+        }
+        
+        default:
+            GMCP_LOG(kWarning) << "Unknown message type " << message.type();
+            break;
+    }
+    
+    // Publish event for this message
+    Event event;
+    event.set_event_id("evt_" + std::to_string(message.timestamp()));
+    event.set_event_type("message_received");
+    event.set_source_agent_id(message.agent_id());
+    event.set_timestamp(
+        std::chrono::system_clock::now().time_since_epoch().count());
+    PublishEvent(event);
+    
+    return has_response;
+}
+
+void AgentCoordinator::RegisterTool(const ToolRegistration& request,
+                                    RegistrationResponse* response) {
+    ScopedLatency latency(metrics_->rpc(ServerMetrics::Rpc::kRegisterTool));
+    // Create a simple example tool function
+    auto tool_func = [](const std::map<std::string, std::string>& args) -> std::string {
+        std::string result = "Tool executed with args: ";
+        for (const auto& [key, value] : args) {
+            result += key + "=" + value + ", ";
+        }
+        return result;
+    };
+    
+    bool success = tool_manager_->RegisterTool(request, tool_func);
+    
+    response->set_success(success);
+    if (success) {
+        response->set_message("Tool registered successfully");
+        response->set_registration_id(request.tool_id());
+        metrics_->AddTool(request.tool_id());
+        GMCP_LOG(kInfo) << "Registered tool: " << request.name();
+    } else {
+        response->set_message("Tool already registered or registration failed");
+    }
+}
+
+uint64_t AgentCoordinator::RegisterToolFunction(const ToolRegistration& registration,
+                                                NativeToolFunction function, uint64_t replaces) {
+    uint64_t generation = tool_manager_->ReplaceTool(registration, std::move(function), replaces);
+    if (generation != 0) {
+        metrics_->AddTool(registration.tool_id());
+    }
+    return generation;
+}
+
+bool AgentCoordinator::UnregisterTool(const std::string& tool_id, uint64_t generation) {
+    return tool_manager_->UnregisterTool(tool_id, generation);
+}
+
+void AgentCoordinator::RegisterMemory(const MemoryRegistration& request,
+                                      RegistrationResponse* response) {
+    ScopedLatency latency(metrics_->rpc(ServerMetrics::Rpc::kRegisterMemory));
+    bool success = memory_manager_->RegisterMemory(request);
+    
+    response->set_success(success);
+    if (success) {
+        response->set_message("Memory store registered successfully");
+        response->set_registration_id(request.memory_id());
+        GMCP_LOG(kInfo) << "Registered memory store: " << request.name();
+    } else {
+        response->set_message("Memory store already registered or registration failed");
+    }
+}
+
+void AgentCoordinator::RunTool(const ToolInvocation& invocation, ToolResult* result,
+                               const CancellationToken& cancel) {
+    {
+        ScopedLatency latency(metrics_->tool(invocation.tool_id()));
+        tool_manager_->InvokeTool(invocation, result, cancel);
+    }
+    if (!result->success()) {
+        metrics_->tool_errors.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AgentCoordinator::RunQuery(const MemoryQuery& query, MemoryResult* result) {
+    ScopedLatency latency(metrics_->query(query.query_type()));
+    memory_manager_->Query(query, result);
+}
+
+grpc::Status AgentCoordinator::InvokeTool(const ToolInvocation& request, ToolResult* response,
+                                          const CancellationToken& cancel) {
+    ScopedLatency latency(metrics_->rpc(ServerMetrics::Rpc::kInvokeTool));
+    RunTool(request, response, cancel);
+    // Tool errors are part of the result; only failures to run it are not
+    if (response->status_code() != grpc::StatusCode::OK) {
+        return grpc::Status(static_cast<grpc::StatusCode>(response->status_code()),
+                            response->error_message());
+    }
+    return grpc::Status::OK;
+}
+
+void AgentCoordinator::QueryMemory(const MemoryQuery& request, MemoryResult* response) {
+    ScopedLatency latency(metrics_->rpc(ServerMetrics::Rpc::kQueryMemory));
+    RunQuery(request, response);
+}
+
+void AgentCoordinator::InvokeToolBatch(const ToolInvocationBatch& request,
+                                       ToolResultBatch* response,
+                                       const CancellationToken& cancel) {
+    ScopedLatency latency(metrics_->rpc(ServerMetrics::Rpc::kInvokeToolBatch));
+    // Pre-size so each entry writes its own slot without synchronization
+    auto* results = response->mutable_results();
+    results->Reserve(request.invocations_size());
+    for (int i = 0; i < request.invocations_size(); ++i) {
+        results->Add();
+    }
+    executor_->ParallelFor(request.invocations_size(), [&](size_t i) {
+        RunTool(request.invocations(i), results->Mutable(i), cancel);
+    });
+}
+
+void AgentCoordinator::QueryMemoryBatch(const MemoryQueryBatch& request,
+                                        MemoryResultBatch* response) {
+    ScopedLatency latency(metrics_->rpc(ServerMetrics::Rpc::kQueryMemoryBatch));
+    auto* results = response->mutable_results();
+    results->Reserve(request.queries_size());
+    for (int i = 0; i < request.queries_size(); ++i) {
+        results->Add();
+    }
+    executor_->ParallelFor(request.queries_size(), [&](size_t i) {
+        RunQuery(request.queries(i), results->Mutable(i));
+    });
+}
+
+namespace {
+
+// Entries applied per store lock acquisition during bulk ingest
+constexpr size_t kIngestBatchSize = 1024;
+
+// Entries written without a timestamp are stamped on arrival
+void StampIfUnset(MemoryEntry* entry, int64_t now) {
+    if (entry->timestamp() == 0) {
+        entry->set_timestamp(now);
+    }
+}
+
+} // namespace
+
+void AgentCoordinator::StoreMemory(const MemoryWrite& request, StoreResponse* response) {
+    ScopedLatency latency(metrics_->rpc(ServerMetrics::Rpc::kStoreMemory));
+    int64_t now = std::chrono::system_clock::now().time_since_epoch().count();
+    std::vector<MemoryEntry> entries(request.entries().begin(), request.entries().end());
+    for (auto& entry : entries) {
+        StampIfUnset(&entry, now);
+    }
+    
+    size_t expected = entries.size();
+    size_t stored = memory_manager_->StoreBatch(request.memory_id(), std::move(entries));
+    
+    response->set_stored_count(stored);
+    response->set_success(stored == expected);
+    if (stored == expected) {
+        response->set_message("Stored " + std::to_string(stored) + " entries");
+    } else if (!memory_manager_->GetMemory(request.memory_id())) {
+        response->set_message("Memory store not registered: " + request.memory_id());
+    } else {
+        response->set_message("Stored " + std::to_string(stored) + " of " +
+                              std::to_string(expected) + " entries; the rest are invalid for " +
+                              "the store type");
+    }
+}
+
+AgentCoordinator::IngestSession::IngestSession(MemoryManager* memory_manager,
+                                               ServerMetrics* metrics)
+    : memory_manager_(memory_manager),
+      metrics_(metrics),
+      start_(std::chrono::steady_clock::now()) {
+    pending_.reserve(kIngestBatchSize);
+}
+
+void AgentCoordinator::IngestSession::Add(MemoryWrite&& write) {
+    if (write.memory_id() != memory_id_) {
+        Flush();
+        memory_id_ = write.memory_id();
+    }
+    
+    int64_t now = std::chrono::system_clock::now().time_since_epoch().count();
+    auto* entries = write.mutable_entries();
+    received_ += entries->size();
+    for (auto& entry : *entries) {
+        StampIfUnset(&entry, now);
+        pending_.push_back(std::move(entry));
+        if (pending_.size() >= kIngestBatchSize) {
+            Flush();
+        }
+    }
+}
+
+void AgentCoordinator::IngestSession::Flush() {
+    if (pending_.empty()) {
+        return;
+    }
+    stored_ += memory_manager_->StoreBatch(memory_id_, std::move(pending_));
+    pending_.clear();
+    pending_.reserve(kIngestBatchSize);
+}
+
+IngestSummary AgentCoordinator::IngestSession::Finish() {
+    Flush();
+    
+    auto elapsed_time = std::chrono::steady_clock::now() - start_;
+    metrics_->rpc(ServerMetrics::Rpc::kIngestMemory)->Record(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed_time).count());
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(elapsed_time).count();
+    
+    IngestSummary summary;
+    summary.set_received_count(received_);
+    summary.set_stored_count(stored_);
+    summary.set_rejected_count(received_ - stored_);
+    summary.set_elapsed_us(elapsed);
+    summary.set_entries_per_second(elapsed > 0 ? stored_ * 1e6 / elapsed : 0.0);
+    
+    GMCP_LOG(kInfo) << "Ingested " << stored_ << "/" << received_ << " entries in "
+                    << elapsed / 1000 << " ms ("
+                    << static_cast<int64_t>(summary.entries_per_second()) << " entries/s)";
+    return summary;
+}
+
+AgentCoordinator::QueryStream::QueryStream(MemoryManager* memory_manager,
+                                           ServerMetrics* metrics, const MemoryQuery& query)
+    : memory_manager_(memory_manager), metrics_(metrics), query_(query) {
+    metrics_->active_query_streams.fetch_add(1, std::memory_order_relaxed);
+}
+
+AgentCoordinator::QueryStream::QueryStream(QueryStream&& other) noexcept
+    : memory_manager_(other.memory_manager_),
+      metrics_(std::exchange(other.metrics_, nullptr)),
+      query_(std::move(other.query_)),
+      done_(other.done_) {
+}
+
+AgentCoordinator::QueryStream::~QueryStream() {
+    if (metrics_) {
+        metrics_->active_query_streams.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+bool AgentCoordinator::QueryStream::Next(MemoryResult* chunk) {
+    if (done_) {
+        return false;
+    }
+    ScopedLatency latency(metrics_->rpc(ServerMetrics::Rpc::kStreamQueryChunk));
+    chunk->Clear();
+    memory_manager_->Query(query_, chunk);
+    if (chunk->next_cursor().empty()) {
+        done_ = true;
+    } else {
+        query_.set_cursor(chunk->next_cursor());
+    }
+    return true;
+}
+
+void AgentCoordinator::GetStats(const StatsRequest& request, StatsResponse* response) {
+    ScopedLatency latency(metrics_->rpc(ServerMetrics::Rpc::kGetStats));
+    metrics_->Collect(response);
+    
+    EventBus::Stats events = event_bus_->stats();
+    auto& counters = *response->mutable_counters();
+    counters["events_published"] = events.published;
+    counters["events_dropped"] = events.dropped;
+    counters["event_overflow_disconnects"] = events.overflow_disconnects;
+    auto& gauges = *response->mutable_gauges();
+    gauges["event_subscribers"] = events.subscribers;
+    gauges["event_queue_depth"] = events.queued;
+    gauges["event_queue_depth_max"] = events.max_queue_depth;
+    
+    ToolResultCache::Stats cache = tool_manager_->cache_stats();
+    counters["tool_cache_hits"] = cache.hits;
+    counters["tool_cache_misses"] = cache.misses;
+    counters["tool_cache_evictions"] = cache.evictions;
+    counters["tool_cache_expirations"] = cache.expirations;
+    counters["tool_calls_coalesced"] = tool_manager_->coalesced_count();
+    gauges["tool_cache_entries"] = cache.entries;
+    gauges["tool_cache_bytes"] = cache.bytes;
+    
+    ToolManager::AdmissionStats admission = tool_manager_->admission_stats();
+    counters["tool_rejections"] = admission.rejected;
+    gauges["tools_running"] = admission.running;
+    gauges["tools_queued"] = admission.queued;
+}
+
+CancellationToken::Clock::time_point AgentCoordinator::DeadlineOf(
+    const grpc::ServerContextBase* context) {
+    auto deadline = context->deadline();
+    if (deadline == std::chrono::system_clock::time_point::max()) {
+        return CancellationToken::Clock::time_point::max();
+    }
+    // Clients send a timeout, which gRPC turns into a wall-clock deadline
+    return CancellationToken::Clock::now() +
+           std::chrono::duration_cast<CancellationToken::Clock::duration>(
+               deadline - std::chrono::system_clock::now());
+}
+
+CancellationToken AgentCoordinator::TokenFor(grpc::ServerContextBase* context) {
+    return CancellationToken(DeadlineOf(context), [context] { return context->IsCancelled(); });
+}
+
+void AgentCoordinator::PublishEvent(const Event& event) {
+    event_bus_->Publish(event);
+}
+
+void AgentCoordinator::InitializeExamples() {
+    // Register example tools
+    ToolRegistration calc_tool;
+    calc_tool.set_tool_id("calculator");
+    calc_tool.set_name("Calculator");
+    calc_tool.set_description("Performs basic arithmetic operations");
+    calc_tool.set_return_type("string");
+    calc_tool.set_cacheable(true);
+    
+    auto param1 = calc_tool.add_parameters();
+    param1->set_name("operation");
+    param1->set_type("string");
+    param1->set_required(true);
+    param1->set_description("Operation to perform: add, subtract, multiply, divide");
+    
+    auto param2 = calc_tool.add_parameters();
+    param2->set_name("a");
+    param2->set_type("number");
+    param2->set_required(true);
+    param2->set_description("First operand");
+    
+    auto param3 = calc_tool.add_parameters();
+    param3->set_name("b");
+    param3->set_type("number");
+    param3->set_required(true);
+    param3->set_description("Second operand");
+    
+    // Slots follow the parameter order above; operands arrive parsed
+    auto calc_func = [](const ToolArguments& args, const CancellationToken&) -> std::string {
+        std::string_view op = args.text(0);
+        double a = args.number(1);
+        double b = args.number(2);
+        
+        double result = 0.0;
+        if (op == "add") result = a + b;
+        else if (op == "subtract") result = a - b;
+        else if (op == "multiply") result = a * b;
+        else if (op == "divide") result = b != 0 ? a / b : 0;
+        
+        return std::to_string(result);
+    };
+    
+    tool_manager_->RegisterTool(calc_tool, calc_func);
+    metrics_->AddTool(calc_tool.tool_id());
+    GMCP_LOG(kInfo) << "Initialized example calculator tool";
+    
+    // Register example memory store
+    MemoryRegistration mem_store;
+    mem_store.set_memory_id("default_store");
+    mem_store.set_name("Default Key-Value Store");
+    mem_store.set_description("Default in-memory key-value storage");
+    mem_store.set_type(MemoryType::KEY_VALUE);
+    
+    memory_manager_->RegisterMemory(mem_store);
+    
+    // Add some example entries
+    MemoryEntry entry1;
+    entry1.set_key("example_key");
+    entry1.set_value("example_value");
+    entry1.set_timestamp(std::chrono::system_clock::now().time_since_epoch().count());
+    memory_manager_->Store("default_store", entry1);
+    
+    GMCP_LOG(kInfo) << "Initialized example memory store";
+}
+
+} // namespace gmcp
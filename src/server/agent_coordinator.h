@@ -0,0 +1,178 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gmcp.grpc.pb.h"
+#include "cancellation.h"
+#include "event_bus.h"
+#include "executor.h"
+#include "tool_manager.h"
+#include "memory_manager.h"
+#include "metrics.h"
+
+namespace gmcp {
+
+// Transport-independent core of the gMCP service. Both the synchronous and
+// the callback-based gRPC services are thin adapters over one coordinator,
+// so tools, memory stores and events are shared whichever mode is served.
+class AgentCoordinator {
+public:
+    struct Options {
+        // Worker threads shared by all streams (0 = hardware concurrency)
+        size_t executor_threads = 0;
+        // Maximum messages of one agent stream being processed at once
+        size_t stream_window = 64;
+        // Per-subscriber event queues
+        EventBus::Options events;
+        // Persistence of memory stores
+        MemoryManager::Options memory;
+        // Result cache of cacheable tools
+        ToolManager::Options tools;
+    };
+
+    AgentCoordinator();
+    explicit AgentCoordinator(const Options& options);
+    ~AgentCoordinator();
+
+    // Process one message received on an agent stream. Returns true and
+    // fills `response` if the message produces a reply. `cancel` is the
+    // stream's token; tool invocations stop waiting once it fires.
+    bool HandleAgentMessage(const AgentMessage& message, AgentMessage* response,
+                            const CancellationToken& cancel = CancellationToken::None());
+
+    // Tool registration
+    void RegisterTool(const ToolRegistration& request, RegistrationResponse* response);
+
+    // Install a tool implemented in the server process (e.g. by a plugin) in
+    // place of the registration with generation `replaces` (0: a free id).
+    // Returns the installed generation, 0 if the id holds another tool.
+    uint64_t RegisterToolFunction(const ToolRegistration& registration,
+                                  NativeToolFunction function, uint64_t replaces);
+    // Remove the tool only while `generation` is still its registration
+    bool UnregisterTool(const std::string& tool_id, uint64_t generation);
+
+    // Memory registration
+    void RegisterMemory(const MemoryRegistration& request, RegistrationResponse* response);
+
+    // Tool invocation. Results are built in place in `response`, so a reply
+    // allocated on an arena is filled without an intermediate copy. Returns
+    // RESOURCE_EXHAUSTED when admission control rejects the call, and
+    // CANCELLED or DEADLINE_EXCEEDED once `cancel` fires.
+    grpc::Status InvokeTool(const ToolInvocation& request, ToolResult* response,
+                            const CancellationToken& cancel = CancellationToken::None());
+
+    // Memory query, filled in place like InvokeTool
+    void QueryMemory(const MemoryQuery& request, MemoryResult* response);
+
+    // Batched variants: entries run in parallel on the executor and results
+    // keep request order
+    void InvokeToolBatch(const ToolInvocationBatch& request, ToolResultBatch* response,
+                         const CancellationToken& cancel = CancellationToken::None());
+    void QueryMemoryBatch(const MemoryQueryBatch& request, MemoryResultBatch* response);
+
+    // Write entries to a memory store
+    void StoreMemory(const MemoryWrite& request, StoreResponse* response);
+
+    // Latency histograms, counters and gauges
+    void GetStats(const StatsRequest& request, StatsResponse* response);
+
+    // Accumulates streamed writes and applies them to the memory manager in
+    // batches, so a bulk load takes one store lock per batch, not per entry
+    class IngestSession {
+    public:
+        IngestSession(MemoryManager* memory_manager, ServerMetrics* metrics);
+
+        // Buffer the entries of one streamed message
+        void Add(MemoryWrite&& write);
+
+        // Apply whatever is still buffered and summarize the session
+        IngestSummary Finish();
+
+    private:
+        void Flush();
+
+        MemoryManager* memory_manager_;
+        ServerMetrics* metrics_;
+        std::chrono::steady_clock::time_point start_;
+        std::string memory_id_;
+        std::vector<MemoryEntry> pending_;
+        int64_t received_ = 0;
+        int64_t stored_ = 0;
+    };
+
+    // Start a bulk ingest session
+    IngestSession BeginIngest() { return IngestSession(memory_manager_.get(), metrics_.get()); }
+
+    // Pages through one query for StreamQueryMemory. Each chunk is a fresh
+    // query resumed from the previous chunk's cursor, so at most one chunk is
+    // held in memory and no store lock is held between chunks.
+    class QueryStream {
+    public:
+        QueryStream(MemoryManager* memory_manager, ServerMetrics* metrics,
+                    const MemoryQuery& query);
+        ~QueryStream();
+
+        QueryStream(QueryStream&& other) noexcept;
+        QueryStream& operator=(QueryStream&&) = delete;
+
+        // Fill the next chunk; false once the previous chunk was the last
+        bool Next(MemoryResult* chunk);
+
+    private:
+        MemoryManager* memory_manager_;
+        // Null once moved from
+        ServerMetrics* metrics_;
+        MemoryQuery query_;
+        bool done_ = false;
+    };
+
+    // Start streaming the results of a query
+    QueryStream BeginQueryStream(const MemoryQuery& query) {
+        return QueryStream(memory_manager_.get(), metrics_.get(), query);
+    }
+
+    // A token that fires when the call is cancelled or its deadline passes.
+    // The context must outlive the token.
+    static CancellationToken TokenFor(grpc::ServerContextBase* context);
+    // The call's deadline on the steady clock (max when it has none)
+    static CancellationToken::Clock::time_point DeadlineOf(
+        const grpc::ServerContextBase* context);
+
+    // Publish an event to subscribers
+    void PublishEvent(const Event& event);
+
+    // Initialize example tools and memory stores
+    void InitializeExamples();
+
+    // Shared executor that stream messages are dispatched to
+    WorkStealingExecutor& executor() { return *executor_; }
+    size_t stream_window() const { return options_.stream_window; }
+
+    // Event fan-out shared by all subscribers
+    EventBus& event_bus() { return *event_bus_; }
+
+    // Server instrumentation; transports update the stream gauges
+    ServerMetrics& metrics() { return *metrics_; }
+
+private:
+    // Invoke a tool, recording its latency and failures
+    void RunTool(const ToolInvocation& invocation, ToolResult* result,
+                 const CancellationToken& cancel);
+    // Run a query, recording its latency by query type
+    void RunQuery(const MemoryQuery& query, MemoryResult* result);
+
+    Options options_;
+    std::unique_ptr<ServerMetrics> metrics_;
+    std::unique_ptr<ToolManager> tool_manager_;
+    std::unique_ptr<MemoryManager> memory_manager_;
+    std::unique_ptr<EventBus> event_bus_;
+
+    // Declared last so workers stop before the state they use is destroyed
+    std::unique_ptr<WorkStealingExecutor> executor_;
+};
+
+} // namespace gmcp
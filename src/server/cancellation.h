@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+namespace gmcp {
+
+// Tells long-running work that its caller gave up. A token fires when it is
+// cancelled explicitly, when its deadline passes, when its probe (e.g. a
+// gRPC context's IsCancelled) reports cancellation, or when its parent
+// fires. Tools should poll cancelled() between units of work and return
+// early once it is set; their result is discarded anyway.
+//
+// Tokens are neither copied nor moved: work receives them by reference and
+// the owner keeps them alive for its duration.
+class CancellationToken {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Probe = std::function<bool()>;
+
+    // Never fires unless cancelled explicitly
+    CancellationToken() = default;
+    // Fires at `deadline`, when `probe` returns true or when `parent` fires
+    explicit CancellationToken(Clock::time_point deadline, Probe probe = nullptr,
+                               const CancellationToken* parent = nullptr)
+        : deadline_(parent ? std::min(deadline, parent->deadline()) : deadline),
+          probe_(std::move(probe)),
+          parent_(parent) {}
+
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken& operator=(const CancellationToken&) = delete;
+
+    // A token that never fires, for callers without a deadline
+    static const CancellationToken& None() {
+        static const CancellationToken none;
+        return none;
+    }
+
+    void Cancel() { cancelled_.store(true, std::memory_order_release); }
+
+    bool cancelled() const {
+        return cancelled_.load(std::memory_order_acquire) || expired() ||
+               (probe_ && probe_()) || (parent_ && parent_->cancelled());
+    }
+
+    // The deadline (of this token or a parent) has passed
+    bool expired() const { return deadline_ != Clock::time_point::max() && Clock::now() >= deadline_; }
+
+    // Clock::time_point::max() when there is none
+    Clock::time_point deadline() const { return deadline_; }
+
+private:
+    std::atomic<bool> cancelled_{false};
+    const Clock::time_point deadline_ = Clock::time_point::max();
+    const Probe probe_;
+    const CancellationToken* const parent_ = nullptr;
+};
+
+} // namespace gmcp
@@ -0,0 +1,80 @@
+#include "concurrency_limiter.h"
+#include <algorithm>
+
+namespace gmcp {
+
+namespace {
+
+// Waiters re-check their token this often, since a probe cannot wake them
+constexpr auto kCancellationCheckInterval = std::chrono::milliseconds(10);
+
+} // namespace
+
+bool ConcurrencyLimiter::TryTake() {
+    size_t active = active_.load();
+    while (active < limit_) {
+        if (active_.compare_exchange_weak(active, active + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ConcurrencyLimiter::Admission ConcurrencyLimiter::Acquire(int64_t service_ns,
+                                                          Clock::duration budget,
+                                                          const CancellationToken& cancel) {
+    if (limit_ == 0) {
+        return Admission::kAdmitted;
+    }
+    // Newcomers do not overtake queued callers
+    if (waiting_.load() == 0 && TryTake()) {
+        return Admission::kAdmitted;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    Clock::time_point now = Clock::now();
+    Clock::time_point wait_until = std::min(cancel.deadline(), now + budget);
+    auto expected_wait = std::chrono::nanoseconds(
+        static_cast<int64_t>(waiting_.load() + 1) * std::max<int64_t>(service_ns, 0) /
+        static_cast<int64_t>(limit_));
+    if (now + expected_wait > wait_until) {
+        return Admission::kRejected;
+    }
+
+    // Registered before the slot check, so a Release that misses this
+    // waiter's count cannot also miss the slot it frees
+    waiting_.fetch_add(1);
+    Admission admission;
+    while (true) {
+        if (TryTake()) {
+            admission = Admission::kAdmitted;
+            break;
+        }
+        if (cancel.cancelled()) {
+            admission = Admission::kCancelled;
+            break;
+        }
+        now = Clock::now();
+        if (now >= wait_until) {
+            admission = Admission::kRejected;
+            break;
+        }
+        slot_cv_.wait_until(lock, std::min(wait_until, now + kCancellationCheckInterval));
+    }
+    waiting_.fetch_sub(1);
+    return admission;
+}
+
+void ConcurrencyLimiter::Release() {
+    if (limit_ == 0) {
+        return;
+    }
+    active_.fetch_sub(1);
+    if (waiting_.load() > 0) {
+        // Locking orders the notification after a waiter's check-then-wait
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        slot_cv_.notify_one();
+    }
+}
+
+} // namespace gmcp
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "cancellation.h"
+
+namespace gmcp {
+
+// Bounds how many calls run at once. Callers beyond the limit queue, but
+// only when the wait they can expect fits the latency budget: the expected
+// wait is the queue ahead of them times the caller's typical service time,
+// spread over the limit. A caller whose wait would exceed the budget (or
+// its own deadline) is rejected immediately, so an overload turns into fast
+// RESOURCE_EXHAUSTED errors instead of a queue of calls that time out.
+class ConcurrencyLimiter {
+public:
+    enum class Admission {
+        kAdmitted,
+        // The wait would exceed the budget; nothing was queued
+        kRejected,
+        // The caller's token fired while it waited
+        kCancelled,
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    // `limit` 0 admits everything
+    explicit ConcurrencyLimiter(size_t limit) : limit_(limit) {}
+
+    ConcurrencyLimiter(const ConcurrencyLimiter&) = delete;
+    ConcurrencyLimiter& operator=(const ConcurrencyLimiter&) = delete;
+
+    // Take a slot, waiting at most `budget` (and never past the token's
+    // deadline). `service_ns` is the expected run time of the caller's work;
+    // 0 when unknown. Every kAdmitted must be paired with a Release.
+    Admission Acquire(int64_t service_ns, Clock::duration budget, const CancellationToken& cancel);
+    void Release();
+
+    size_t limit() const { return limit_; }
+    size_t active() const { return active_.load(std::memory_order_relaxed); }
+    size_t waiting() const { return waiting_.load(std::memory_order_relaxed); }
+
+private:
+    bool TryTake();
+
+    const size_t limit_;
+    // Uncontended calls only touch `active_`; the mutex is taken once
+    // callers have to queue
+    std::atomic<size_t> active_{0};
+    std::atomic<size_t> waiting_{0};
+    std::mutex mutex_;
+    std::condition_variable slot_cv_;
+};
+
+} // namespace gmcp
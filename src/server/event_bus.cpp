@@ -0,0 +1,291 @@
+#include "event_bus.h"
+#include <algorithm>
+#include <bit>
+
+namespace gmcp {
+
+namespace {
+
+// Initial ring size; rings double on demand up to the configured capacity
+constexpr size_t kInitialRingSize = 16;
+
+} // namespace
+
+EventBus::Subscription::Subscription(uint64_t id, const EventSubscription& request,
+                                     size_t capacity, OverflowPolicy overflow, Notifier notifier)
+    : id_(id),
+      request_(request),
+      capacity_(std::bit_ceil(std::max<size_t>(capacity, 1))),
+      overflow_(overflow),
+      notifier_(std::move(notifier)),
+      ring_(std::min(capacity_, kInitialRingSize)) {
+    filters_.assign(request_.filters().begin(), request_.filters().end());
+    std::sort(filters_.begin(), filters_.end());
+}
+
+bool EventBus::Subscription::TryPop(std::shared_ptr<const Event>* event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_ == 0) {
+        return false;
+    }
+    *event = std::move(ring_[head_]);
+    head_ = (head_ + 1) & (ring_.size() - 1);
+    --count_;
+    return true;
+}
+
+bool EventBus::Subscription::WaitPop(std::shared_ptr<const Event>* event,
+                                     std::chrono::milliseconds max_wait) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!cv_.wait_for(lock, max_wait, [this] { return count_ > 0 || closed_; }) ||
+        count_ == 0) {
+        return false;
+    }
+    *event = std::move(ring_[head_]);
+    head_ = (head_ + 1) & (ring_.size() - 1);
+    --count_;
+    return true;
+}
+
+bool EventBus::Subscription::closed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closed_;
+}
+
+uint64_t EventBus::Subscription::dropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+size_t EventBus::Subscription::depth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+bool EventBus::Subscription::MatchesFilters(const Event& event) const {
+    // The anchor pair already matched through the index
+    for (size_t i = 1; i < filters_.size(); ++i) {
+        const auto& [key, value] = filters_[i];
+        auto it = event.metadata().find(key);
+        if (it == event.metadata().end() || it->second != value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void EventBus::Subscription::Push(const std::shared_ptr<const Event>& event) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return;
+        }
+        if (count_ == ring_.size() && ring_.size() < capacity_) {
+            // Grow, unrolling the ring so the oldest event lands at index 0
+            std::vector<std::shared_ptr<const Event>> grown(ring_.size() * 2);
+            for (size_t i = 0; i < count_; ++i) {
+                grown[i] = std::move(ring_[(head_ + i) & (ring_.size() - 1)]);
+            }
+            ring_ = std::move(grown);
+            head_ = 0;
+        }
+        const size_t mask = ring_.size() - 1;
+        if (count_ == ring_.size()) {
+            if (overflow_ == OverflowPolicy::kDisconnect) {
+                closed_ = true;
+                overflowed_ = true;
+            } else {
+                // Overwrite the oldest event
+                ring_[head_] = event;
+                head_ = (head_ + 1) & mask;
+                ++dropped_;
+            }
+        } else {
+            ring_[(head_ + count_) & mask] = event;
+            ++count_;
+        }
+    }
+    cv_.notify_one();
+    if (notifier_) {
+        notifier_();
+    }
+}
+
+void EventBus::Subscription::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    cv_.notify_all();
+    if (notifier_) {
+        notifier_();
+    }
+}
+
+EventBus::EventBus() : EventBus(Options()) {
+}
+
+EventBus::EventBus(const Options& options) : options_(options) {
+}
+
+EventBus::~EventBus() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (const auto& [id, subscriber] : subscribers_) {
+        subscriber->Close();
+    }
+}
+
+std::string EventBus::AnchorKey(const std::string& key, const std::string& value) {
+    std::string anchor;
+    anchor.reserve(key.size() + 1 + value.size());
+    anchor.append(key).push_back('\0');
+    anchor.append(value);
+    return anchor;
+}
+
+std::string EventBus::Bucket::AnchorOf(const Subscription& subscription) {
+    // The smallest key, so the choice does not depend on map order
+    const auto& [key, value] = subscription.filters_.front();
+    return AnchorKey(key, value);
+}
+
+void EventBus::Bucket::Add(Subscription* subscription) {
+    if (subscription->filters_.empty()) {
+        unfiltered.push_back(subscription);
+    } else {
+        by_anchor[AnchorOf(*subscription)].push_back(subscription);
+    }
+}
+
+void EventBus::Bucket::Remove(Subscription* subscription) {
+    auto erase_from = [subscription](std::vector<Subscription*>& list) {
+        auto it = std::find(list.begin(), list.end(), subscription);
+        if (it != list.end()) {
+            *it = list.back();
+            list.pop_back();
+        }
+    };
+    if (subscription->filters_.empty()) {
+        erase_from(unfiltered);
+        return;
+    }
+    auto it = by_anchor.find(AnchorOf(*subscription));
+    if (it != by_anchor.end()) {
+        erase_from(it->second);
+        if (it->second.empty()) {
+            by_anchor.erase(it);
+        }
+    }
+}
+
+std::shared_ptr<EventBus::Subscription> EventBus::Subscribe(const EventSubscription& request,
+                                                            Subscription::Notifier notifier) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto subscription = std::make_shared<Subscription>(
+        next_id_++, request, options_.queue_capacity, options_.overflow, std::move(notifier));
+    subscribers_.emplace(subscription->id_, subscription);
+    
+    if (request.event_types_size() == 0) {
+        any_type_.Add(subscription.get());
+    } else {
+        std::vector<std::string> types(request.event_types().begin(),
+                                       request.event_types().end());
+        std::sort(types.begin(), types.end());
+        types.erase(std::unique(types.begin(), types.end()), types.end());
+        for (const auto& type : types) {
+            by_type_[type].Add(subscription.get());
+        }
+    }
+    return subscription;
+}
+
+void EventBus::Unsubscribe(const std::shared_ptr<Subscription>& subscription) {
+    // Exclusive lock waits out any publish still delivering to this subscriber
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (subscribers_.erase(subscription->id_) == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> subscription_lock(subscription->mutex_);
+        departed_dropped_ += subscription->dropped_;
+        departed_disconnects_ += subscription->overflowed_ ? 1 : 0;
+    }
+    
+    const auto& types = subscription->request().event_types();
+    if (types.empty()) {
+        any_type_.Remove(subscription.get());
+        return;
+    }
+    for (const auto& type : types) {
+        auto it = by_type_.find(type);
+        if (it == by_type_.end()) {
+            continue;  // Duplicate type already handled
+        }
+        it->second.Remove(subscription.get());
+        if (it->second.empty()) {
+            by_type_.erase(it);
+        }
+    }
+}
+
+void EventBus::Deliver(const Bucket& bucket, const Event& event,
+                       const std::shared_ptr<const Event>& shared_event) {
+    for (Subscription* subscriber : bucket.unfiltered) {
+        subscriber->Push(shared_event);
+    }
+    if (bucket.by_anchor.empty()) {
+        return;
+    }
+    // Only subscribers anchored on a pair this event carries can match
+    std::string anchor;
+    for (const auto& [key, value] : event.metadata()) {
+        anchor.assign(key).push_back('\0');
+        anchor.append(value);
+        auto it = bucket.by_anchor.find(anchor);
+        if (it == bucket.by_anchor.end()) {
+            continue;
+        }
+        for (Subscription* subscriber : it->second) {
+            if (subscriber->MatchesFilters(event)) {
+                subscriber->Push(shared_event);
+            }
+        }
+    }
+}
+
+void EventBus::Publish(const Event& event) {
+    // One immutable copy shared by every subscriber queue
+    auto shared_event = std::make_shared<const Event>(event);
+    published_.fetch_add(1, std::memory_order_relaxed);
+    
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = by_type_.find(event.event_type());
+    if (it != by_type_.end()) {
+        Deliver(it->second, event, shared_event);
+    }
+    Deliver(any_type_, event, shared_event);
+}
+
+size_t EventBus::subscriber_count() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return subscribers_.size();
+}
+
+EventBus::Stats EventBus::stats() const {
+    Stats stats;
+    stats.published = published_.load(std::memory_order_relaxed);
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    stats.subscribers = subscribers_.size();
+    stats.dropped = departed_dropped_;
+    stats.overflow_disconnects = departed_disconnects_;
+    for (const auto& [id, subscriber] : subscribers_) {
+        std::lock_guard<std::mutex> subscription_lock(subscriber->mutex_);
+        stats.dropped += subscriber->dropped_;
+        stats.overflow_disconnects += subscriber->overflowed_ ? 1 : 0;
+        stats.queued += subscriber->count_;
+        stats.max_queue_depth = std::max(stats.max_queue_depth, subscriber->count_);
+    }
+    return stats;
+}
+
+} // namespace gmcp
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "gmcp.grpc.pb.h"
+
+namespace gmcp {
+
+// What a publisher does when a subscriber's queue is full
+enum class OverflowPolicy {
+    kDropOldest,  // Overwrite the oldest queued event and count a drop
+    kDisconnect,  // Close the subscription; the subscriber must reconnect
+};
+
+// Fan-out event bus. Every subscriber owns a bounded ring of shared,
+// immutable events, so each subscriber sees every matching event, and a
+// publisher only ever takes a subscriber's ring lock briefly: it never
+// waits for a slow consumer.
+//
+// Matching happens once, at publish time, through an index: subscribers are
+// bucketed by event type (or "any type"), and within a bucket by one anchor
+// `filters` key/value pair. A publish visits only the buckets for the
+// event's type and the anchors present in its metadata, so its cost follows
+// the number of candidate subscribers rather than the total.
+class EventBus {
+public:
+    struct Options {
+        // Events buffered per subscriber (rounded up to a power of two)
+        size_t queue_capacity = 1024;
+        OverflowPolicy overflow = OverflowPolicy::kDropOldest;
+    };
+
+    struct Stats {
+        size_t subscribers = 0;
+        uint64_t published = 0;
+        // Events overwritten by drop-oldest, including departed subscribers
+        uint64_t dropped = 0;
+        // Subscribers closed by the disconnect policy
+        uint64_t overflow_disconnects = 0;
+        // Events queued across all subscribers, and the deepest single queue
+        size_t queued = 0;
+        size_t max_queue_depth = 0;
+    };
+
+    class Subscription {
+    public:
+        // Invoked after an event is queued (or the subscription closes)
+        using Notifier = std::function<void()>;
+
+        Subscription(uint64_t id, const EventSubscription& request, size_t capacity,
+                     OverflowPolicy overflow, Notifier notifier);
+
+        // Pop the next queued event; false if the queue is empty
+        bool TryPop(std::shared_ptr<const Event>* event);
+
+        // Wait up to `max_wait` for an event. Publishing wakes the waiter
+        // directly; the bound only lets callers check for cancellation.
+        bool WaitPop(std::shared_ptr<const Event>* event, std::chrono::milliseconds max_wait);
+
+        // True once the subscription was disconnected by overflow or shutdown
+        bool closed() const;
+
+        // Events discarded by the drop-oldest policy
+        uint64_t dropped() const;
+
+        // Events currently queued
+        size_t depth() const;
+
+        const EventSubscription& request() const { return request_; }
+
+    private:
+        friend class EventBus;
+
+        // True if the event carries every filter pair after the anchor
+        bool MatchesFilters(const Event& event) const;
+        void Push(const std::shared_ptr<const Event>& event);
+        void Close();
+
+        const uint64_t id_;
+        const EventSubscription request_;
+        // `filters` sorted by key; the first pair is the index anchor
+        std::vector<std::pair<std::string, std::string>> filters_;
+        const size_t capacity_;
+        const OverflowPolicy overflow_;
+        const Notifier notifier_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable cv_;
+        // Grows by doubling up to capacity_, so idle subscribers stay small
+        std::vector<std::shared_ptr<const Event>> ring_;
+        size_t head_ = 0;
+        size_t count_ = 0;
+        uint64_t dropped_ = 0;
+        bool closed_ = false;
+        bool overflowed_ = false;
+    };
+
+    EventBus();
+    explicit EventBus(const Options& options);
+    ~EventBus();
+
+    // Add a subscriber. `notifier`, if set, is called from the publishing
+    // thread after each delivery; it is never called once Unsubscribe returns.
+    std::shared_ptr<Subscription> Subscribe(const EventSubscription& request,
+                                            Subscription::Notifier notifier = nullptr);
+    void Unsubscribe(const std::shared_ptr<Subscription>& subscription);
+
+    // Deliver an event to every matching subscriber
+    void Publish(const Event& event);
+
+    size_t subscriber_count() const;
+
+    // Point-in-time totals; walks every subscriber, so meant for stats polling
+    Stats stats() const;
+
+private:
+    // Subscribers sharing an event type (or matching any type)
+    struct Bucket {
+        // Subscribers without filters
+        std::vector<Subscription*> unfiltered;
+        // Anchor "key\0value" -> subscribers whose smallest filter key is that pair
+        std::unordered_map<std::string, std::vector<Subscription*>> by_anchor;
+
+        // Anchor pair of a subscriber that has filters
+        static std::string AnchorOf(const Subscription& subscription);
+
+        void Add(Subscription* subscription);
+        void Remove(Subscription* subscription);
+        bool empty() const { return unfiltered.empty() && by_anchor.empty(); }
+    };
+
+    static std::string AnchorKey(const std::string& key, const std::string& value);
+    static void Deliver(const Bucket& bucket, const Event& event,
+                        const std::shared_ptr<const Event>& shared_event);
+
+    const Options options_;
+
+    mutable std::shared_mutex mutex_;
+    uint64_t next_id_ = 1;
+    std::atomic<uint64_t> published_{0};
+    // Totals carried over from unsubscribed subscribers
+    uint64_t departed_dropped_ = 0;
+    uint64_t departed_disconnects_ = 0;
+    std::unordered_map<uint64_t, std::shared_ptr<Subscription>> subscribers_;
+    std::unordered_map<std::string, Bucket> by_type_;
+    Bucket any_type_;
+};
+
+} // namespace gmcp
@@ -0,0 +1,139 @@
+#include "executor.h"
+#include <algorithm>
+
+namespace gmcp {
+
+namespace {
+
+// Identifies the executor and queue of the current worker thread, if any
+thread_local const WorkStealingExecutor* current_executor = nullptr;
+thread_local size_t current_queue = 0;
+
+} // namespace
+
+WorkStealingExecutor::WorkStealingExecutor(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        queues_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers_.emplace_back(&WorkStealingExecutor::WorkerLoop, this, i);
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    sleep_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void WorkStealingExecutor::Submit(Task task) {
+    size_t index = current_executor == this
+        ? current_queue
+        : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    // Counted before it is visible so a thief can never drive pending_ below zero
+    pending_.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    
+    // Taking the lock orders this wakeup after a sleeper's predicate check
+    { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+    sleep_cv_.notify_one();
+}
+
+void WorkStealingExecutor::ParallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    
+    // Helpers may start after the caller returned; they then claim nothing
+    // and never touch `body`, but the counters must outlive the call
+    struct State {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    auto state = std::make_shared<State>();
+    const std::function<void(size_t)>* body_ptr = &body;
+    
+    auto run = [state, body_ptr, count] {
+        size_t index;
+        while ((index = state->next.fetch_add(1, std::memory_order_relaxed)) < count) {
+            (*body_ptr)(index);
+            if (state->done.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->cv.notify_all();
+            }
+        }
+    };
+    
+    size_t helpers = std::min(count - 1, workers_.size());
+    for (size_t i = 0; i < helpers; ++i) {
+        Submit(run);
+    }
+    run();
+    
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&] { return state->done.load(std::memory_order_acquire) == count; });
+}
+
+void WorkStealingExecutor::WorkerLoop(size_t index) {
+    current_executor = this;
+    current_queue = index;
+    
+    Task task;
+    while (true) {
+        if (PopLocal(index, &task) || Steal(index, &task)) {
+            pending_.fetch_sub(1, std::memory_order_acq_rel);
+            task();
+            task = nullptr;
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.wait(lock, [this] {
+            return stopping_ || pending_.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping_ && pending_.load(std::memory_order_acquire) == 0) {
+            break;
+        }
+    }
+    
+    current_executor = nullptr;
+}
+
+bool WorkStealingExecutor::PopLocal(size_t index, Task* task) {
+    Worker& worker = *queues_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    *task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingExecutor::Steal(size_t thief, Task* task) {
+    for (size_t offset = 1; offset < queues_.size(); ++offset) {
+        Worker& victim = *queues_[(thief + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            *task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace gmcp
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gmcp {
+
+// Fixed-size thread pool with per-worker task deques and work stealing.
+//
+// Tasks submitted from a worker thread go to that worker's own deque and are
+// popped LIFO (cache-warm); tasks from other threads are spread round-robin.
+// An idle worker steals the oldest task from a sibling before sleeping.
+class WorkStealingExecutor {
+public:
+    using Task = std::function<void()>;
+
+    // `num_threads` of 0 uses the hardware concurrency
+    explicit WorkStealingExecutor(size_t num_threads = 0);
+    ~WorkStealingExecutor();
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    // Queue a task for execution
+    void Submit(Task task);
+
+    // Run body(0..count-1) in parallel and wait for all of them. The calling
+    // thread claims indices too, so this is safe to call from a worker.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    size_t thread_count() const { return workers_.size(); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void WorkerLoop(size_t index);
+    bool PopLocal(size_t index, Task* task);
+    bool Steal(size_t thief, Task* task);
+
+    std::vector<std::unique_ptr<Worker>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> next_queue_{0};
+    std::atomic<size_t> pending_{0};
+
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    bool stopping_ = false;
+};
+
+} // namespace gmcp
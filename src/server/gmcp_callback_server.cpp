@@ -0,0 +1,449 @@
+#include "gmcp_callback_server.h"
+#include <deque>
+#include <mutex>
+#include "common/logging.h"
+#include "message_arena_pool.h"
+
+namespace gmcp {
+
+namespace {
+
+// Dispatches each agent message to the shared executor and writes replies
+// in completion order. Reading pauses while the stream's in-flight window is
+// full; at most one read and one write are outstanding, as the callback API
+// requires. Each message is read into a pooled arena slot that also holds its
+// reply, and the slot is recycled once the reply is written.
+class AgentStreamReactor final : public grpc::ServerBidiReactor<AgentMessage, AgentMessage> {
+public:
+    AgentStreamReactor(AgentCoordinator* coordinator, grpc::CallbackServerContext* context)
+        : coordinator_(coordinator),
+          window_(coordinator->stream_window()),
+          active_(coordinator->metrics().active_agent_streams),
+          cancel_(AgentCoordinator::DeadlineOf(context)) {
+        GMCP_LOG(kDebug) << "New agent connected for bidirectional streaming";
+        StartNextRead();
+    }
+
+    void OnReadDone(bool ok) override {
+        // Take the slot first: a completion may start the next read as soon as
+        // the lock is released
+        MessageArenaPool::Slot* slot = reading_;
+        
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!ok || finished_ || write_failed_) {
+            // Client finished sending (or the stream broke)
+            arenas_.Release(slot);
+            reads_done_ = true;
+            MaybeFinish(lock);
+            return;
+        }
+        ++in_flight_;
+        bool read_next = in_flight_ < window_;
+        read_paused_ = !read_next;
+        lock.unlock();
+
+        GMCP_LOG(kDebug) << "Received message from agent: " << slot->request()->agent_id();
+
+        coordinator_->executor().Submit([this, slot] {
+            bool has_response = coordinator_->HandleAgentMessage(*slot->request(),
+                                                                 slot->response(), cancel_);
+            OnProcessed(slot, has_response);
+        });
+        if (read_next) {
+            StartNextRead();
+        }
+    }
+
+    void OnWriteDone(bool ok) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        arenas_.Release(pending_writes_.front());
+        pending_writes_.pop_front();
+        if (!ok) {
+            // Client is gone; drop anything still queued
+            for (MessageArenaPool::Slot* dropped : pending_writes_) {
+                arenas_.Release(dropped);
+            }
+            pending_writes_.clear();
+            write_failed_ = true;
+        }
+        if (!pending_writes_.empty()) {
+            const AgentMessage* to_write = pending_writes_.front()->response();
+            lock.unlock();
+            StartWrite(to_write);
+            return;
+        }
+        writing_ = false;
+        MaybeFinish(lock);
+    }
+
+    // Tools still running for this stream stop waiting; their results are
+    // dropped as writes fail
+    void OnCancel() override { cancel_.Cancel(); }
+
+    void OnDone() override {
+        GMCP_LOG(kDebug) << "Agent disconnected";
+        delete this;
+    }
+
+private:
+    void StartNextRead() {
+        reading_ = arenas_.Acquire();
+        StartRead(reading_->request());
+    }
+
+    // Runs on an executor thread once a message has been handled
+    void OnProcessed(MessageArenaPool::Slot* slot, bool has_response) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        --in_flight_;
+        const AgentMessage* to_write = nullptr;
+        if (has_response && !write_failed_) {
+            pending_writes_.push_back(slot);
+            if (!writing_) {
+                writing_ = true;
+                to_write = pending_writes_.front()->response();
+            }
+        } else {
+            arenas_.Release(slot);
+        }
+        bool resume_read = read_paused_ && !finished_ && !write_failed_;
+        if (resume_read) {
+            read_paused_ = false;
+        }
+        if (!to_write && !resume_read) {
+            MaybeFinish(lock);
+            return;
+        }
+        lock.unlock();
+        if (to_write) {
+            StartWrite(to_write);
+        }
+        if (resume_read) {
+            StartNextRead();
+        }
+    }
+
+    // Finishes once reads are over, no message is in flight and the write
+    // queue has drained; releases the lock before calling into gRPC
+    void MaybeFinish(std::unique_lock<std::mutex>& lock) {
+        bool input_over = reads_done_ || (write_failed_ && read_paused_);
+        if (!input_over || in_flight_ > 0 || writing_ || finished_) {
+            return;
+        }
+        finished_ = true;
+        grpc::Status status = write_failed_ ? grpc::Status::CANCELLED : grpc::Status::OK;
+        lock.unlock();
+        Finish(status);
+    }
+
+    AgentCoordinator* coordinator_;
+    const size_t window_;
+    ScopedGauge active_;
+    // Fires on OnCancel or at the call's deadline
+    CancellationToken cancel_;
+    MessageArenaPool arenas_;
+    // Slot the outstanding read fills
+    MessageArenaPool::Slot* reading_ = nullptr;
+
+    std::mutex mutex_;
+    // Replies in write order; the front one is being written
+    std::deque<MessageArenaPool::Slot*> pending_writes_;
+    size_t in_flight_ = 0;
+    bool read_paused_ = false;
+    bool writing_ = false;
+    bool reads_done_ = false;
+    bool write_failed_ = false;
+    bool finished_ = false;
+};
+
+// Writes events from this subscriber's queue; woken directly by publishers
+// instead of polling.
+class EventWriterReactor final : public grpc::ServerWriteReactor<Event> {
+public:
+    EventWriterReactor(AgentCoordinator* coordinator, const EventSubscription& request)
+        : bus_(&coordinator->event_bus()), active_(coordinator->metrics().active_event_streams) {
+        GMCP_LOG(kDebug) << "Agent " << request.agent_id() << " subscribed to events";
+        // Subscribe outside mutex_: the notifier may run before we store the result
+        auto subscription = bus_->Subscribe(request, [this] { WriteNext(); });
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            subscription_ = std::move(subscription);
+        }
+        WriteNext();
+    }
+
+    void OnWriteDone(bool ok) override {
+        if (!ok) {
+            FinishOnce(grpc::Status::CANCELLED);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            writing_ = false;
+        }
+        WriteNext();
+    }
+
+    void OnCancel() override {
+        FinishOnce(grpc::Status::CANCELLED);
+    }
+
+    void OnDone() override {
+        bus_->Unsubscribe(subscription_);
+        delete this;
+    }
+
+private:
+    void WriteNext() {
+        bool overflowed = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (writing_ || finished_ || !subscription_) {
+                return;
+            }
+            if (subscription_->TryPop(&current_)) {
+                writing_ = true;
+            } else if (subscription_->closed()) {
+                overflowed = true;
+            } else {
+                return;
+            }
+        }
+        if (overflowed) {
+            FinishOnce(grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                    "Event queue overflowed; subscriber disconnected"));
+            return;
+        }
+        StartWrite(current_.get());
+    }
+
+    void FinishOnce(const grpc::Status& status) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (finished_) {
+                return;
+            }
+            finished_ = true;
+        }
+        Finish(status);
+    }
+
+    EventBus* bus_;
+    ScopedGauge active_;
+
+    std::mutex mutex_;
+    std::shared_ptr<EventBus::Subscription> subscription_;
+    std::shared_ptr<const Event> current_;
+    bool writing_ = false;
+    bool finished_ = false;
+};
+
+// Reads a bulk ingest stream; each read is buffered into the session, which
+// applies full batches to the store before the next read is started. Adding
+// may flush a batch (and wait for the WAL), so it runs on the executor and the
+// next read is started from there.
+class IngestReactor final : public grpc::ServerReadReactor<MemoryWrite> {
+public:
+    IngestReactor(AgentCoordinator* coordinator, IngestSummary* response)
+        : coordinator_(coordinator), session_(coordinator->BeginIngest()), response_(response) {
+        StartRead(&write_);
+    }
+
+    void OnReadDone(bool ok) override {
+        coordinator_->executor().Submit([this, ok] {
+            if (!ok) {
+                *response_ = session_.Finish();
+                Finish(grpc::Status::OK);
+                return;
+            }
+            session_.Add(std::move(write_));
+            write_.Clear();
+            StartRead(&write_);
+        });
+    }
+
+    void OnDone() override {
+        delete this;
+    }
+
+private:
+    AgentCoordinator* coordinator_;
+    AgentCoordinator::IngestSession session_;
+    IngestSummary* response_;
+    MemoryWrite write_;
+};
+
+// Streams a query one chunk at a time. Each chunk is computed on the
+// executor and the next one only once the previous write has completed, so
+// a slow reader holds back the scan instead of buffering it.
+class QueryStreamReactor final : public grpc::ServerWriteReactor<MemoryResult> {
+public:
+    QueryStreamReactor(AgentCoordinator* coordinator, const MemoryQuery& query)
+        : coordinator_(coordinator), stream_(coordinator->BeginQueryStream(query)) {
+        NextChunk();
+    }
+
+    void OnWriteDone(bool ok) override {
+        if (!ok) {
+            Finish(grpc::Status::CANCELLED);
+            return;
+        }
+        NextChunk();
+    }
+
+    void OnDone() override {
+        delete this;
+    }
+
+private:
+    void NextChunk() {
+        coordinator_->executor().Submit([this] {
+            if (stream_.Next(&chunk_)) {
+                StartWrite(&chunk_);
+            } else {
+                Finish(grpc::Status::OK);
+            }
+        });
+    }
+
+    AgentCoordinator* coordinator_;
+    AgentCoordinator::QueryStream stream_;
+    MemoryResult chunk_;
+};
+
+} // namespace
+
+AgentCoordinationCallbackServiceImpl::AgentCoordinationCallbackServiceImpl(
+    std::shared_ptr<AgentCoordinator> coordinator)
+    : coordinator_(std::move(coordinator)) {
+}
+
+AgentCoordinationCallbackServiceImpl::~AgentCoordinationCallbackServiceImpl() = default;
+
+grpc::ServerBidiReactor<AgentMessage, AgentMessage>*
+AgentCoordinationCallbackServiceImpl::StreamAgentMessages(grpc::CallbackServerContext* context) {
+    return new AgentStreamReactor(coordinator_.get(), context);
+}
+
+grpc::ServerUnaryReactor* AgentCoordinationCallbackServiceImpl::RegisterTool(
+    grpc::CallbackServerContext* context,
+    const ToolRegistration* request,
+    RegistrationResponse* response) {
+    
+    coordinator_->RegisterTool(*request, response);
+    auto* reactor = context->DefaultReactor();
+    reactor->Finish(grpc::Status::OK);
+    return reactor;
+}
+
+grpc::ServerUnaryReactor* AgentCoordinationCallbackServiceImpl::RegisterMemory(
+    grpc::CallbackServerContext* context,
+    const MemoryRegistration* request,
+    RegistrationResponse* response) {
+    
+    coordinator_->RegisterMemory(*request, response);
+    auto* reactor = context->DefaultReactor();
+    reactor->Finish(grpc::Status::OK);
+    return reactor;
+}
+
+grpc::ServerUnaryReactor* AgentCoordinationCallbackServiceImpl::InvokeTool(
+    grpc::CallbackServerContext* context,
+    const ToolInvocation* request,
+    ToolResult* response) {
+    
+    // Tools may be slow; keep them off gRPC's callback threads
+    auto* reactor = context->DefaultReactor();
+    coordinator_->executor().Submit([this, context, request, response, reactor] {
+        reactor->Finish(
+            coordinator_->InvokeTool(*request, response, AgentCoordinator::TokenFor(context)));
+    });
+    return reactor;
+}
+
+grpc::ServerUnaryReactor* AgentCoordinationCallbackServiceImpl::QueryMemory(
+    grpc::CallbackServerContext* context,
+    const MemoryQuery* request,
+    MemoryResult* response) {
+    
+    // Scans and graph walks are unbounded work; keep them off gRPC's
+    // callback threads
+    auto* reactor = context->DefaultReactor();
+    coordinator_->executor().Submit([this, request, response, reactor] {
+        coordinator_->QueryMemory(*request, response);
+        reactor->Finish(grpc::Status::OK);
+    });
+    return reactor;
+}
+
+grpc::ServerUnaryReactor* AgentCoordinationCallbackServiceImpl::InvokeToolBatch(
+    grpc::CallbackServerContext* context,
+    const ToolInvocationBatch* request,
+    ToolResultBatch* response) {
+    
+    // The submitting worker runs entries alongside the executor's other workers
+    auto* reactor = context->DefaultReactor();
+    coordinator_->executor().Submit([this, context, request, response, reactor] {
+        coordinator_->InvokeToolBatch(*request, response, AgentCoordinator::TokenFor(context));
+        reactor->Finish(grpc::Status::OK);
+    });
+    return reactor;
+}
+
+grpc::ServerUnaryReactor* AgentCoordinationCallbackServiceImpl::QueryMemoryBatch(
+    grpc::CallbackServerContext* context,
+    const MemoryQueryBatch* request,
+    MemoryResultBatch* response) {
+    
+    auto* reactor = context->DefaultReactor();
+    coordinator_->executor().Submit([this, request, response, reactor] {
+        coordinator_->QueryMemoryBatch(*request, response);
+        reactor->Finish(grpc::Status::OK);
+    });
+    return reactor;
+}
+
+grpc::ServerUnaryReactor* AgentCoordinationCallbackServiceImpl::StoreMemory(
+    grpc::CallbackServerContext* context,
+    const MemoryWrite* request,
+    StoreResponse* response) {
+    
+    // Writes wait for the WAL's group commit; keep them off gRPC's callback
+    // threads
+    auto* reactor = context->DefaultReactor();
+    coordinator_->executor().Submit([this, request, response, reactor] {
+        coordinator_->StoreMemory(*request, response);
+        reactor->Finish(grpc::Status::OK);
+    });
+    return reactor;
+}
+
+grpc::ServerReadReactor<MemoryWrite>* AgentCoordinationCallbackServiceImpl::IngestMemory(
+    grpc::CallbackServerContext* context,
+    IngestSummary* response) {
+    return new IngestReactor(coordinator_.get(), response);
+}
+
+grpc::ServerWriteReactor<MemoryResult>* AgentCoordinationCallbackServiceImpl::StreamQueryMemory(
+    grpc::CallbackServerContext* context,
+    const MemoryQuery* request) {
+    return new QueryStreamReactor(coordinator_.get(), *request);
+}
+
+grpc::ServerWriteReactor<Event>* AgentCoordinationCallbackServiceImpl::SubscribeEvents(
+    grpc::CallbackServerContext* context,
+    const EventSubscription* request) {
+    return new EventWriterReactor(coordinator_.get(), *request);
+}
+
+grpc::ServerUnaryReactor* AgentCoordinationCallbackServiceImpl::GetStats(
+    grpc::CallbackServerContext* context,
+    const StatsRequest* request,
+    StatsResponse* response) {
+    
+    coordinator_->GetStats(*request, response);
+    auto* reactor = context->DefaultReactor();
+    reactor->Finish(grpc::Status::OK);
+    return reactor;
+}
+
+} // namespace gmcp
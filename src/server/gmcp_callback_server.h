@@ -0,0 +1,89 @@
+#pragma once
+
+#include <grpcpp/grpcpp.h>
+#include <memory>
+#include "gmcp.grpc.pb.h"
+#include "agent_coordinator.h"
+
+namespace gmcp {
+
+// Callback (reactor) based gRPC service. Streams are driven by reactions on
+// gRPC's internal callback threads instead of owning a server thread each,
+// so many thousands of idle agent streams cost only their reactor state.
+class AgentCoordinationCallbackServiceImpl final : public AgentCoordination::CallbackService {
+public:
+    explicit AgentCoordinationCallbackServiceImpl(std::shared_ptr<AgentCoordinator> coordinator);
+    ~AgentCoordinationCallbackServiceImpl() override;
+
+    // Bidirectional streaming for agent messages
+    grpc::ServerBidiReactor<AgentMessage, AgentMessage>* StreamAgentMessages(
+        grpc::CallbackServerContext* context) override;
+
+    // Tool registration
+    grpc::ServerUnaryReactor* RegisterTool(
+        grpc::CallbackServerContext* context,
+        const ToolRegistration* request,
+        RegistrationResponse* response) override;
+
+    // Memory registration
+    grpc::ServerUnaryReactor* RegisterMemory(
+        grpc::CallbackServerContext* context,
+        const MemoryRegistration* request,
+        RegistrationResponse* response) override;
+
+    // Tool invocation
+    grpc::ServerUnaryReactor* InvokeTool(
+        grpc::CallbackServerContext* context,
+        const ToolInvocation* request,
+        ToolResult* response) override;
+
+    // Memory query
+    grpc::ServerUnaryReactor* QueryMemory(
+        grpc::CallbackServerContext* context,
+        const MemoryQuery* request,
+        MemoryResult* response) override;
+
+    // Batched tool invocation
+    grpc::ServerUnaryReactor* InvokeToolBatch(
+        grpc::CallbackServerContext* context,
+        const ToolInvocationBatch* request,
+        ToolResultBatch* response) override;
+
+    // Batched memory query
+    grpc::ServerUnaryReactor* QueryMemoryBatch(
+        grpc::CallbackServerContext* context,
+        const MemoryQueryBatch* request,
+        MemoryResultBatch* response) override;
+
+    // Memory write
+    grpc::ServerUnaryReactor* StoreMemory(
+        grpc::CallbackServerContext* context,
+        const MemoryWrite* request,
+        StoreResponse* response) override;
+
+    // Bulk memory ingest
+    grpc::ServerReadReactor<MemoryWrite>* IngestMemory(
+        grpc::CallbackServerContext* context,
+        IngestSummary* response) override;
+
+    // Chunked memory query results
+    grpc::ServerWriteReactor<MemoryResult>* StreamQueryMemory(
+        grpc::CallbackServerContext* context,
+        const MemoryQuery* request) override;
+
+    // Event subscription
+    grpc::ServerWriteReactor<Event>* SubscribeEvents(
+        grpc::CallbackServerContext* context,
+        const EventSubscription* request) override;
+
+    // Server metrics snapshot
+    grpc::ServerUnaryReactor* GetStats(
+        grpc::CallbackServerContext* context,
+        const StatsRequest* request,
+        StatsResponse* response) override;
+
+private:
+    std::shared_ptr<AgentCoordinator> coordinator_;
+};
+
+} // namespace gmcp
@@ -1,13 +1,21 @@
 #include "gmcp_server.h"
-#include <iostream>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <thread>
+#include "common/logging.h"
+#include "message_arena_pool.h"
 
 namespace gmcp {
 
-AgentCoordinationServiceImpl::AgentCoordinationServiceImpl() 
-    : tool_manager_(std::make_unique<ToolManager>()),
-      memory_manager_(std::make_unique<MemoryManager>()) {
+AgentCoordinationServiceImpl::AgentCoordinationServiceImpl()
+    : AgentCoordinationServiceImpl(std::make_shared<AgentCoordinator>()) {
+}
+
+AgentCoordinationServiceImpl::AgentCoordinationServiceImpl(
+    std::shared_ptr<AgentCoordinator> coordinator)
+    : coordinator_(std::move(coordinator)) {
 }
 
 AgentCoordinationServiceImpl::~AgentCoordinationServiceImpl() = default;
@@ -16,63 +24,100 @@ grpc::Status AgentCoordinationServiceImpl::StreamAgentMessages(
     grpc::ServerContext* context,
     grpc::ServerReaderWriter<AgentMessage, AgentMessage>* stream) {
     
-    std::cout << "New agent connected for bidirectional streaming" << std::endl;
+    GMCP_LOG(kDebug) << "New agent connected for bidirectional streaming";
+    ScopedGauge active(coordinator_->metrics().active_agent_streams);
+    // Tools invoked on the stream stop waiting once the client goes away
+    CancellationToken cancel = AgentCoordinator::TokenFor(context);
     
-    AgentMessage message;
-    while (stream->Read(&message)) {
-        std::cout << "Received message from agent: " << message.agent_id() << std::endl;
-        
-        // Process message based on type
-        AgentMessage response;
-        response.set_agent_id("server");
-        response.set_timestamp(
-            std::chrono::system_clock::now().time_since_epoch().count());
-        
-        switch (message.type()) {
-            case MessageType::TOOL_INVOCATION: {
-                if (message.has_tool_invocation()) {
-                    ToolResult result = tool_manager_->InvokeTool(message.tool_invocation());
-                    response.set_type(MessageType::TOOL_RESULT);
-                    *response.mutable_tool_result() = result;
-                    stream->Write(response);
-                }
+    // Messages are processed on the shared executor and may complete out of
+    // order. Executor tasks only queue finished replies; the stream's own
+    // writer thread drains the outbox, so a client that stops reading parks
+    // that thread in Write, never a shared worker. Each message and its reply
+    // live on one pooled arena slot until written.
+    MessageArenaPool arenas;
+    struct StreamState {
+        std::mutex mutex;
+        // Signalled when a reply is queued, a message completes or reading ends
+        std::condition_variable cv;
+        // Messages read but not yet answered and written
+        size_t in_flight = 0;
+        std::deque<MessageArenaPool::Slot*> outbox;
+        bool reading_done = false;
+        bool write_failed = false;
+    } state;
+    
+    auto complete = [&state, &arenas](MessageArenaPool::Slot* slot, bool has_response) {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (has_response) {
+            state.outbox.push_back(slot);
+        } else {
+            arenas.Release(slot);
+            --state.in_flight;
+        }
+        state.cv.notify_all();
+    };
+    
+    std::thread writer([&state, &arenas, stream] {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        while (true) {
+            state.cv.wait(lock, [&] {
+                return !state.outbox.empty() || (state.reading_done && state.in_flight == 0);
+            });
+            if (state.outbox.empty()) {
                 break;
             }
-            
-            case MessageType::MEMORY_QUERY: {
-                if (message.has_memory_query()) {
-                    MemoryResult result = memory_manager_->Query(message.memory_query());
-                    response.set_type(MessageType::MEMORY_RESULT);
-                    *response.mutable_memory_result() = result;
-                    stream->Write(response);
-                }
-                break;
+            MessageArenaPool::Slot* next = state.outbox.front();
+            state.outbox.pop_front();
+            bool failed = state.write_failed;
+            lock.unlock();
+            // After a failed write the remaining replies are dropped
+            bool ok = !failed && stream->Write(*next->response());
+            arenas.Release(next);
+            lock.lock();
+            if (!ok) {
+                state.write_failed = true;
             }
-            
-            case MessageType::TEXT: {
-                // Echo back text messages
-                response.set_type(MessageType::TEXT);
-                response.set_text_message("Echo: " + message.text_message());
-                stream->Write(response);
+            --state.in_flight;
+            state.cv.notify_all();
+        }
+    });
+    
+    const size_t window = coordinator_->stream_window();
+    while (true) {
+        MessageArenaPool::Slot* slot = arenas.Acquire();
+        if (!stream->Read(slot->request())) {
+            arenas.Release(slot);
+            break;
+        }
+        GMCP_LOG(kDebug) << "Received message from agent: " << slot->request()->agent_id();
+        
+        {
+            std::unique_lock<std::mutex> lock(state.mutex);
+            state.cv.wait(lock, [&] { return state.in_flight < window; });
+            if (state.write_failed) {
+                arenas.Release(slot);
                 break;
             }
-            
-            default:
-                std::cout << "Unknown message type" << std::endl;
-                break;
+            ++state.in_flight;
         }
         
-        // Publish event for this message
-        Event event;
-        event.set_event_id("evt_" + std::to_string(message.timestamp()));
-        event.set_event_type("message_received");
-        event.set_source_agent_id(message.agent_id());
-        event.set_timestamp(
-            std::chrono::system_clock::now().time_since_epoch().count());
-        PublishEvent(event);
+        coordinator_->executor().Submit([this, slot, &complete, &cancel] {
+            bool has_response = coordinator_->HandleAgentMessage(*slot->request(),
+                                                                 slot->response(), cancel);
+            complete(slot, has_response);
+        });
+    }
+    
+    // Tasks reference this frame; the writer exits once they have completed
+    // and every reply is written or dropped
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.reading_done = true;
     }
+    state.cv.notify_all();
+    writer.join();
     
-    std::cout << "Agent disconnected" << std::endl;
+    GMCP_LOG(kDebug) << "Agent disconnected";
     return grpc::Status::OK;
 }
 
@@ -81,26 +126,7 @@ grpc::Status AgentCoordinationServiceImpl::RegisterTool(
     const ToolRegistration* request,
     RegistrationResponse* response) {
     
-    // Create a simple example tool function
-    auto tool_func = [](const std::map<std::string, std::string>& args) -> std::string {
-        std::string result = "Tool executed with args: ";
-        for (const auto& [key, value] : args) {
-            result += key + "=" + value + ", ";
-        }
-        return result;
-    };
-    
-    bool success = tool_manager_->RegisterTool(*request, tool_func);
-    
-    response->set_success(success);
-    if (success) {
-        response->set_message("Tool registered successfully");
-        response->set_registration_id(request->tool_id());
-        std::cout << "Registered tool: " << request->name() << std::endl;
-    } else {
-        response->set_message("Tool already registered or registration failed");
-    }
-    
+    coordinator_->RegisterTool(*request, response);
     return grpc::Status::OK;
 }
 
@@ -109,17 +135,7 @@ grpc::Status AgentCoordinationServiceImpl::RegisterMemory(
     const MemoryRegistration* request,
     RegistrationResponse* response) {
     
-    bool success = memory_manager_->RegisterMemory(*request);
-    
-    response->set_success(success);
-    if (success) {
-        response->set_message("Memory store registered successfully");
-        response->set_registration_id(request->memory_id());
-        std::cout << "Registered memory store: " << request->name() << std::endl;
-    } else {
-        response->set_message("Memory store already registered or registration failed");
-    }
-    
+    coordinator_->RegisterMemory(*request, response);
     return grpc::Status::OK;
 }
 
@@ -128,8 +144,7 @@ grpc::Status AgentCoordinationServiceImpl::InvokeTool(
     const ToolInvocation* request,
     ToolResult* response) {
     
-    *response = tool_manager_->InvokeTool(*request);
-    return grpc::Status::OK;
+    return coordinator_->InvokeTool(*request, response, AgentCoordinator::TokenFor(context));
 }
 
 grpc::Status AgentCoordinationServiceImpl::QueryMemory(
@@ -137,121 +152,114 @@ grpc::Status AgentCoordinationServiceImpl::QueryMemory(
     const MemoryQuery* request,
     MemoryResult* response) {
     
-    *response = memory_manager_->Query(*request);
+    coordinator_->QueryMemory(*request, response);
     return grpc::Status::OK;
 }
 
-grpc::Status AgentCoordinationServiceImpl::SubscribeEvents(
+grpc::Status AgentCoordinationServiceImpl::InvokeToolBatch(
     grpc::ServerContext* context,
-    const EventSubscription* request,
-    grpc::ServerWriter<Event>* writer) {
-    
-    std::cout << "Agent " << request->agent_id() << " subscribed to events" << std::endl;
-    
-    // Stream events from the queue
-    while (!context->IsCancelled()) {
-        std::unique_lock<std::mutex> lock(event_mutex_);
-        event_cv_.wait_for(lock, std::chrono::seconds(1), [this] {
-            return !event_queue_.empty();
-        });
-        
-        while (!event_queue_.empty()) {
-            Event event = event_queue_.front();
-            event_queue_.pop();
-            
-            // Filter by event types if specified
-            if (request->event_types_size() > 0) {
-                bool matches = false;
-                for (const auto& type : request->event_types()) {
-                    if (event.event_type() == type) {
-                        matches = true;
-                        break;
-                    }
-                }
-                if (!matches) continue;
-            }
-            
-            lock.unlock();
-            if (!writer->Write(event)) {
-                return grpc::Status::CANCELLED;
-            }
-            lock.lock();
-        }
-    }
+    const ToolInvocationBatch* request,
+    ToolResultBatch* response) {
     
+    coordinator_->InvokeToolBatch(*request, response, AgentCoordinator::TokenFor(context));
     return grpc::Status::OK;
 }
 
-void AgentCoordinationServiceImpl::PublishEvent(const Event& event) {
-    std::lock_guard<std::mutex> lock(event_mutex_);
-    event_queue_.push(event);
-    event_cv_.notify_all();
+grpc::Status AgentCoordinationServiceImpl::QueryMemoryBatch(
+    grpc::ServerContext* context,
+    const MemoryQueryBatch* request,
+    MemoryResultBatch* response) {
+    
+    coordinator_->QueryMemoryBatch(*request, response);
+    return grpc::Status::OK;
 }
 
-void AgentCoordinationServiceImpl::InitializeExamples() {
-    // Register example tools
-    ToolRegistration calc_tool;
-    calc_tool.set_tool_id("calculator");
-    calc_tool.set_name("Calculator");
-    calc_tool.set_description("Performs basic arithmetic operations");
-    calc_tool.set_return_type("string");
-    
-    auto param1 = calc_tool.add_parameters();
-    param1->set_name("operation");
-    param1->set_type("string");
-    param1->set_required(true);
-    param1->set_description("Operation to perform: add, subtract, multiply, divide");
+grpc::Status AgentCoordinationServiceImpl::StoreMemory(
+    grpc::ServerContext* context,
+    const MemoryWrite* request,
+    StoreResponse* response) {
     
-    auto param2 = calc_tool.add_parameters();
-    param2->set_name("a");
-    param2->set_type("number");
-    param2->set_required(true);
-    param2->set_description("First operand");
+    coordinator_->StoreMemory(*request, response);
+    return grpc::Status::OK;
+}
+
+grpc::Status AgentCoordinationServiceImpl::IngestMemory(
+    grpc::ServerContext* context,
+    grpc::ServerReader<MemoryWrite>* reader,
+    IngestSummary* response) {
     
-    auto param3 = calc_tool.add_parameters();
-    param3->set_name("b");
-    param3->set_type("number");
-    param3->set_required(true);
-    param3->set_description("Second operand");
+    auto session = coordinator_->BeginIngest();
+    MemoryWrite write;
+    while (reader->Read(&write)) {
+        session.Add(std::move(write));
+        write.Clear();
+    }
+    *response = session.Finish();
+    return grpc::Status::OK;
+}
+
+grpc::Status AgentCoordinationServiceImpl::StreamQueryMemory(
+    grpc::ServerContext* context,
+    const MemoryQuery* request,
+    grpc::ServerWriter<MemoryResult>* writer) {
     
-    auto calc_func = [](const std::map<std::string, std::string>& args) -> std::string {
-        try {
-            double a = std::stod(args.at("a"));
-            double b = std::stod(args.at("b"));
-            std::string op = args.at("operation");
-            
-            double result = 0.0;
-            if (op == "add") result = a + b;
-            else if (op == "subtract") result = a - b;
-            else if (op == "multiply") result = a * b;
-            else if (op == "divide") result = b != 0 ? a / b : 0;
-            
-            return std::to_string(result);
-        } catch (...) {
-            return "Error: Invalid arguments";
+    auto stream = coordinator_->BeginQueryStream(*request);
+    MemoryResult chunk;
+    while (stream.Next(&chunk)) {
+        if (context->IsCancelled() || !writer->Write(chunk)) {
+            return grpc::Status::CANCELLED;
         }
-    };
+    }
+    return grpc::Status::OK;
+}
+
+grpc::Status AgentCoordinationServiceImpl::SubscribeEvents(
+    grpc::ServerContext* context,
+    const EventSubscription* request,
+    grpc::ServerWriter<Event>* writer) {
+    
+    GMCP_LOG(kDebug) << "Agent " << request->agent_id() << " subscribed to events";
     
-    tool_manager_->RegisterTool(calc_tool, calc_func);
-    std::cout << "Initialized example calculator tool" << std::endl;
+    EventBus& bus = coordinator_->event_bus();
+    auto subscription = bus.Subscribe(*request);
+    ScopedGauge active(coordinator_->metrics().active_event_streams);
     
-    // Register example memory store
-    MemoryRegistration mem_store;
-    mem_store.set_memory_id("default_store");
-    mem_store.set_name("Default Key-Value Store");
-    mem_store.set_description("Default in-memory key-value storage");
-    mem_store.set_type(MemoryType::KEY_VALUE);
+    // Publishing wakes this thread directly. The sync API has no cancellation
+    // callback, so the wait is bounded to notice a client that went away.
+    constexpr auto kCancellationCheckInterval = std::chrono::milliseconds(500);
     
-    memory_manager_->RegisterMemory(mem_store);
+    grpc::Status status = grpc::Status::OK;
+    std::shared_ptr<const Event> event;
+    while (!context->IsCancelled()) {
+        if (!subscription->WaitPop(&event, kCancellationCheckInterval)) {
+            if (subscription->closed()) {
+                status = grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                      "Event queue overflowed; subscriber disconnected");
+                break;
+            }
+            continue;
+        }
+        if (!writer->Write(*event)) {
+            status = grpc::Status::CANCELLED;
+            break;
+        }
+    }
     
-    // Add some example entries
-    MemoryEntry entry1;
-    entry1.set_key("example_key");
-    entry1.set_value("example_value");
-    entry1.set_timestamp(std::chrono::system_clock::now().time_since_epoch().count());
-    memory_manager_->Store("default_store", entry1);
+    bus.Unsubscribe(subscription);
+    return status;
+}
+
+grpc::Status AgentCoordinationServiceImpl::GetStats(
+    grpc::ServerContext* context,
+    const StatsRequest* request,
+    StatsResponse* response) {
     
-    std::cout << "Initialized example memory store" << std::endl;
+    coordinator_->GetStats(*request, response);
+    return grpc::Status::OK;
+}
+
+void AgentCoordinationServiceImpl::InitializeExamples() {
+    coordinator_->InitializeExamples();
 }
 
 } // namespace gmcp
@@ -2,18 +2,16 @@
 
 #include <grpcpp/grpcpp.h>
 #include <memory>
-#include <queue>
-#include <mutex>
-#include <condition_variable>
 #include "gmcp.grpc.pb.h"
-#include "tool_manager.h"
-#include "memory_manager.h"
+#include "agent_coordinator.h"
 
 namespace gmcp {
 
+// Synchronous gRPC service: every open stream occupies a server thread
 class AgentCoordinationServiceImpl final : public AgentCoordination::Service {
 public:
     AgentCoordinationServiceImpl();
+    explicit AgentCoordinationServiceImpl(std::shared_ptr<AgentCoordinator> coordinator);
     ~AgentCoordinationServiceImpl() override;
 
     // Bidirectional streaming for agent messages
@@ -51,19 +49,47 @@ public:
         const EventSubscription* request,
         grpc::ServerWriter<Event>* writer) override;
 
+    // Batched tool invocation
+    grpc::Status InvokeToolBatch(
+        grpc::ServerContext* context,
+        const ToolInvocationBatch* request,
+        ToolResultBatch* response) override;
+
+    // Batched memory query
+    grpc::Status QueryMemoryBatch(
+        grpc::ServerContext* context,
+        const MemoryQueryBatch* request,
+        MemoryResultBatch* response) override;
+
+    // Memory write
+    grpc::Status StoreMemory(
+        grpc::ServerContext* context,
+        const MemoryWrite* request,
+        StoreResponse* response) override;
+
+    // Bulk memory ingest
+    grpc::Status IngestMemory(
+        grpc::ServerContext* context,
+        grpc::ServerReader<MemoryWrite>* reader,
+        IngestSummary* response) override;
+
+    // Chunked memory query results
+    grpc::Status StreamQueryMemory(
+        grpc::ServerContext* context,
+        const MemoryQuery* request,
+        grpc::ServerWriter<MemoryResult>* writer) override;
+
+    // Server metrics snapshot
+    grpc::Status GetStats(
+        grpc::ServerContext* context,
+        const StatsRequest* request,
+        StatsResponse* response) override;
+
     // Initialize example tools and memory stores
     void InitializeExamples();
 
 private:
-    std::unique_ptr<ToolManager> tool_manager_;
-    std::unique_ptr<MemoryManager> memory_manager_;
-    
-    // Event queue for subscriptions
-    std::mutex event_mutex_;
-    std::condition_variable event_cv_;
-    std::queue<Event> event_queue_;
-    
-    void PublishEvent(const Event& event);
+    std::shared_ptr<AgentCoordinator> coordinator_;
 };
 
 } // namespace gmcp
@@ -0,0 +1,631 @@
+#include "graph_store.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include "query_cursor.h"
+#include "substring_search.h"
+#include "visited_set.h"
+
+namespace gmcp {
+
+namespace {
+
+constexpr int kDefaultLimit = 100;
+
+size_t EffectiveLimit(const MemoryQuery& query) {
+    return query.limit() > 0 ? query.limit() : kDefaultLimit;
+}
+
+// Per-thread state of a bidirectional search: for each side, the epoch a
+// node was reached in, its parent towards that side's root and its depth
+class PathScratch {
+public:
+    static PathScratch& Begin(size_t size) {
+        thread_local PathScratch scratch;
+        for (auto& side : scratch.sides_) {
+            if (side.size() < size) {
+                side.resize(size);
+            }
+        }
+        if (++scratch.epoch_ == 0) {
+            for (auto& side : scratch.sides_) {
+                std::fill(side.begin(), side.end(), Slot());
+            }
+            scratch.epoch_ = 1;
+        }
+        return scratch;
+    }
+
+    bool Visited(int side, uint32_t node) const { return sides_[side][node].epoch == epoch_; }
+    uint32_t Parent(int side, uint32_t node) const { return sides_[side][node].parent; }
+    uint32_t Depth(int side, uint32_t node) const { return sides_[side][node].depth; }
+
+    void Visit(int side, uint32_t node, uint32_t parent, uint32_t depth) {
+        sides_[side][node] = {epoch_, parent, depth};
+    }
+
+private:
+    struct Slot {
+        uint32_t epoch = 0;
+        uint32_t parent = 0;
+        uint32_t depth = 0;
+    };
+
+    std::vector<Slot> sides_[2];
+    uint32_t epoch_ = 0;
+};
+
+} // namespace
+
+GraphStore::GraphStore() : GraphStore(Options()) {
+}
+
+GraphStore::GraphStore(const Options& options)
+    : options_(options), out_(std::make_shared<Csr>()), in_(std::make_shared<Csr>()) {
+    fold_thread_ = std::thread([this] { FoldLoop(); });
+}
+
+GraphStore::~GraphStore() {
+    {
+        std::lock_guard<std::mutex> lock(fold_mutex_);
+        stopping_ = true;
+    }
+    fold_cv_.notify_one();
+    fold_thread_.join();
+}
+
+bool GraphStore::Put(MemoryEntry&& entry) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    PutLocked(std::move(entry));
+    MaybeFoldLocked();
+    return true;
+}
+
+size_t GraphStore::PutBatch(std::vector<MemoryEntry>&& entries) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (auto& entry : entries) {
+        PutLocked(std::move(entry));
+    }
+    MaybeFoldLocked();
+    return entries.size();
+}
+
+GraphStore::NodeId GraphStore::InternNode(const std::string& key) {
+    auto [it, inserted] = ids_.try_emplace(key, static_cast<NodeId>(nodes_.size()));
+    if (inserted) {
+        MemoryEntry placeholder;
+        placeholder.set_key(key);
+        nodes_.push_back(std::move(placeholder));
+        present_.push_back(0);
+        overridden_.push_back(0);
+    }
+    return it->second;
+}
+
+uint32_t GraphStore::InternRelation(const std::string& relation) {
+    auto [it, inserted] =
+        relation_ids_.try_emplace(relation, static_cast<uint32_t>(relation_names_.size()));
+    if (inserted) {
+        relation_names_.push_back(relation);
+    }
+    return it->second;
+}
+
+void GraphStore::PutLocked(MemoryEntry&& entry) {
+    NodeId id = InternNode(entry.key());
+    
+    auto edges = std::make_shared<std::vector<Edge>>();
+    edges->reserve(entry.edges_size());
+    for (const auto& edge : entry.edges()) {
+        edges->push_back({InternNode(edge.target()), InternRelation(edge.relation()),
+                          edge.weight()});
+    }
+    entry.clear_edges();
+    
+    // A write replaces the node's outgoing edges: retire the previous set
+    if (overridden_[id]) {
+        const std::vector<Edge>& previous = *delta_out_[id].edges;
+        for (const Edge& edge : previous) {
+            // Written before or after the running fold's copy
+            for (auto* generation : {&delta_in_, &folding_in_}) {
+                auto incoming = generation->find(edge.node);
+                if (incoming != generation->end()) {
+                    auto& sources = incoming->second;
+                    sources.erase(std::remove_if(sources.begin(), sources.end(),
+                                                 [id](const Edge& e) { return e.node == id; }),
+                                  sources.end());
+                }
+            }
+        }
+        edge_count_ -= previous.size();
+        delta_edges_ -= previous.size();
+    } else {
+        if (id < out_->node_count()) {
+            edge_count_ -= out_->offsets[id + 1] - out_->offsets[id];
+        }
+        overridden_[id] = 1;
+    }
+    
+    for (const Edge& edge : *edges) {
+        delta_in_[edge.node].push_back({id, edge.relation, edge.weight});
+    }
+    edge_count_ += edges->size();
+    delta_edges_ += edges->size();
+    delta_out_[id] = {std::move(edges), ++writes_};
+    
+    if (!present_[id]) {
+        present_[id] = 1;
+        present_count_++;
+    }
+    nodes_[id] = std::move(entry);
+}
+
+bool GraphStore::DeltaFullLocked() const {
+    size_t delta = delta_edges_ + delta_out_.size();
+    return delta >= std::max(options_.min_fold_size, out_->nodes.size() / 4);
+}
+
+void GraphStore::MaybeFoldLocked() {
+    if (folding_ || !DeltaFullLocked()) {
+        return;
+    }
+    folding_ = true;
+    {
+        std::lock_guard<std::mutex> lock(fold_mutex_);
+        fold_requested_ = true;
+    }
+    fold_cv_.notify_one();
+}
+
+void GraphStore::FoldLoop() {
+    std::unique_lock<std::mutex> lock(fold_mutex_);
+    while (true) {
+        fold_cv_.wait(lock, [this] { return stopping_ || fold_requested_; });
+        if (stopping_) {
+            return;
+        }
+        fold_requested_ = false;
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> run(fold_run_mutex_);
+            FoldOnce(false);
+        }
+        lock.lock();
+    }
+}
+
+void GraphStore::Fold() {
+    std::lock_guard<std::mutex> lock(fold_run_mutex_);
+    FoldOnce(true);
+}
+
+void GraphStore::FoldOnce(bool force) {
+    // Take the current CSR and the delta's edge lists, which are shared and
+    // immutable, and start a new generation of incoming delta edges. Writers
+    // wait only for this O(delta nodes) step, not for the O(V + E) rebuild.
+    std::shared_ptr<const Csr> base;
+    std::unordered_map<NodeId, EdgeList> delta;
+    size_t node_count;
+    size_t edge_count;
+    uint64_t folded_writes;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        // A Fold() may have emptied the delta since this fold was requested
+        if (!force && !DeltaFullLocked()) {
+            folding_ = false;
+            return;
+        }
+        base = out_;
+        delta.reserve(delta_out_.size());
+        for (const auto& [id, edges] : delta_out_) {
+            delta.emplace(id, edges.edges);
+        }
+        node_count = nodes_.size();
+        edge_count = edge_count_;
+        folded_writes = writes_;
+        folding_in_.swap(delta_in_);
+    }
+    std::vector<uint8_t> overridden(node_count, 0);
+    for (const auto& [id, edges] : delta) {
+        overridden[id] = 1;
+    }
+    
+    auto out = std::make_shared<Csr>();
+    out->offsets.assign(node_count + 1, 0);
+    out->nodes.reserve(edge_count);
+    out->relations.reserve(edge_count);
+    out->weights.reserve(edge_count);
+    for (NodeId v = 0; v < node_count; ++v) {
+        if (overridden[v]) {
+            for (const Edge& edge : *delta[v]) {
+                out->nodes.push_back(edge.node);
+                out->relations.push_back(edge.relation);
+                out->weights.push_back(edge.weight);
+            }
+        } else if (v < base->node_count()) {
+            for (uint32_t i = base->offsets[v]; i < base->offsets[v + 1]; ++i) {
+                out->nodes.push_back(base->nodes[i]);
+                out->relations.push_back(base->relations[i]);
+                out->weights.push_back(base->weights[i]);
+            }
+        }
+        out->offsets[v + 1] = static_cast<uint32_t>(out->nodes.size());
+    }
+    
+    // Incoming CSR by counting sort on the target
+    auto in = std::make_shared<Csr>();
+    in->offsets.assign(node_count + 1, 0);
+    for (NodeId target : out->nodes) {
+        in->offsets[target + 1]++;
+    }
+    for (size_t v = 0; v < node_count; ++v) {
+        in->offsets[v + 1] += in->offsets[v];
+    }
+    in->nodes.resize(out->nodes.size());
+    in->relations.resize(out->nodes.size());
+    in->weights.resize(out->nodes.size());
+    std::vector<uint32_t> cursor(in->offsets.begin(), in->offsets.end() - 1);
+    for (NodeId v = 0; v < node_count; ++v) {
+        for (uint32_t i = out->offsets[v]; i < out->offsets[v + 1]; ++i) {
+            uint32_t slot = cursor[out->nodes[i]]++;
+            in->nodes[slot] = v;
+            in->relations[slot] = out->relations[i];
+            in->weights[slot] = out->weights[i];
+        }
+    }
+    
+    // Swap in. Nodes not rewritten since the copy are now in the CSR, and
+    // their incoming edges all sit in the previous generation, which is
+    // dropped whole. What the swap replaces is freed after the lock is
+    // released.
+    std::unordered_map<NodeId, std::vector<Edge>> folded_in;
+    std::vector<decltype(delta_out_)::node_type> folded_out;
+    folded_out.reserve(delta.size());
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    base = std::exchange(out_, std::move(out));
+    std::shared_ptr<const Csr> old_in = std::exchange(in_, std::move(in));
+    folded_in.swap(folding_in_);
+    for (const auto& [id, edges] : delta) {
+        auto it = delta_out_.find(id);
+        if (it->second.write <= folded_writes) {
+            overridden_[id] = 0;
+            delta_edges_ -= it->second.edges->size();
+            folded_out.push_back(delta_out_.extract(it));
+        }
+    }
+    folding_ = false;
+    MaybeFoldLocked();
+    lock.unlock();
+}
+
+template <typename Fn>
+void GraphStore::ForEachEdge(NodeId node, EdgeDirection direction, Fn&& fn) const {
+    if (direction != EdgeDirection::INCOMING) {
+        if (overridden_[node]) {
+            for (const Edge& edge : *delta_out_.at(node).edges) {
+                fn(edge.node, edge.relation, edge.weight);
+            }
+        } else if (node < out_->node_count()) {
+            const Csr& out = *out_;
+            for (uint32_t i = out.offsets[node]; i < out.offsets[node + 1]; ++i) {
+                fn(out.nodes[i], out.relations[i], out.weights[i]);
+            }
+        }
+    }
+    if (direction != EdgeDirection::OUTGOING) {
+        if (node < in_->node_count()) {
+            const Csr& in = *in_;
+            for (uint32_t i = in.offsets[node]; i < in.offsets[node + 1]; ++i) {
+                if (!overridden_[in.nodes[i]]) {
+                    fn(in.nodes[i], in.relations[i], in.weights[i]);
+                }
+            }
+        }
+        for (const auto* generation : {&folding_in_, &delta_in_}) {
+            auto delta = generation->find(node);
+            if (delta != generation->end()) {
+                for (const Edge& edge : delta->second) {
+                    fn(edge.node, edge.relation, edge.weight);
+                }
+            }
+        }
+    }
+}
+
+void GraphStore::Query(const MemoryQuery& query, MemoryResult* result) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    
+    switch (query.query_type()) {
+        case QueryType::GET:
+            Get(query, result);
+            break;
+        
+        case QueryType::LIST:
+            List(query, result);
+            break;
+        
+        case QueryType::SEARCH:
+            Search(query, result);
+            break;
+        
+        case QueryType::TRAVERSE:
+            if (query.traversal().type() == TraversalType::SHORTEST_PATH) {
+                ShortestPath(query, result);
+            } else {
+                Expand(query, result);
+            }
+            break;
+        
+        default:
+            break;
+    }
+}
+
+size_t GraphStore::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return present_count_;
+}
+
+void GraphStore::ForEach(const std::function<void(const MemoryEntry&)>& visit,
+                         const std::function<void()>& pinned) const {
+    // Placeholder nodes are recreated by the edges that reference them
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    pinned();
+    MemoryEntry entry;
+    for (NodeId id = 0; id < nodes_.size(); ++id) {
+        if (!present_[id]) {
+            continue;
+        }
+        entry = nodes_[id];
+        ForEachEdge(id, EdgeDirection::OUTGOING, [&](NodeId target, uint32_t relation,
+                                                     float weight) {
+            GraphEdge* edge = entry.add_edges();
+            edge->set_target(nodes_[target].key());
+            edge->set_relation(relation_names_[relation]);
+            edge->set_weight(weight);
+        });
+        visit(entry);
+    }
+}
+
+size_t GraphStore::edge_count() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return edge_count_;
+}
+
+GraphStore::RelationFilter GraphStore::FilterOf(const GraphTraversal& traversal) const {
+    RelationFilter filter;
+    if (traversal.relations_size() == 0) {
+        return filter;
+    }
+    filter.active = true;
+    filter.allowed.assign(relation_names_.size(), 0);
+    for (const auto& name : traversal.relations()) {
+        auto it = relation_ids_.find(name);
+        if (it != relation_ids_.end()) {
+            filter.allowed[it->second] = 1;
+        }
+    }
+    return filter;
+}
+
+bool GraphStore::FindNode(const std::string& key, NodeId* id) const {
+    auto it = ids_.find(key);
+    if (it == ids_.end()) {
+        return false;
+    }
+    *id = it->second;
+    return true;
+}
+
+void GraphStore::AppendNode(NodeId id, bool with_edges, MemoryResult* result) const {
+    MemoryEntry* entry = result->add_entries();
+    *entry = nodes_[id];
+    if (with_edges) {
+        ForEachEdge(id, EdgeDirection::OUTGOING, [&](NodeId target, uint32_t relation,
+                                                     float weight) {
+            GraphEdge* edge = entry->add_edges();
+            edge->set_target(nodes_[target].key());
+            edge->set_relation(relation_names_[relation]);
+            edge->set_weight(weight);
+        });
+    }
+}
+
+void GraphStore::Get(const MemoryQuery& query, MemoryResult* result) const {
+    NodeId id;
+    if (FindNode(query.query(), &id) && present_[id]) {
+        AppendNode(id, true, result);
+        result->set_total_count(1);
+    }
+}
+
+void GraphStore::List(const MemoryQuery& query, MemoryResult* result) const {
+    QueryCursor cursor;
+    if (!QueryCursor::Decode(query, QueryCursor::Kind::kKey, &cursor)) {
+        return;
+    }
+    
+    // Ids are in insertion order; only the first `limit` keys past the
+    // cursor are sorted
+    std::vector<const std::string*> keys;
+    keys.reserve(present_count_);
+    for (NodeId id = 0; id < nodes_.size(); ++id) {
+        if (present_[id] && (cursor.at_start() || nodes_[id].key() > cursor.key)) {
+            keys.push_back(&nodes_[id].key());
+        }
+    }
+    size_t limit = std::min(EffectiveLimit(query), keys.size());
+    std::partial_sort(keys.begin(), keys.begin() + limit, keys.end(),
+                      [](const std::string* a, const std::string* b) { return *a < *b; });
+    for (size_t i = 0; i < limit; ++i) {
+        AppendNode(ids_.at(*keys[i]), true, result);
+    }
+    result->set_total_count(present_count_);
+    if (keys.size() > limit) {
+        result->set_has_more(true);
+        result->set_next_cursor(QueryCursor::AfterKey(*keys[limit - 1]).Encode());
+    }
+}
+
+void GraphStore::Search(const MemoryQuery& query, MemoryResult* result) const {
+    // Scans in id (insertion) order; the cursor is the id to resume at.
+    // Later pages stop at the first match past the page.
+    QueryCursor cursor;
+    if (!QueryCursor::Decode(query, QueryCursor::Kind::kPosition, &cursor)) {
+        return;
+    }
+    size_t limit = EffectiveLimit(query);
+    size_t total = 0;
+    NodeId resume = 0;
+    for (NodeId id = cursor.count; id < nodes_.size(); ++id) {
+        if (present_[id] && (ContainsSubstring(nodes_[id].key(), query.query()) ||
+                             ContainsSubstring(nodes_[id].value(), query.query()))) {
+            if (total < limit) {
+                AppendNode(id, false, result);
+                resume = id + 1;
+            }
+            total++;
+            if (!cursor.at_start() && total > limit) {
+                break;
+            }
+        }
+    }
+    if (cursor.at_start()) {
+        result->set_total_count(total);
+    }
+    result->set_has_more(total > limit);
+    if (total > limit) {
+        result->set_next_cursor(QueryCursor::AtPosition(resume).Encode());
+    }
+}
+
+void GraphStore::Expand(const MemoryQuery& query, MemoryResult* result) const {
+    // Level-synchronous BFS; NEIGHBORS is the one-hop case. Nodes are
+    // reported in BFS order with their hop distance, excluding the start.
+    const GraphTraversal& traversal = query.traversal();
+    NodeId start;
+    if (!FindNode(traversal.start_key(), &start)) {
+        return;
+    }
+    int max_depth = traversal.type() == TraversalType::NEIGHBORS
+                        ? 1
+                        : std::max(traversal.max_depth(), 1);
+    RelationFilter filter = FilterOf(traversal);
+    // Later pages rerun the traversal and skip the nodes already returned
+    QueryCursor cursor;
+    if (!QueryCursor::Decode(query, QueryCursor::Kind::kPosition, &cursor)) {
+        return;
+    }
+    size_t offset = cursor.count;
+    size_t limit = EffectiveLimit(query);
+    
+    VisitedSet& visited = VisitedSet::Begin(nodes_.size());
+    visited.Insert(start);
+    std::vector<NodeId> frontier{start};
+    std::vector<NodeId> next;
+    size_t total = 0;
+    for (int depth = 1; depth <= max_depth && !frontier.empty(); ++depth) {
+        next.clear();
+        for (NodeId node : frontier) {
+            ForEachEdge(node, traversal.direction(), [&](NodeId neighbor, uint32_t relation,
+                                                         float) {
+                if (filter.Allows(relation) && visited.Insert(neighbor)) {
+                    next.push_back(neighbor);
+                }
+            });
+        }
+        for (NodeId node : next) {
+            if (total >= offset && total < offset + limit) {
+                AppendNode(node, false, result);
+                result->add_depths(depth);
+            }
+            total++;
+        }
+        frontier.swap(next);
+    }
+    result->set_total_count(total);
+    if (total > offset + limit) {
+        result->set_has_more(true);
+        result->set_next_cursor(QueryCursor::AtPosition(offset + limit).Encode());
+    }
+}
+
+void GraphStore::ShortestPath(const MemoryQuery& query, MemoryResult* result) const {
+    // Fewest-hops path by bidirectional BFS: the start side follows the
+    // requested direction, the target side the reverse one (served by the
+    // incoming CSR), and the smaller frontier is always expanded next. The
+    // path is returned start first, each node with its hop distance.
+    const GraphTraversal& traversal = query.traversal();
+    NodeId start;
+    NodeId target;
+    if (!FindNode(traversal.start_key(), &start) || !FindNode(traversal.target_key(), &target)) {
+        return;
+    }
+    size_t max_depth = traversal.max_depth() > 0 ? traversal.max_depth() : nodes_.size();
+    RelationFilter filter = FilterOf(traversal);
+    
+    EdgeDirection directions[2] = {traversal.direction(), traversal.direction()};
+    if (traversal.direction() == EdgeDirection::OUTGOING) {
+        directions[1] = EdgeDirection::INCOMING;
+    } else if (traversal.direction() == EdgeDirection::INCOMING) {
+        directions[1] = EdgeDirection::OUTGOING;
+    }
+    
+    PathScratch& scratch = PathScratch::Begin(nodes_.size());
+    scratch.Visit(0, start, start, 0);
+    scratch.Visit(1, target, target, 0);
+    std::vector<NodeId> frontiers[2] = {{start}, {target}};
+    uint32_t depths[2] = {0, 0};
+    std::vector<NodeId> next;
+    
+    NodeId meet = start;
+    bool found = start == target;
+    while (!found && !frontiers[0].empty() && !frontiers[1].empty() &&
+           depths[0] + depths[1] < max_depth) {
+        int side = frontiers[0].size() <= frontiers[1].size() ? 0 : 1;
+        uint32_t depth = ++depths[side];
+        size_t best = SIZE_MAX;
+        next.clear();
+        for (NodeId node : frontiers[side]) {
+            ForEachEdge(node, directions[side], [&](NodeId neighbor, uint32_t relation, float) {
+                if (!filter.Allows(relation) || scratch.Visited(side, neighbor)) {
+                    return;
+                }
+                scratch.Visit(side, neighbor, node, depth);
+                next.push_back(neighbor);
+                // Finish the level and keep the meeting point closest to the
+                // other side, which makes the joined path a shortest one
+                if (scratch.Visited(1 - side, neighbor) &&
+                    scratch.Depth(1 - side, neighbor) < best) {
+                    best = scratch.Depth(1 - side, neighbor);
+                    meet = neighbor;
+                    found = true;
+                }
+            });
+        }
+        frontiers[side].swap(next);
+    }
+    if (!found || scratch.Depth(0, meet) + scratch.Depth(1, meet) > max_depth) {
+        return;
+    }
+    
+    std::vector<NodeId> path{meet};
+    while (path.back() != start) {
+        path.push_back(scratch.Parent(0, path.back()));
+    }
+    std::reverse(path.begin(), path.end());
+    for (NodeId node = meet; node != target;) {
+        node = scratch.Parent(1, node);
+        path.push_back(node);
+    }
+    for (size_t i = 0; i < path.size(); ++i) {
+        AppendNode(path[i], false, result);
+        result->add_depths(static_cast<int32_t>(i));
+    }
+    result->set_total_count(path.size());
+}
+
+} // namespace gmcp
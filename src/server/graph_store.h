@@ -0,0 +1,150 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "memory_store.h"
+
+namespace gmcp {
+
+// Knowledge graph: every entry is a node and its `edges` are its typed,
+// outgoing relations. Adjacency is held in compressed sparse row form, one
+// CSR for outgoing and one for incoming edges, so expanding a node reads a
+// contiguous run of 4-byte ids. Writes replace a node's outgoing edges in a
+// delta buffer that traversals consult alongside the CSR; once the delta
+// grows past a fraction of the graph a background thread folds it into fresh
+// CSR arrays, keeping the amortized write cost constant. The fold is built
+// outside the store lock from the current CSR and a copy of the delta, then
+// swapped in; writes made meanwhile stay in the delta.
+class GraphStore final : public MemoryStore {
+public:
+    struct Options {
+        // Delta size (edges plus rewritten nodes) that always triggers a fold;
+        // larger graphs fold once the delta reaches a quarter of their edges
+        size_t min_fold_size = 65536;
+    };
+
+    GraphStore();
+    explicit GraphStore(const Options& options);
+    ~GraphStore() override;
+
+    bool Put(MemoryEntry&& entry) override;
+    size_t PutBatch(std::vector<MemoryEntry>&& entries) override;
+    void Query(const MemoryQuery& query, MemoryResult* result) const override;
+    size_t size() const override;
+    void ForEach(const std::function<void(const MemoryEntry&)>& visit,
+                 const std::function<void()>& pinned) const override;
+
+    size_t edge_count() const;
+
+    // Fold the whole delta into the CSR now, e.g. after a bulk load, and
+    // return once it is swapped in
+    void Fold();
+
+private:
+    using NodeId = uint32_t;
+
+    struct Edge {
+        NodeId node;  // target for outgoing edges, source for incoming ones
+        uint32_t relation;
+        float weight;
+    };
+
+    // Shared with a running fold, which reads it without the lock
+    using EdgeList = std::shared_ptr<const std::vector<Edge>>;
+
+    // A node's outgoing edges since the last fold and the write that set them
+    struct DeltaEdges {
+        EdgeList edges;
+        uint64_t write = 0;
+    };
+
+    struct Csr {
+        std::vector<uint32_t> offsets{0};
+        std::vector<NodeId> nodes;
+        std::vector<uint32_t> relations;
+        std::vector<float> weights;
+
+        size_t node_count() const { return offsets.size() - 1; }
+    };
+
+    // Relations a traversal may follow; empty `allowed` means all
+    struct RelationFilter {
+        bool active = false;
+        std::vector<uint8_t> allowed;
+
+        bool Allows(uint32_t relation) const {
+            return !active || (relation < allowed.size() && allowed[relation]);
+        }
+    };
+
+    NodeId InternNode(const std::string& key);
+    uint32_t InternRelation(const std::string& relation);
+    void PutLocked(MemoryEntry&& entry);
+    bool DeltaFullLocked() const;
+    void MaybeFoldLocked();
+    void FoldLoop();
+    // Unless `force`, only folds a delta that is still over the threshold
+    void FoldOnce(bool force);
+
+    // Calls fn(neighbor, relation, weight) for each edge in the direction
+    template <typename Fn>
+    void ForEachEdge(NodeId node, EdgeDirection direction, Fn&& fn) const;
+
+    RelationFilter FilterOf(const GraphTraversal& traversal) const;
+    bool FindNode(const std::string& key, NodeId* id) const;
+    void AppendNode(NodeId id, bool with_edges, MemoryResult* result) const;
+
+    void Get(const MemoryQuery& query, MemoryResult* result) const;
+    void List(const MemoryQuery& query, MemoryResult* result) const;
+    void Search(const MemoryQuery& query, MemoryResult* result) const;
+    void Expand(const MemoryQuery& query, MemoryResult* result) const;
+    void ShortestPath(const MemoryQuery& query, MemoryResult* result) const;
+
+    const Options options_;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, NodeId> ids_;
+    // Node payloads without edges; nodes only referenced by edges so far are
+    // placeholders holding just their key
+    std::vector<MemoryEntry> nodes_;
+    std::vector<uint8_t> present_;
+    size_t present_count_ = 0;
+
+    std::unordered_map<std::string, uint32_t> relation_ids_;
+    std::vector<std::string> relation_names_;
+
+    // Immutable once published, so a fold can read them without the lock
+    std::shared_ptr<const Csr> out_;
+    // Incoming edges; an entry is stale once its source is overridden
+    std::shared_ptr<const Csr> in_;
+    // Nodes whose outgoing edges live in delta_out_ instead of out_
+    std::vector<uint8_t> overridden_;
+    std::unordered_map<NodeId, DeltaEdges> delta_out_;
+    // Incoming delta edges by target, written since the running fold's copy
+    // (or the last fold); folding_in_ holds those written before that copy
+    std::unordered_map<NodeId, std::vector<Edge>> delta_in_;
+    std::unordered_map<NodeId, std::vector<Edge>> folding_in_;
+    size_t delta_edges_ = 0;
+    size_t edge_count_ = 0;
+    // Numbers writes, so a fold knows which delta entries it covered
+    uint64_t writes_ = 0;
+    bool folding_ = false;
+
+    // Serializes folds; a fold's swap assumes no other fold ran since its copy
+    std::mutex fold_run_mutex_;
+    std::mutex fold_mutex_;
+    std::condition_variable fold_cv_;
+    bool fold_requested_ = false;
+    bool stopping_ = false;
+    std::thread fold_thread_;
+};
+
+} // namespace gmcp
@@ -0,0 +1,233 @@
+#include "hnsw_index.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include "visited_set.h"
+
+namespace gmcp {
+
+namespace {
+
+using Neighbor = HnswIndex::Neighbor;
+using NearestFirst = std::priority_queue<Neighbor, std::vector<Neighbor>, std::greater<Neighbor>>;
+using FarthestFirst = std::priority_queue<Neighbor>;
+
+} // namespace
+
+HnswIndex::HnswIndex(const VectorMatrix* vectors, DistanceFn distance)
+    : HnswIndex(vectors, distance, Options()) {
+}
+
+HnswIndex::HnswIndex(const VectorMatrix* vectors, DistanceFn distance, const Options& options)
+    : vectors_(vectors),
+      distance_(distance),
+      options_(options),
+      rng_(options.seed) {
+    options_.m = std::max<size_t>(options_.m, 2);
+    options_.ef_construction = std::max(options_.ef_construction, options_.m);
+    max_links0_ = options_.m * 2;
+    level_scale_ = 1.0 / std::log(static_cast<double>(options_.m));
+}
+
+float HnswIndex::Distance(const float* query, uint32_t id) const {
+    return distance_(query, vectors_->row(id), vectors_->stride());
+}
+
+int HnswIndex::RandomLevel() {
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    double r = std::max(uniform(rng_), 1e-12);
+    return static_cast<int>(-std::log(r) * level_scale_);
+}
+
+uint32_t* HnswIndex::LinksOf(uint32_t id, int level) {
+    if (level == 0) {
+        return level0_links_.data() + id * (max_links0_ + 1);
+    }
+    return upper_links_[id].data() + (level - 1) * (options_.m + 1);
+}
+
+const uint32_t* HnswIndex::LinksOf(uint32_t id, int level) const {
+    return const_cast<HnswIndex*>(this)->LinksOf(id, level);
+}
+
+uint32_t HnswIndex::GreedyClosest(const float* query, uint32_t entry, int level) const {
+    uint32_t current = entry;
+    float current_distance = Distance(query, current);
+    for (bool changed = true; changed;) {
+        changed = false;
+        const uint32_t* links = LinksOf(current, level);
+        for (uint32_t i = 1; i <= links[0]; ++i) {
+            float d = Distance(query, links[i]);
+            if (d < current_distance) {
+                current_distance = d;
+                current = links[i];
+                changed = true;
+            }
+        }
+    }
+    return current;
+}
+
+std::vector<Neighbor> HnswIndex::SearchLayer(const float* query, uint32_t entry, size_t ef,
+                                             int level) const {
+    VisitedSet& visited = VisitedSet::Begin(levels_.size());
+    NearestFirst candidates;
+    FarthestFirst results;
+    
+    float d = Distance(query, entry);
+    visited.Insert(entry);
+    candidates.emplace(d, entry);
+    results.emplace(d, entry);
+    
+    while (!candidates.empty()) {
+        Neighbor nearest = candidates.top();
+        if (nearest.first > results.top().first && results.size() >= ef) {
+            break;
+        }
+        candidates.pop();
+        
+        const uint32_t* links = LinksOf(nearest.second, level);
+        for (uint32_t i = 1; i <= links[0]; ++i) {
+            uint32_t next = links[i];
+            if (!visited.Insert(next)) {
+                continue;
+            }
+            float next_distance = Distance(query, next);
+            if (results.size() < ef || next_distance < results.top().first) {
+                candidates.emplace(next_distance, next);
+                results.emplace(next_distance, next);
+                if (results.size() > ef) {
+                    results.pop();
+                }
+            }
+        }
+    }
+    
+    std::vector<Neighbor> nearest_first(results.size());
+    for (size_t i = results.size(); i-- > 0;) {
+        nearest_first[i] = results.top();
+        results.pop();
+    }
+    return nearest_first;
+}
+
+std::vector<uint32_t> HnswIndex::SelectNeighbors(std::vector<Neighbor> candidates,
+                                                 size_t m) const {
+    // Keep a candidate only if it is closer to the base than to every
+    // neighbor kept so far; this spreads links across directions
+    std::sort(candidates.begin(), candidates.end());
+    std::vector<uint32_t> selected;
+    selected.reserve(m);
+    for (const auto& [distance, id] : candidates) {
+        if (selected.size() >= m) {
+            break;
+        }
+        bool diverse = true;
+        for (uint32_t kept : selected) {
+            if (Distance(vectors_->row(id), kept) < distance) {
+                diverse = false;
+                break;
+            }
+        }
+        if (diverse) {
+            selected.push_back(id);
+        }
+    }
+    return selected;
+}
+
+void HnswIndex::SetLinks(uint32_t id, int level, const std::vector<uint32_t>& links) {
+    uint32_t* slot = LinksOf(id, level);
+    slot[0] = static_cast<uint32_t>(links.size());
+    std::copy(links.begin(), links.end(), slot + 1);
+}
+
+void HnswIndex::AddLink(uint32_t from, uint32_t to, int level) {
+    uint32_t* links = LinksOf(from, level);
+    for (uint32_t i = 1; i <= links[0]; ++i) {
+        if (links[i] == to) {
+            return;
+        }
+    }
+    size_t max_links = MaxLinks(level);
+    if (links[0] < max_links) {
+        links[++links[0]] = to;
+        return;
+    }
+    
+    // Full: re-select among the existing links plus the new one
+    const float* base = vectors_->row(from);
+    std::vector<Neighbor> candidates;
+    candidates.reserve(links[0] + 1);
+    candidates.emplace_back(Distance(base, to), to);
+    for (uint32_t i = 1; i <= links[0]; ++i) {
+        candidates.emplace_back(Distance(base, links[i]), links[i]);
+    }
+    SetLinks(from, level, SelectNeighbors(std::move(candidates), max_links));
+}
+
+void HnswIndex::Insert(uint32_t id) {
+    bool relink = id < levels_.size();
+    int level;
+    if (relink) {
+        level = levels_[id];
+    } else {
+        level = RandomLevel();
+        levels_.push_back(level);
+        level0_links_.resize(levels_.size() * (max_links0_ + 1), 0);
+        upper_links_.emplace_back(level * (options_.m + 1), 0);
+    }
+    
+    if (max_level_ < 0) {
+        entry_point_ = id;
+        max_level_ = level;
+        return;
+    }
+    
+    const float* query = vectors_->row(id);
+    uint32_t entry = entry_point_;
+    for (int l = max_level_; l > level; --l) {
+        entry = GreedyClosest(query, entry, l);
+    }
+    
+    for (int l = std::min(level, max_level_); l >= 0; --l) {
+        std::vector<Neighbor> candidates = SearchLayer(query, entry, options_.ef_construction, l);
+        entry = candidates.front().second;
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                        [id](const Neighbor& n) { return n.second == id; }),
+                         candidates.end());
+        if (candidates.empty()) {
+            continue;
+        }
+        
+        std::vector<uint32_t> neighbors = SelectNeighbors(std::move(candidates), options_.m);
+        SetLinks(id, l, neighbors);
+        for (uint32_t neighbor : neighbors) {
+            AddLink(neighbor, id, l);
+        }
+    }
+    
+    if (level > max_level_) {
+        entry_point_ = id;
+        max_level_ = level;
+    }
+}
+
+std::vector<Neighbor> HnswIndex::Search(const float* query, size_t k, size_t ef) const {
+    if (max_level_ < 0 || k == 0) {
+        return {};
+    }
+    
+    uint32_t entry = entry_point_;
+    for (int l = max_level_; l > 0; --l) {
+        entry = GreedyClosest(query, entry, l);
+    }
+    
+    std::vector<Neighbor> nearest = SearchLayer(query, entry, std::max(ef, k), 0);
+    if (nearest.size() > k) {
+        nearest.resize(k);
+    }
+    return nearest;
+}
+
+} // namespace gmcp
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+#include "vector_kernels.h"
+#include "vector_matrix.h"
+
+namespace gmcp {
+
+// Hierarchical navigable small world graph over the rows of a VectorMatrix
+// (Malkov & Yashunin). Level-0 links, which every search walks, live in one
+// flat array with a fixed stride per node; the sparse upper levels are kept
+// per node. Not internally synchronized: the owner serializes Insert against
+// everything else, while concurrent Search calls are safe.
+class HnswIndex {
+public:
+    struct Options {
+        // Links per node on upper levels; level 0 keeps twice as many
+        size_t m = 16;
+        // Candidate list size while inserting
+        size_t ef_construction = 200;
+        uint64_t seed = 42;
+    };
+
+    // (distance, row) pairs, nearest first
+    using Neighbor = std::pair<float, uint32_t>;
+
+    HnswIndex(const VectorMatrix* vectors, DistanceFn distance);
+    HnswIndex(const VectorMatrix* vectors, DistanceFn distance, const Options& options);
+
+    // Link row `id` into the graph. Rows are inserted in order; inserting an
+    // existing row again relinks it after its vector changed.
+    void Insert(uint32_t id);
+
+    // Approximate k nearest rows to a padded query, exploring `ef` candidates
+    std::vector<Neighbor> Search(const float* query, size_t k, size_t ef) const;
+
+    size_t size() const { return levels_.size(); }
+
+private:
+    float Distance(const float* query, uint32_t id) const;
+
+    int RandomLevel();
+    size_t MaxLinks(int level) const { return level == 0 ? max_links0_ : options_.m; }
+
+    // Links are stored as [count, id, id, ...]
+    uint32_t* LinksOf(uint32_t id, int level);
+    const uint32_t* LinksOf(uint32_t id, int level) const;
+
+    uint32_t GreedyClosest(const float* query, uint32_t entry, int level) const;
+    std::vector<Neighbor> SearchLayer(const float* query, uint32_t entry, size_t ef,
+                                      int level) const;
+    std::vector<uint32_t> SelectNeighbors(std::vector<Neighbor> candidates, size_t m) const;
+    void SetLinks(uint32_t id, int level, const std::vector<uint32_t>& links);
+    void AddLink(uint32_t from, uint32_t to, int level);
+
+    const VectorMatrix* vectors_;
+    DistanceFn distance_;
+    Options options_;
+    size_t max_links0_;
+    double level_scale_;
+    std::mt19937_64 rng_;
+
+    std::vector<int> levels_;
+    std::vector<uint32_t> level0_links_;
+    std::vector<std::vector<uint32_t>> upper_links_;
+    uint32_t entry_point_ = 0;
+    int max_level_ = -1;
+};
+
+} // namespace gmcp
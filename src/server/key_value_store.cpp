@@ -0,0 +1,282 @@
+#include "key_value_store.h"
+#include "query_cursor.h"
+#include "substring_search.h"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <utility>
+
+namespace gmcp {
+
+namespace {
+
+constexpr int kDefaultLimit = 100;
+
+int EffectiveLimit(const MemoryQuery& query) {
+    return query.limit() > 0 ? query.limit() : kDefaultLimit;
+}
+
+} // namespace
+
+KeyValueStore::KeyValueStore() : KeyValueStore(Options()) {
+}
+
+KeyValueStore::KeyValueStore(const Options& options) {
+    size_t shard_count = std::max<size_t>(options.shard_count, 1);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+    if (options.trigram_index) {
+        index_ = std::make_unique<TrigramIndex>();
+    }
+}
+
+size_t KeyValueStore::ShardOf(const std::string& key) const {
+    return std::hash<std::string>{}(key) % shards_.size();
+}
+
+bool KeyValueStore::Put(MemoryEntry&& entry) {
+    Shard& shard = *shards_[ShardOf(entry.key())];
+    std::string key = entry.key();
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    // Index under the shard lock, so writers to one key update the index and
+    // the map in the same order and the index always reflects the stored value
+    if (index_) {
+        index_->Update(entry);
+    }
+    shard.entries.insert_or_assign(std::move(key), std::move(entry));
+    return true;
+}
+
+size_t KeyValueStore::PutBatch(std::vector<MemoryEntry>&& entries) {
+    // Group by shard first so each shard lock is taken once per batch
+    std::vector<std::vector<MemoryEntry*>> by_shard(shards_.size());
+    for (auto& entry : entries) {
+        by_shard[ShardOf(entry.key())].push_back(&entry);
+    }
+    
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        if (by_shard[i].empty()) {
+            continue;
+        }
+        Shard& shard = *shards_[i];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if (index_) {
+            index_->Update(by_shard[i]);
+        }
+        for (MemoryEntry* entry : by_shard[i]) {
+            std::string key = entry->key();
+            shard.entries.insert_or_assign(std::move(key), std::move(*entry));
+        }
+    }
+    return entries.size();
+}
+
+void KeyValueStore::Query(const MemoryQuery& query, MemoryResult* result) const {
+    switch (query.query_type()) {
+        case QueryType::GET:
+            Get(query, result);
+            break;
+        
+        case QueryType::LIST:
+            List(query, result);
+            break;
+        
+        case QueryType::SEARCH:
+            Search(query, result);
+            break;
+        
+        default:
+            break;
+    }
+}
+
+size_t KeyValueStore::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        total += shard->entries.size();
+    }
+    return total;
+}
+
+void KeyValueStore::ForEach(const std::function<void(const MemoryEntry&)>& visit,
+                            const std::function<void()>& pinned) const {
+    // Shards are visited one at a time, so writes made meanwhile may or may
+    // not be seen; replaying them replaces the same keys with the same values
+    pinned();
+    for (const auto& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        for (const auto& [key, entry] : shard->entries) {
+            visit(entry);
+        }
+    }
+}
+
+void KeyValueStore::Get(const MemoryQuery& query, MemoryResult* result) const {
+    const Shard& shard = *shards_[ShardOf(query.query())];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    
+    auto it = shard.entries.find(query.query());
+    if (it != shard.entries.end()) {
+        *result->add_entries() = it->second;
+        result->set_total_count(1);
+    }
+}
+
+void KeyValueStore::List(const MemoryQuery& query, MemoryResult* result) const {
+    QueryCursor cursor;
+    if (!QueryCursor::Decode(query, QueryCursor::Kind::kKey, &cursor)) {
+        return;
+    }
+    
+    // Shared locks in shard order; writers only ever hold one shard lock, so
+    // this cannot deadlock and gives a point-in-time view across shards.
+    // Locks are held for one page only; later pages resume from the cursor.
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    locks.reserve(shards_.size());
+    for (const auto& shard : shards_) {
+        locks.emplace_back(shard->mutex);
+    }
+    
+    using Iterator = std::map<std::string, MemoryEntry>::const_iterator;
+    using Cursor = std::pair<Iterator, Iterator>;
+    auto later = [](const Cursor& a, const Cursor& b) { return a.first->first > b.first->first; };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> heads(later);
+    
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard->entries.size();
+        auto begin = cursor.at_start() ? shard->entries.begin()
+                                       : shard->entries.upper_bound(cursor.key);
+        if (begin != shard->entries.end()) {
+            heads.emplace(begin, shard->entries.end());
+        }
+    }
+    
+    // Ordered k-way merge of the shards, stopping at the limit
+    int limit = EffectiveLimit(query);
+    int count = 0;
+    while (!heads.empty()) {
+        if (count >= limit) {
+            result->set_has_more(true);
+            result->set_next_cursor(
+                QueryCursor::AfterKey(result->entries(count - 1).key()).Encode());
+            break;
+        }
+        Cursor head = heads.top();
+        heads.pop();
+        *result->add_entries() = head.first->second;
+        count++;
+        if (++head.first != head.second) {
+            heads.push(head);
+        }
+    }
+    result->set_total_count(total);
+}
+
+void KeyValueStore::Search(const MemoryQuery& query, MemoryResult* result) const {
+    const std::string& needle = query.query();
+    if (index_ && needle.size() >= TrigramIndex::kGramSize) {
+        SearchIndexed(query, result);
+        return;
+    }
+    QueryCursor cursor;
+    if (!QueryCursor::Decode(query, QueryCursor::Kind::kKey, &cursor)) {
+        return;
+    }
+    
+    // Substring scan of keys and values. Each shard is scanned under its own
+    // shared lock and keeps its first matches in key order. The first page
+    // counts every match; later pages stop a shard once it has one match
+    // more than the page holds.
+    size_t limit = EffectiveLimit(query);
+    bool count_all = cursor.at_start();
+    bool more = false;
+    size_t total = 0;
+    std::vector<MemoryEntry> matches;
+    for (const auto& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        size_t kept = 0;
+        auto it = count_all ? shard->entries.begin() : shard->entries.upper_bound(cursor.key);
+        for (; it != shard->entries.end(); ++it) {
+            const auto& [key, entry] = *it;
+            if (ContainsSubstring(key, needle) || ContainsSubstring(entry.value(), needle)) {
+                if (kept < limit) {
+                    matches.push_back(entry);
+                    kept++;
+                } else if (!count_all) {
+                    more = true;
+                    break;
+                }
+                total++;
+            }
+        }
+    }
+    
+    std::sort(matches.begin(), matches.end(),
+              [](const MemoryEntry& a, const MemoryEntry& b) { return a.key() < b.key(); });
+    if (matches.size() > limit) {
+        matches.resize(limit);
+        more = true;
+    }
+    for (auto& entry : matches) {
+        *result->add_entries() = std::move(entry);
+    }
+    if (count_all) {
+        result->set_total_count(total);
+        more = total > limit;
+    }
+    result->set_has_more(more);
+    if (more) {
+        result->set_next_cursor(
+            QueryCursor::AfterKey(result->entries(result->entries_size() - 1).key()).Encode());
+    }
+}
+
+void KeyValueStore::SearchIndexed(const MemoryQuery& query, MemoryResult* result) const {
+    QueryCursor cursor;
+    if (!QueryCursor::Decode(query, QueryCursor::Kind::kKey, &cursor)) {
+        return;
+    }
+    const std::string& needle = query.query();
+    std::vector<std::string> candidates = index_->Candidates(needle);
+    
+    // Verify in key order so the first `limit` matches are the ones returned
+    std::sort(candidates.begin(), candidates.end());
+    auto begin = cursor.at_start()
+                     ? candidates.begin()
+                     : std::upper_bound(candidates.begin(), candidates.end(), cursor.key);
+    size_t limit = EffectiveLimit(query);
+    bool count_all = cursor.at_start();
+    size_t total = 0;
+    for (auto candidate = begin; candidate != candidates.end(); ++candidate) {
+        const std::string& key = *candidate;
+        const Shard& shard = *shards_[ShardOf(key)];
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) {
+            continue;
+        }
+        if (ContainsSubstring(key, needle) || ContainsSubstring(it->second.value(), needle)) {
+            if (total < limit) {
+                *result->add_entries() = it->second;
+            }
+            total++;
+            if (!count_all && total > limit) {
+                break;
+            }
+        }
+    }
+    if (count_all) {
+        result->set_total_count(total);
+    }
+    result->set_has_more(total > limit);
+    if (total > limit) {
+        result->set_next_cursor(
+            QueryCursor::AfterKey(result->entries(result->entries_size() - 1).key()).Encode());
+    }
+}
+
+} // namespace gmcp
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "memory_store.h"
+#include "trigram_index.h"
+
+namespace gmcp {
+
+// Ordered key-value store split into hash shards, each with its own
+// reader-writer lock. Writers lock only the shard owning the key; point reads
+// take a shared lock on one shard. Ordered scans (LIST) take shared locks on
+// every shard and k-way merge the per-shard maps, so they see a consistent
+// view while still running concurrently with other readers.
+//
+// SEARCH scans every shard unless the store keeps a trigram index, in which
+// case only the candidates of the needle's trigrams are verified.
+class KeyValueStore final : public MemoryStore {
+public:
+    struct Options {
+        size_t shard_count = 16;
+        // Maintain a trigram index for substring SEARCH
+        bool trigram_index = false;
+    };
+
+    KeyValueStore();
+    explicit KeyValueStore(const Options& options);
+
+    bool Put(MemoryEntry&& entry) override;
+    size_t PutBatch(std::vector<MemoryEntry>&& entries) override;
+    void Query(const MemoryQuery& query, MemoryResult* result) const override;
+    size_t size() const override;
+    void ForEach(const std::function<void(const MemoryEntry&)>& visit,
+                 const std::function<void()>& pinned) const override;
+
+private:
+    // Padded so neighbouring shard locks do not share a cache line
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::map<std::string, MemoryEntry> entries;
+    };
+
+    size_t ShardOf(const std::string& key) const;
+
+    void Get(const MemoryQuery& query, MemoryResult* result) const;
+    void List(const MemoryQuery& query, MemoryResult* result) const;
+    void Search(const MemoryQuery& query, MemoryResult* result) const;
+    void SearchIndexed(const MemoryQuery& query, MemoryResult* result) const;
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::unique_ptr<TrigramIndex> index_;
+};
+
+} // namespace gmcp
@@ -1,16 +1,175 @@
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/ext/proto_server_reflection_plugin.h>
+#include "common/logging.h"
 #include "gmcp_server.h"
+#include "gmcp_callback_server.h"
+#include "metrics_exporter.h"
+#include "plugin_loader.h"
 
-void RunServer() {
-    std::string server_address("0.0.0.0:50051");
-    gmcp::AgentCoordinationServiceImpl service;
+struct ServerOptions {
+    std::string address = "0.0.0.0:50051";
+    // "sync" (thread per stream) or "callback" (reactor based)
+    std::string mode = "sync";
+    gmcp::AgentCoordinator::Options coordinator;
+    gmcp::LogLevel log_level = gmcp::LogLevel::kInfo;
+    gmcp::MetricsExporter::Options metrics;
+    gmcp::PluginLoader::Options plugins;
+};
+
+void PrintUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --address=HOST:PORT   Listening address (default 0.0.0.0:50051)\n"
+              << "  --mode=sync|callback  Service implementation (default sync)\n"
+              << "  --executor-threads=N  Message/tool worker threads (default: all cores)\n"
+              << "  --stream-window=N     Max in-flight messages per agent stream (default 64)\n"
+              << "  --event-queue-depth=N Events buffered per subscriber (default 1024)\n"
+              << "  --event-overflow=drop-oldest|disconnect\n"
+              << "                        Policy when a subscriber's queue is full\n"
+              << "  --data-dir=DIR        Persist memory stores in DIR (default: in memory only)\n"
+              << "  --wal-sync=on|off     fdatasync the write-ahead log per commit (default on)\n"
+              << "  --snapshot-log-mb=N   Log megabytes between snapshots (default 64)\n"
+              << "  --tool-cache-mb=N     Result cache for cacheable tools (default 64, 0 = off)\n"
+              << "  --coalesce-tools=on|off\n"
+              << "                        Run identical concurrent tool calls once (default on)\n"
+              << "  --max-concurrent-tools=N\n"
+              << "                        Tool executions at once (default: 4 per core)\n"
+              << "  --tool-queue-budget-ms=N\n"
+              << "                        Longest a tool call may queue before it is rejected\n"
+              << "                        with RESOURCE_EXHAUSTED (default 100)\n"
+              << "  --plugin-dir=DIR      Load native tool plugins (*.so) from DIR\n"
+              << "  --plugin-poll-ms=N    Reload changed plugins every N ms (default 1000,\n"
+              << "                        0 = load once)\n"
+              << "  --log-level=LEVEL     debug|info|warning|error|off (default info; per-message\n"
+              << "                        logging is at debug)\n"
+              << "  --metrics-port=N      Serve Prometheus metrics on 127.0.0.1:N/metrics\n"
+              << "  --metrics-file=PATH   Rewrite Prometheus metrics to PATH periodically\n"
+              << "  --metrics-interval-ms=N\n"
+              << "                        Metrics file rewrite interval (default 10000)\n";
+}
+
+bool ParseOptions(int argc, char** argv, ServerOptions* options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value_of = [&arg](const std::string& flag) { return arg.substr(flag.size()); };
+        
+        if (arg.rfind("--address=", 0) == 0) {
+            options->address = value_of("--address=");
+        } else if (arg.rfind("--mode=", 0) == 0) {
+            options->mode = value_of("--mode=");
+            if (options->mode != "sync" && options->mode != "callback") {
+                GMCP_LOG(kError) << "Unknown mode: " << options->mode;
+                return false;
+            }
+        } else if (arg.rfind("--executor-threads=", 0) == 0) {
+            options->coordinator.executor_threads = std::stoul(value_of("--executor-threads="));
+        } else if (arg.rfind("--stream-window=", 0) == 0) {
+            options->coordinator.stream_window = std::stoul(value_of("--stream-window="));
+        } else if (arg.rfind("--event-queue-depth=", 0) == 0) {
+            options->coordinator.events.queue_capacity = std::stoul(value_of("--event-queue-depth="));
+        } else if (arg.rfind("--event-overflow=", 0) == 0) {
+            std::string policy = value_of("--event-overflow=");
+            if (policy == "drop-oldest") {
+                options->coordinator.events.overflow = gmcp::OverflowPolicy::kDropOldest;
+            } else if (policy == "disconnect") {
+                options->coordinator.events.overflow = gmcp::OverflowPolicy::kDisconnect;
+            } else {
+                GMCP_LOG(kError) << "Unknown overflow policy: " << policy;
+                return false;
+            }
+        } else if (arg.rfind("--data-dir=", 0) == 0) {
+            options->coordinator.memory.data_dir = value_of("--data-dir=");
+        } else if (arg.rfind("--wal-sync=", 0) == 0) {
+            std::string sync = value_of("--wal-sync=");
+            if (sync != "on" && sync != "off") {
+                GMCP_LOG(kError) << "Unknown wal-sync setting: " << sync;
+                return false;
+            }
+            options->coordinator.memory.sync_writes = sync == "on";
+        } else if (arg.rfind("--snapshot-log-mb=", 0) == 0) {
+            options->coordinator.memory.snapshot_log_bytes =
+                std::stoul(value_of("--snapshot-log-mb=")) << 20;
+        } else if (arg.rfind("--tool-cache-mb=", 0) == 0) {
+            options->coordinator.tools.cache.max_bytes =
+                std::stoul(value_of("--tool-cache-mb=")) << 20;
+        } else if (arg.rfind("--coalesce-tools=", 0) == 0) {
+            std::string coalesce = value_of("--coalesce-tools=");
+            if (coalesce != "on" && coalesce != "off") {
+                GMCP_LOG(kError) << "Unknown coalesce-tools setting: " << coalesce;
+                return false;
+            }
+            options->coordinator.tools.coalesce = coalesce == "on";
+        } else if (arg.rfind("--max-concurrent-tools=", 0) == 0) {
+            options->coordinator.tools.max_concurrent =
+                std::stoul(value_of("--max-concurrent-tools="));
+        } else if (arg.rfind("--tool-queue-budget-ms=", 0) == 0) {
+            options->coordinator.tools.queue_budget =
+                std::chrono::milliseconds(std::stoul(value_of("--tool-queue-budget-ms=")));
+        } else if (arg.rfind("--plugin-dir=", 0) == 0) {
+            options->plugins.directory = value_of("--plugin-dir=");
+        } else if (arg.rfind("--plugin-poll-ms=", 0) == 0) {
+            options->plugins.poll_interval =
+                std::chrono::milliseconds(std::stoul(value_of("--plugin-poll-ms=")));
+        } else if (arg.rfind("--log-level=", 0) == 0) {
+            std::string level = value_of("--log-level=");
+            if (!gmcp::ParseLogLevel(level, &options->log_level)) {
+                GMCP_LOG(kError) << "Unknown log level: " << level;
+                return false;
+            }
+        } else if (arg.rfind("--metrics-port=", 0) == 0) {
+            options->metrics.http_port =
+                static_cast<uint16_t>(std::stoul(value_of("--metrics-port=")));
+        } else if (arg.rfind("--metrics-file=", 0) == 0) {
+            options->metrics.file_path = value_of("--metrics-file=");
+        } else if (arg.rfind("--metrics-interval-ms=", 0) == 0) {
+            options->metrics.file_interval =
+                std::chrono::milliseconds(std::stoul(value_of("--metrics-interval-ms=")));
+        } else {
+            GMCP_LOG(kError) << "Unknown option: " << arg;
+            return false;
+        }
+    }
+    return true;
+}
+
+void RunServer(const ServerOptions& options) {
+    auto coordinator = std::make_shared<gmcp::AgentCoordinator>(options.coordinator);
     
     // Initialize example tools and memory stores
-    service.InitializeExamples();
+    coordinator->InitializeExamples();
+    
+    std::unique_ptr<gmcp::PluginLoader> plugins;
+    if (!options.plugins.directory.empty()) {
+        plugins = std::make_unique<gmcp::PluginLoader>(
+            options.plugins,
+            [coordinator](const gmcp::ToolRegistration& registration,
+                          gmcp::NativeToolFunction function, uint64_t replaces) {
+                return coordinator->RegisterToolFunction(registration, std::move(function),
+                                                         replaces);
+            },
+            [coordinator](const std::string& tool_id, uint64_t generation) {
+                return coordinator->UnregisterTool(tool_id, generation);
+            });
+    }
+    
+    std::unique_ptr<gmcp::MetricsExporter> exporter;
+    if (options.metrics.http_port != 0 || !options.metrics.file_path.empty()) {
+        exporter = std::make_unique<gmcp::MetricsExporter>(options.metrics, [coordinator] {
+            gmcp::StatsResponse stats;
+            coordinator->GetStats(gmcp::StatsRequest(), &stats);
+            return gmcp::FormatPrometheus(stats);
+        });
+        if (options.metrics.http_port != 0) {
+            GMCP_LOG(kInfo) << "Metrics at http://127.0.0.1:" << options.metrics.http_port
+                            << "/metrics";
+        }
+    }
+    
+    gmcp::AgentCoordinationServiceImpl sync_service(coordinator);
+    gmcp::AgentCoordinationCallbackServiceImpl callback_service(coordinator);
     
     grpc::EnableDefaultHealthCheckService(true);
     grpc::reflection::InitProtoReflectionServerBuilderPlugin();
@@ -18,21 +177,24 @@ void RunServer() {
     grpc::ServerBuilder builder;
     
     // Listen on the given address without any authentication mechanism
-    builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
+    builder.AddListeningPort(options.address, grpc::InsecureServerCredentials());
     
-    // Register "service" as the instance through which we'll communicate
-    builder.RegisterService(&service);
+    // Register the selected implementation as the instance through which we'll communicate
+    if (options.mode == "callback") {
+        builder.RegisterService(&callback_service);
+    } else {
+        builder.RegisterService(&sync_service);
+    }
     
     // Assemble the server
     std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
-    std::cout << "gMCP Server listening on " << server_address << std::endl;
-    std::cout << "Ultra-low-latency, bidirectional agent coordination ready!" << std::endl;
-    std::cout << "Features:" << std::endl;
-    std::cout << "  - Bidirectional streaming for real-time communication" << std::endl;
-    std::cout << "  - Dynamic tool registration and invocation" << std::endl;
-    std::cout << "  - Memory plugin system" << std::endl;
-    std::cout << "  - Event subscription and streaming" << std::endl;
-    std::cout << "\nPress Ctrl+C to shutdown" << std::endl;
+    if (!server) {
+        throw std::runtime_error("failed to start server on " + options.address);
+    }
+    GMCP_LOG(kInfo) << "gMCP Server listening on " << options.address << " (" << options.mode
+                    << " mode)";
+    GMCP_LOG(kInfo) << "Ultra-low-latency, bidirectional agent coordination ready! "
+                    << "Press Ctrl+C to shutdown";
     
     // Wait for the server to shutdown
     server->Wait();
@@ -40,9 +202,16 @@ void RunServer() {
 
 int main(int argc, char** argv) {
     try {
-        RunServer();
+        ServerOptions options;
+        if (!ParseOptions(argc, argv, &options)) {
+            gmcp::Logger::Instance().Flush();
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        gmcp::Logger::Instance().set_level(options.log_level);
+        RunServer(options);
     } catch (const std::exception& e) {
-        std::cerr << "Server error: " << e.what() << std::endl;
+        GMCP_LOG(kError) << "Server error: " << e.what();
         return 1;
     }
     return 0;
@@ -1,111 +1,396 @@
 #include "memory_manager.h"
 #include <chrono>
-#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+#include "common/logging.h"
 
 namespace gmcp {
 
+namespace {
+
+constexpr char kSnapshotFile[] = "memory.snapshot";
+constexpr auto kSnapshotCheckInterval = std::chrono::seconds(1);
+// Entries handed to a store per PutBatch while loading a snapshot
+constexpr size_t kLoadBatchSize = 4096;
+
+// Serialize entries as a MemoryWrite without first copying them into one
+std::string EncodeWrite(const std::string& memory_id, const MemoryEntry* entries, size_t count) {
+    using google::protobuf::internal::WireFormatLite;
+    std::string payload;
+    {
+        google::protobuf::io::StringOutputStream stream(&payload);
+        google::protobuf::io::CodedOutputStream out(&stream);
+        out.WriteTag(WireFormatLite::MakeTag(MemoryWrite::kMemoryIdFieldNumber,
+                                             WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+        out.WriteVarint32(static_cast<uint32_t>(memory_id.size()));
+        out.WriteString(memory_id);
+        for (size_t i = 0; i < count; ++i) {
+            out.WriteTag(WireFormatLite::MakeTag(MemoryWrite::kEntriesFieldNumber,
+                                                 WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+            out.WriteVarint32(static_cast<uint32_t>(entries[i].ByteSizeLong()));
+            entries[i].SerializeWithCachedSizes(&out);
+        }
+    }
+    return payload;
+}
+
+} // namespace
+
+MemoryManager::MemoryManager() : MemoryManager(Options()) {
+}
+
+MemoryManager::MemoryManager(const Options& options) : options_(options) {
+    if (options_.data_dir.empty()) {
+        return;
+    }
+    WriteAheadLog::Options log_options;
+    log_options.sync = options_.sync_writes;
+    wal_ = std::make_unique<WriteAheadLog>(
+        (std::filesystem::path(options_.data_dir) / "wal").string(), log_options);
+    Recover();
+    snapshot_thread_ = std::thread([this] { SnapshotLoop(); });
+}
+
+MemoryManager::~MemoryManager() {
+    if (!wal_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(snapshot_loop_mutex_);
+        stopping_ = true;
+    }
+    snapshot_loop_cv_.notify_all();
+    snapshot_thread_.join();
+    // Leave nothing to replay after a clean shutdown
+    if (wal_->bytes_since_rotate() > 0) {
+        Snapshot();
+    }
+}
+
+std::shared_ptr<const MemoryManager::StoreEntry> MemoryManager::AddStore(
+    const MemoryRegistration& registration) {
+    auto entry = std::make_shared<StoreEntry>();
+    entry->registration = std::make_shared<MemoryRegistration>(registration);
+    entry->store = CreateMemoryStore(registration);
+
+    bool added = stores_.Update([&](StoreTable& stores) {
+        // Memory store already registered
+        return stores.emplace(registration.memory_id(), entry).second;
+    });
+    return added ? entry : nullptr;
+}
+
 bool MemoryManager::RegisterMemory(const MemoryRegistration& registration) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    if (memories_.find(registration.memory_id()) != memories_.end()) {
+    std::lock_guard<std::mutex> lock(registration_mutex_);
+    if (HasStore(registration.memory_id())) {
         return false; // Memory store already registered
     }
-    
-    auto mem_reg = std::make_shared<MemoryRegistration>(registration);
-    memories_[registration.memory_id()] = mem_reg;
-    storage_[registration.memory_id()] = std::map<std::string, MemoryEntry>();
-    
-    return true;
+    if (wal_ && !wal_->Append(WriteAheadLog::RecordType::kRegister,
+                              registration.SerializeAsString())) {
+        return false;
+    }
+    return AddStore(registration) != nullptr;
 }
 
-bool MemoryManager::Store(const std::string& memory_id, const MemoryEntry& entry) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    if (memories_.find(memory_id) == memories_.end()) {
-        return false; // Memory store not registered
+std::shared_ptr<const MemoryManager::StoreEntry> MemoryManager::FindStore(
+    const std::string& memory_id) const {
+    auto stores = stores_.Read();
+    auto it = stores->find(memory_id);
+    if (it == stores->end()) {
+        return nullptr;
     }
-    
-    storage_[memory_id][entry.key()] = entry;
-    return true;
+    Load(*it->second);
+    return it->second;
 }
 
-MemoryResult MemoryManager::Query(const MemoryQuery& query) {
-    MemoryResult result;
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto mem_it = storage_.find(query.memory_id());
-    if (mem_it == storage_.end()) {
-        return result; // Empty result
-    }
-    
-    const auto& store = mem_it->second;
-    
-    switch (query.query_type()) {
-        case QueryType::GET: {
-            // Get specific key
-            auto it = store.find(query.query());
-            if (it != store.end()) {
-                *result.add_entries() = it->second;
-                result.set_total_count(1);
-            }
-            break;
-        }
-        
-        case QueryType::LIST: {
-            // List all entries
-            int limit = query.limit() > 0 ? query.limit() : 100;
-            int count = 0;
-            for (const auto& [key, entry] : store) {
-                if (count >= limit) {
-                    result.set_has_more(true);
-                    break;
+bool MemoryManager::HasStore(const std::string& memory_id) const {
+    return stores_.Read()->count(memory_id) != 0;
+}
+
+void MemoryManager::Load(const StoreEntry& store) const {
+    std::call_once(store.loaded, [&] {
+        size_t loaded = 0;
+        if (store.image) {
+            std::vector<MemoryEntry> batch;
+            batch.reserve(kLoadBatchSize);
+            bool intact = MappedSnapshot::ForEachEntry(*store.image, [&](std::string_view bytes) {
+                batch.emplace_back();
+                batch.back().ParseFromArray(bytes.data(), static_cast<int>(bytes.size()));
+                if (batch.size() == kLoadBatchSize) {
+                    loaded += store.store->PutBatch(std::move(batch));
+                    batch.clear();
                 }
-                *result.add_entries() = entry;
-                count++;
+            });
+            if (!intact) {
+                GMCP_LOG(kError) << "Corrupt entries for " << store.registration->memory_id()
+                                 << " in " << SnapshotPath() << "; loaded " << loaded;
             }
-            result.set_total_count(store.size());
-            break;
+            loaded += store.store->PutBatch(std::move(batch));
+            store.image = nullptr;
         }
-        
-        case QueryType::SEARCH: {
-            // Simple substring search in keys and values
-            int limit = query.limit() > 0 ? query.limit() : 100;
-            int count = 0;
-            for (const auto& [key, entry] : store) {
-                if (count >= limit) {
-                    result.set_has_more(true);
-                    break;
-                }
-                if (key.find(query.query()) != std::string::npos ||
-                    entry.value().find(query.query()) != std::string::npos) {
-                    *result.add_entries() = entry;
-                    count++;
-                }
-            }
-            result.set_total_count(count);
-            break;
+        for (MemoryWrite& write : store.backlog) {
+            std::vector<MemoryEntry> entries(
+                std::make_move_iterator(write.mutable_entries()->begin()),
+                std::make_move_iterator(write.mutable_entries()->end()));
+            store.store->PutBatch(std::move(entries));
+        }
+        GMCP_LOG(kDebug) << "Loaded " << store.registration->memory_id() << ": " << loaded
+                         << " snapshot entries and " << store.backlog.size() << " log records";
+        std::vector<MemoryWrite>().swap(store.backlog);
+    });
+}
+
+bool MemoryManager::LogWrite(const StoreEntry& store, const std::string& payload,
+                             uint64_t* ticket) {
+    uint64_t lsn;
+    {
+        // Tickets follow LSNs because both are taken under the one lock
+        std::lock_guard<std::mutex> lock(store.order_mutex);
+        lsn = wal_->Enqueue(WriteAheadLog::RecordType::kWrite, payload);
+        if (lsn == 0) {
+            return false;
         }
-        
-        default:
-            break;
+        *ticket = ++store.next_ticket;
+    }
+    bool durable = wal_->WaitDurable(lsn);
+
+    WaitTurn(store, *ticket);
+    if (!durable) {
+        // Pass the turn on; the log is failed, so later writes fail too
+        EndTurn(store, *ticket);
+    }
+    return durable;
+}
+
+void MemoryManager::WaitTurn(const StoreEntry& store, uint64_t ticket) {
+    std::unique_lock<std::mutex> lock(store.order_mutex);
+    store.order_cv.wait(lock, [&] { return store.applied_ticket + 1 == ticket; });
+}
+
+void MemoryManager::EndTurn(const StoreEntry& store, uint64_t ticket) {
+    {
+        std::lock_guard<std::mutex> lock(store.order_mutex);
+        store.applied_ticket = ticket;
+    }
+    store.order_cv.notify_all();
+}
+
+bool MemoryManager::Store(const std::string& memory_id, const MemoryEntry& entry) {
+    auto store = FindStore(memory_id);
+    if (!store) {
+        return false; // Memory store not registered
+    }
+    if (!wal_) {
+        return store->store->Put(MemoryEntry(entry));
+    }
+
+    uint64_t ticket;
+    bool stored = false;
+    if (LogWrite(*store, EncodeWrite(memory_id, &entry, 1), &ticket)) {
+        stored = store->store->Put(MemoryEntry(entry));
+        EndTurn(*store, ticket);
     }
-    
+    return stored;
+}
+
+size_t MemoryManager::StoreBatch(const std::string& memory_id,
+                                 std::vector<MemoryEntry>&& entries) {
+    auto store = FindStore(memory_id);
+    if (!store) {
+        return 0; // Memory store not registered
+    }
+    if (!wal_) {
+        return store->store->PutBatch(std::move(entries));
+    }
+
+    // The whole batch is one log record, so it is recovered all or nothing
+    uint64_t ticket;
+    size_t stored = 0;
+    if (LogWrite(*store, EncodeWrite(memory_id, entries.data(), entries.size()), &ticket)) {
+        stored = store->store->PutBatch(std::move(entries));
+        EndTurn(*store, ticket);
+    }
+    return stored;
+}
+
+MemoryResult MemoryManager::Query(const MemoryQuery& query) {
+    MemoryResult result;
+    Query(query, &result);
     return result;
 }
 
+void MemoryManager::Query(const MemoryQuery& query, MemoryResult* result) {
+    auto store = FindStore(query.memory_id());
+    if (!store) {
+        return; // Empty result
+    }
+
+    store->store->Query(query, result);
+}
+
 std::shared_ptr<MemoryRegistration> MemoryManager::GetMemory(const std::string& memory_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = memories_.find(memory_id);
-    return (it != memories_.end()) ? it->second : nullptr;
+    auto stores = stores_.Read();
+    auto it = stores->find(memory_id);
+    return (it != stores->end()) ? it->second->registration : nullptr;
 }
 
 std::vector<std::string> MemoryManager::ListMemories() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto stores = stores_.Read();
     std::vector<std::string> memory_ids;
-    for (const auto& [id, _] : memories_) {
+    for (const auto& [id, _] : *stores) {
         memory_ids.push_back(id);
     }
     return memory_ids;
 }
 
+std::string MemoryManager::SnapshotPath() const {
+    return (std::filesystem::path(options_.data_dir) / kSnapshotFile).string();
+}
+
+void MemoryManager::Recover() {
+    auto start = std::chrono::steady_clock::now();
+
+    // Log position each snapshotted store is complete up to
+    std::unordered_map<std::string, uint64_t> snapshot_lsns;
+    uint64_t base_lsn = 0;
+    size_t mapped = 0;
+    recovered_ = MappedSnapshot::Open(SnapshotPath());
+    if (recovered_) {
+        base_lsn = recovered_->base_lsn();
+        for (const auto& image : recovered_->stores()) {
+            MemoryRegistration registration;
+            if (!registration.ParseFromArray(image.registration.data(),
+                                             static_cast<int>(image.registration.size()))) {
+                throw std::runtime_error("corrupt store registration in " + SnapshotPath());
+            }
+            auto store = AddStore(registration);
+            if (store) {
+                store->image = &image;
+                snapshot_lsns[registration.memory_id()] = image.lsn;
+                mapped += image.entry_count;
+            }
+        }
+    }
+
+    // Writes are only parsed here; they are applied after the image they
+    // follow, when the store is loaded
+    auto stores = stores_.Load();
+    size_t replayed = wal_->Replay(base_lsn, [&](uint64_t lsn, WriteAheadLog::RecordType type,
+                                                 std::string_view payload) {
+        if (type == WriteAheadLog::RecordType::kRegister) {
+            MemoryRegistration registration;
+            if (registration.ParseFromArray(payload.data(), static_cast<int>(payload.size())) &&
+                !snapshot_lsns.count(registration.memory_id()) && AddStore(registration)) {
+                stores = stores_.Load();
+            }
+        } else if (type == WriteAheadLog::RecordType::kWrite) {
+            MemoryWrite write;
+            if (!write.ParseFromArray(payload.data(), static_cast<int>(payload.size()))) {
+                return;
+            }
+            auto covered = snapshot_lsns.find(write.memory_id());
+            if (covered != snapshot_lsns.end() && lsn <= covered->second) {
+                return; // Already in the snapshot
+            }
+            auto it = stores->find(write.memory_id());
+            if (it != stores->end()) {
+                it->second->backlog.push_back(std::move(write));
+            }
+        }
+    });
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    GMCP_LOG(kInfo) << "Mapped " << mapped << " snapshot entries and read " << replayed
+                    << " log records from " << options_.data_dir << " in " << elapsed.count()
+                    << " ms";
+}
+
+void MemoryManager::LoadRecovered() {
+    auto start = std::chrono::steady_clock::now();
+    auto stores = stores_.Load();
+    if (stores->empty()) {
+        return;
+    }
+    for (const auto& [id, entry] : *stores) {
+        {
+            std::lock_guard<std::mutex> lock(snapshot_loop_mutex_);
+            if (stopping_) {
+                return;
+            }
+        }
+        Load(*entry);
+    }
+    // No store refers to the mapping any more
+    recovered_.reset();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    GMCP_LOG(kInfo) << "Loaded " << stores->size() << " memory stores in the background in "
+                    << elapsed.count() << " ms";
+}
+
+bool MemoryManager::Snapshot() {
+    if (!wal_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+
+    // Stores registered after this point have their registration in the new
+    // log segment, which the snapshot never truncates
+    uint64_t base_lsn;
+    std::shared_ptr<const StoreTable> stores;
+    {
+        std::lock_guard<std::mutex> registration_lock(registration_mutex_);
+        base_lsn = wal_->Rotate();
+        stores = stores_.Load();
+    }
+
+    SnapshotWriter writer(SnapshotPath(), base_lsn, static_cast<uint32_t>(stores->size()));
+    for (const auto& [id, entry] : *stores) {
+        Load(*entry);
+        // Every write to this store logged up to `lsn` holds an earlier
+        // ticket, so it is applied by the time this turn comes. Later writes
+        // wait only until the store pins the state it visits, not for the
+        // whole image to be written; replay skips exactly those up to `lsn`.
+        uint64_t ticket;
+        uint64_t lsn;
+        {
+            std::lock_guard<std::mutex> order_lock(entry->order_mutex);
+            ticket = ++entry->next_ticket;
+            lsn = wal_->last_lsn();
+        }
+        WaitTurn(*entry, ticket);
+        writer.BeginStore(*entry->registration, lsn);
+        entry->store->ForEach([&writer](const MemoryEntry& e) { writer.Add(e); },
+                              [&] { EndTurn(*entry, ticket); });
+        writer.EndStore();
+    }
+    if (!writer.Commit()) {
+        GMCP_LOG(kError) << "Failed to write snapshot " << SnapshotPath();
+        return false;
+    }
+    wal_->Truncate(base_lsn);
+    return true;
+}
+
+void MemoryManager::SnapshotLoop() {
+    LoadRecovered();
+    std::unique_lock<std::mutex> lock(snapshot_loop_mutex_);
+    while (!stopping_) {
+        snapshot_loop_cv_.wait_for(lock, kSnapshotCheckInterval);
+        if (stopping_ || wal_->bytes_since_rotate() < options_.snapshot_log_bytes) {
+            continue;
+        }
+        lock.unlock();
+        Snapshot();
+        lock.lock();
+    }
+}
+
 } // namespace gmcp
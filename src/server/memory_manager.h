@@ -1,18 +1,43 @@
 #pragma once
 
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <memory>
-#include <mutex>
 #include "gmcp.grpc.pb.h"
+#include "memory_snapshot.h"
+#include "memory_store.h"
+#include "rcu_snapshot.h"
+#include "write_ahead_log.h"
 
 namespace gmcp {
 
+// Registry of memory stores. With a data directory configured, every
+// registration and write is group committed to a write-ahead log before it is
+// applied, and a background thread periodically writes a snapshot of all
+// stores and drops the log it covers. Startup maps the latest snapshot and
+// reads only the log written after it; each store is loaded from the mapping
+// in the background, or by the first request that needs it.
 class MemoryManager {
 public:
-    MemoryManager() = default;
-    ~MemoryManager() = default;
+    struct Options {
+        // Directory for the write-ahead log and snapshots; empty keeps the
+        // stores in memory only
+        std::string data_dir;
+        // fdatasync each commit group before acknowledging its writes
+        bool sync_writes = true;
+        // Log bytes written since the last snapshot that trigger a new one
+        size_t snapshot_log_bytes = 64 << 20;
+    };
+
+    MemoryManager();
+    explicit MemoryManager(const Options& options);
+    ~MemoryManager();
 
     // Register a memory store
     bool RegisterMemory(const MemoryRegistration& registration);
@@ -20,20 +45,93 @@ public:
     // Store a memory entry
     bool Store(const std::string& memory_id, const MemoryEntry& entry);
     
+    // Store many entries, taking each of the store's locks at most once.
+    // Returns the number stored (0 if the store is not registered).
+    size_t StoreBatch(const std::string& memory_id, std::vector<MemoryEntry>&& entries);
+    
     // Query memory
     MemoryResult Query(const MemoryQuery& query);
     
+    // Query memory into `result`, e.g. a field of an arena-allocated reply,
+    // so entries are copied out of the store exactly once
+    void Query(const MemoryQuery& query, MemoryResult* result);
+    
     // Get memory registration by ID
     std::shared_ptr<MemoryRegistration> GetMemory(const std::string& memory_id);
     
     // List all registered memory stores
     std::vector<std::string> ListMemories() const;
 
+    // Write a snapshot of every store and drop the log it covers. Returns
+    // false if persistence is off or the snapshot could not be written.
+    bool Snapshot();
+
 private:
-    std::mutex mutex_;
-    std::map<std::string, std::shared_ptr<MemoryRegistration>> memories_;
-    // Simple in-memory storage: memory_id -> key -> MemoryEntry
-    std::map<std::string, std::map<std::string, MemoryEntry>> storage_;
+    struct StoreEntry {
+        std::shared_ptr<MemoryRegistration> registration;
+        std::shared_ptr<MemoryStore> store;
+        // Writes are applied in the order they were logged, or a restart
+        // could replay two writes to one key the other way round. Each write
+        // takes a ticket with its log record and applies once every earlier
+        // ticket has; the log still group commits them concurrently. A
+        // snapshot takes a ticket too, so it sees exactly the writes logged
+        // before it.
+        mutable std::mutex order_mutex;
+        mutable std::condition_variable order_cv;
+        mutable uint64_t next_ticket = 0;
+        mutable uint64_t applied_ticket = 0;
+
+        // Snapshot image and logged writes that recovery left to load
+        mutable std::once_flag loaded;
+        mutable const MappedSnapshot::StoreImage* image = nullptr;
+        mutable std::vector<MemoryWrite> backlog;
+    };
+    using StoreTable = std::map<std::string, std::shared_ptr<const StoreEntry>>;
+
+    // Looks up a store without locking, loading it first if recovery left it
+    // unloaded; the returned reference keeps the store alive while it is used
+    std::shared_ptr<const StoreEntry> FindStore(const std::string& memory_id) const;
+    bool HasStore(const std::string& memory_id) const;
+
+    // Apply the store's snapshot image and then its logged writes, once
+    void Load(const StoreEntry& store) const;
+
+    // Log a write to `store` and wait until it is durable and every earlier
+    // write to the store is applied. Returns false, without a turn, if the
+    // write could not be logged; otherwise the caller applies it and calls
+    // EndTurn with `ticket`.
+    bool LogWrite(const StoreEntry& store, const std::string& payload, uint64_t* ticket);
+    void WaitTurn(const StoreEntry& store, uint64_t ticket);
+    void EndTurn(const StoreEntry& store, uint64_t ticket);
+
+    // Create and publish a store without logging it. Returns null if the
+    // store is already registered.
+    std::shared_ptr<const StoreEntry> AddStore(const MemoryRegistration& registration);
+
+    // Map the snapshot and read the log written after it, leaving each store
+    // to be loaded by Load
+    void Recover();
+    // Load every store recovery left unloaded, then drop the mapping
+    void LoadRecovered();
+    std::string SnapshotPath() const;
+    void SnapshotLoop();
+
+    const Options options_;
+    std::unique_ptr<WriteAheadLog> wal_;
+    // Snapshot mapped at startup, until every store is loaded from it
+    std::unique_ptr<MappedSnapshot> recovered_;
+
+    // Registrations publish a new table; reads and writes only lock inside
+    // the store they address, so stores never contend with each other
+    RcuSnapshot<StoreTable> stores_;
+    // Orders registrations against the start of a snapshot
+    std::mutex registration_mutex_;
+    std::mutex snapshot_mutex_;
+
+    std::mutex snapshot_loop_mutex_;
+    std::condition_variable snapshot_loop_cv_;
+    bool stopping_ = false;
+    std::thread snapshot_thread_;
 };
 
 } // namespace gmcp
@@ -0,0 +1,197 @@
+#include "memory_snapshot.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+namespace gmcp {
+
+namespace {
+
+constexpr char kHeaderMagic[8] = {'G', 'M', 'C', 'P', 'S', 'N', 'P', '1'};
+constexpr char kTrailerMagic[8] = {'G', 'M', 'C', 'P', 'E', 'N', 'D', '1'};
+constexpr size_t kFlushThreshold = 1 << 20;
+
+// Bounds-checked reader over the mapping
+class Cursor {
+public:
+    explicit Cursor(std::string_view data) : rest_(data) {}
+
+    template <typename T>
+    T Read() {
+        T value;
+        std::memcpy(&value, Take(sizeof(T)).data(), sizeof(T));
+        return value;
+    }
+
+    std::string_view Take(size_t size) {
+        if (rest_.size() < size) {
+            throw std::runtime_error("snapshot is truncated");
+        }
+        std::string_view taken = rest_.substr(0, size);
+        rest_.remove_prefix(size);
+        return taken;
+    }
+
+    size_t remaining() const { return rest_.size(); }
+
+private:
+    std::string_view rest_;
+};
+
+} // namespace
+
+SnapshotWriter::SnapshotWriter(const std::string& path, uint64_t base_lsn, uint32_t store_count)
+    : path_(path), temp_path_(path + ".tmp") {
+    fd_ = ::open(temp_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    ok_ = fd_ >= 0;
+    buffer_.reserve(kFlushThreshold + 4096);
+    Append(kHeaderMagic, sizeof(kHeaderMagic));
+    Append(&base_lsn, sizeof(base_lsn));
+    Append(&store_count, sizeof(store_count));
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    if (fd_ >= 0) {
+        // Not committed
+        ::close(fd_);
+        ::unlink(temp_path_.c_str());
+    }
+}
+
+void SnapshotWriter::Append(const void* data, size_t size) {
+    buffer_.append(static_cast<const char*>(data), size);
+    if (buffer_.size() >= kFlushThreshold) {
+        Flush();
+    }
+}
+
+void SnapshotWriter::Flush() {
+    const char* position = buffer_.data();
+    size_t remaining = buffer_.size();
+    while (ok_ && remaining > 0) {
+        ssize_t written = ::write(fd_, position, remaining);
+        if (written < 0) {
+            ok_ = errno == EINTR;
+            continue;
+        }
+        position += written;
+        remaining -= written;
+    }
+    offset_ += buffer_.size();
+    buffer_.clear();
+}
+
+void SnapshotWriter::BeginStore(const MemoryRegistration& registration, uint64_t lsn) {
+    std::string bytes = registration.SerializeAsString();
+    uint32_t length = static_cast<uint32_t>(bytes.size());
+    Append(&length, sizeof(length));
+    Append(bytes.data(), bytes.size());
+    Append(&lsn, sizeof(lsn));
+    // entry_count and entries_bytes are filled in by EndStore
+    counts_offset_ = offset_ + buffer_.size();
+    entry_count_ = 0;
+    uint64_t placeholder[2] = {0, 0};
+    Append(placeholder, sizeof(placeholder));
+}
+
+void SnapshotWriter::Add(const MemoryEntry& entry) {
+    size_t size = entry.ByteSizeLong();
+    uint32_t length = static_cast<uint32_t>(size);
+    buffer_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    size_t start = buffer_.size();
+    buffer_.resize(start + size);
+    entry.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(buffer_.data() + start));
+    ++entry_count_;
+    if (buffer_.size() >= kFlushThreshold) {
+        Flush();
+    }
+}
+
+void SnapshotWriter::EndStore() {
+    uint64_t entries_start = counts_offset_ + 2 * sizeof(uint64_t);
+    uint64_t counts[2] = {entry_count_, offset_ + buffer_.size() - entries_start};
+    if (counts_offset_ >= offset_) {
+        std::memcpy(buffer_.data() + (counts_offset_ - offset_), counts, sizeof(counts));
+    } else {
+        Flush();
+        ok_ = ok_ && ::pwrite(fd_, counts, sizeof(counts), counts_offset_) == sizeof(counts);
+    }
+}
+
+bool SnapshotWriter::Commit() {
+    Append(kTrailerMagic, sizeof(kTrailerMagic));
+    Flush();
+    ok_ = ok_ && ::fsync(fd_) == 0;
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (!ok_ || ::rename(temp_path_.c_str(), path_.c_str()) != 0) {
+        ::unlink(temp_path_.c_str());
+        return false;
+    }
+    std::string directory = std::filesystem::path(path_).parent_path().string();
+    int dir_fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    return true;
+}
+
+std::unique_ptr<MappedSnapshot> MappedSnapshot::Open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return nullptr;
+        }
+        throw std::runtime_error("cannot open snapshot " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot read snapshot " + path);
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("cannot map snapshot " + path);
+    }
+    // Stores are loaded front to back
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+    std::unique_ptr<MappedSnapshot> snapshot(
+        new MappedSnapshot(static_cast<const char*>(mapping), size));
+
+    Cursor cursor(std::string_view(snapshot->data_, size));
+    if (cursor.Take(sizeof(kHeaderMagic)) != std::string_view(kHeaderMagic, sizeof(kHeaderMagic))) {
+        throw std::runtime_error(path + " is not a gMCP snapshot");
+    }
+    snapshot->base_lsn_ = cursor.Read<uint64_t>();
+    uint32_t store_count = cursor.Read<uint32_t>();
+    for (uint32_t i = 0; i < store_count; ++i) {
+        StoreImage store;
+        store.registration = cursor.Take(cursor.Read<uint32_t>());
+        store.lsn = cursor.Read<uint64_t>();
+        store.entry_count = cursor.Read<uint64_t>();
+        store.entries = cursor.Take(cursor.Read<uint64_t>());
+        snapshot->stores_.push_back(store);
+    }
+    if (cursor.remaining() != sizeof(kTrailerMagic) ||
+        cursor.Take(sizeof(kTrailerMagic)) !=
+            std::string_view(kTrailerMagic, sizeof(kTrailerMagic))) {
+        throw std::runtime_error("snapshot " + path + " is incomplete");
+    }
+    return snapshot;
+}
+
+MappedSnapshot::~MappedSnapshot() {
+    ::munmap(const_cast<char*>(data_), size_);
+}
+
+} // namespace gmcp
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "gmcp.grpc.pb.h"
+
+namespace gmcp {
+
+// Snapshot file layout (host byte order):
+//
+//   "GMCPSNP1" | u64 base_lsn | u32 store_count
+//   per store:  u32 length | MemoryRegistration | u64 lsn
+//               u64 entry_count | u64 entries_bytes | (u32 length | MemoryEntry)*
+//   "GMCPEND1"
+//
+// Each store records the log position its image is complete up to, so replay
+// skips the log records it already contains. Sizes are written up front so a
+// reader can find every store without touching its entries.
+
+// Writes a snapshot to a temporary file that replaces `path` on Commit, so a
+// crash mid-snapshot leaves the previous snapshot in place.
+class SnapshotWriter {
+public:
+    SnapshotWriter(const std::string& path, uint64_t base_lsn, uint32_t store_count);
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    void BeginStore(const MemoryRegistration& registration, uint64_t lsn);
+    void Add(const MemoryEntry& entry);
+    void EndStore();
+
+    // Sync the file and atomically move it into place
+    bool Commit();
+
+private:
+    void Append(const void* data, size_t size);
+    void Flush();
+
+    std::string path_;
+    std::string temp_path_;
+    int fd_ = -1;
+    bool ok_ = true;
+    std::string buffer_;
+    uint64_t offset_ = 0;
+
+    // Position of the current store's entry_count field and first entry
+    uint64_t counts_offset_ = 0;
+    uint64_t entry_count_ = 0;
+};
+
+// Read-only memory mapping of a snapshot. Entries are parsed straight out of
+// the mapping; nothing is copied until a store consumes them.
+class MappedSnapshot {
+public:
+    struct StoreImage {
+        std::string_view registration;
+        uint64_t lsn;
+        uint64_t entry_count;
+        std::string_view entries;
+    };
+
+    // Returns null if there is no snapshot at `path`. Throws
+    // std::runtime_error if the file is not a complete snapshot.
+    static std::unique_ptr<MappedSnapshot> Open(const std::string& path);
+    ~MappedSnapshot();
+
+    MappedSnapshot(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+
+    uint64_t base_lsn() const { return base_lsn_; }
+    const std::vector<StoreImage>& stores() const { return stores_; }
+    size_t file_size() const { return size_; }
+
+    // Calls fn(bytes) with the serialized form of each entry of a store.
+    // Returns false if the entries are malformed.
+    template <typename Fn>
+    static bool ForEachEntry(const StoreImage& store, Fn&& fn);
+
+private:
+    MappedSnapshot(const char* data, size_t size) : data_(data), size_(size) {}
+
+    const char* data_;
+    size_t size_;
+    uint64_t base_lsn_ = 0;
+    std::vector<StoreImage> stores_;
+};
+
+template <typename Fn>
+bool MappedSnapshot::ForEachEntry(const StoreImage& store, Fn&& fn) {
+    std::string_view rest = store.entries;
+    for (uint64_t i = 0; i < store.entry_count; ++i) {
+        uint32_t length;
+        if (rest.size() < sizeof(length)) {
+            return false;
+        }
+        std::memcpy(&length, rest.data(), sizeof(length));
+        rest.remove_prefix(sizeof(length));
+        if (rest.size() < length) {
+            return false;
+        }
+        fn(rest.substr(0, length));
+        rest.remove_prefix(length);
+    }
+    return rest.empty();
+}
+
+} // namespace gmcp
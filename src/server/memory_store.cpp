@@ -0,0 +1,88 @@
+#include "memory_store.h"
+#include <cstdlib>
+#include <string>
+#include "graph_store.h"
+#include "key_value_store.h"
+#include "temporal_store.h"
+#include "vector_store.h"
+
+namespace gmcp {
+
+namespace {
+
+const std::string* FindOption(const MemoryRegistration& registration, const std::string& name) {
+    auto it = registration.options().find(name);
+    return it != registration.options().end() ? &it->second : nullptr;
+}
+
+bool OptionIs(const MemoryRegistration& registration, const std::string& name,
+              const std::string& value) {
+    const std::string* option = FindOption(registration, name);
+    return option && *option == value;
+}
+
+// Positive integer option, or `fallback` if absent or invalid
+size_t OptionNumber(const MemoryRegistration& registration, const std::string& name,
+                    size_t fallback) {
+    const std::string* option = FindOption(registration, name);
+    if (!option) {
+        return fallback;
+    }
+    size_t value = std::strtoull(option->c_str(), nullptr, 10);
+    return value > 0 ? value : fallback;
+}
+
+std::unique_ptr<MemoryStore> CreateVectorStore(const MemoryRegistration& registration) {
+    VectorStore::Options options;
+    options.dimension = OptionNumber(registration, "dimension", 0);
+    if (OptionIs(registration, "metric", "l2")) {
+        options.metric = VectorMetric::kL2;
+    } else if (OptionIs(registration, "metric", "dot")) {
+        options.metric = VectorMetric::kDot;
+    }
+    options.hnsw = !OptionIs(registration, "index", "flat");
+    options.hnsw_options.m = OptionNumber(registration, "hnsw_m", options.hnsw_options.m);
+    options.hnsw_options.ef_construction =
+        OptionNumber(registration, "ef_construction", options.hnsw_options.ef_construction);
+    options.ef_search = OptionNumber(registration, "ef_search", options.ef_search);
+    options.exact_search_threshold =
+        OptionNumber(registration, "exact_threshold", options.exact_search_threshold);
+    return std::make_unique<VectorStore>(options);
+}
+
+std::unique_ptr<MemoryStore> CreateTemporalStore(const MemoryRegistration& registration) {
+    TemporalStore::Options options;
+    options.segment_size = OptionNumber(registration, "segment_size", options.segment_size);
+    options.merge_fan_in = OptionNumber(registration, "merge_fan_in", options.merge_fan_in);
+    return std::make_unique<TemporalStore>(options);
+}
+
+std::unique_ptr<MemoryStore> CreateGraphStore(const MemoryRegistration& registration) {
+    GraphStore::Options options;
+    options.min_fold_size = OptionNumber(registration, "min_fold_size", options.min_fold_size);
+    return std::make_unique<GraphStore>(options);
+}
+
+} // namespace
+
+std::unique_ptr<MemoryStore> CreateMemoryStore(const MemoryRegistration& registration) {
+    switch (registration.type()) {
+        case MemoryType::VECTOR_STORE:
+            return CreateVectorStore(registration);
+        
+        case MemoryType::TEMPORAL:
+            return CreateTemporalStore(registration);
+        
+        case MemoryType::GRAPH:
+            return CreateGraphStore(registration);
+        
+        default: {
+            // Other memory types are served by the ordered key-value backend
+            KeyValueStore::Options options;
+            options.trigram_index = OptionIs(registration, "search_index", "trigram");
+            return std::make_unique<KeyValueStore>(options);
+        }
+    }
+}
+
+} // namespace gmcp
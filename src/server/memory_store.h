@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "gmcp.grpc.pb.h"
+
+namespace gmcp {
+
+// Storage backend of one registered memory store. Implementations do their
+// own locking so that stores never contend with each other.
+class MemoryStore {
+public:
+    virtual ~MemoryStore() = default;
+
+    // Insert or replace an entry. Returns false if the backend rejects it
+    // (e.g. a vector store entry without a matching embedding).
+    virtual bool Put(MemoryEntry&& entry) = 0;
+
+    // Insert or replace many entries, taking each internal lock at most once.
+    // Returns the number accepted.
+    virtual size_t PutBatch(std::vector<MemoryEntry>&& entries) = 0;
+
+    // Answer a query into `result`, which may live on the caller's arena;
+    // unsupported query types leave it empty
+    virtual void Query(const MemoryQuery& query, MemoryResult* result) const = 0;
+
+    // Number of entries currently stored
+    virtual size_t size() const = 0;
+
+    // Visit every stored entry as it would be written back with Put, e.g. to
+    // snapshot the store. `pinned` runs once, before the first visit, when
+    // the visited state is fixed: it holds every write applied before then,
+    // and replaying the later ones with Put reproduces the live store.
+    // Concurrent writers may be held off while it runs.
+    virtual void ForEach(const std::function<void(const MemoryEntry&)>& visit,
+                         const std::function<void()>& pinned) const = 0;
+};
+
+// Create the backend for a registration
+std::unique_ptr<MemoryStore> CreateMemoryStore(const MemoryRegistration& registration);
+
+} // namespace gmcp
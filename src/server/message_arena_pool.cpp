@@ -0,0 +1,73 @@
+#include "message_arena_pool.h"
+#include <algorithm>
+
+namespace gmcp {
+
+namespace {
+
+google::protobuf::ArenaOptions SlotArenaOptions(char* block, size_t size) {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = block;
+    options.initial_block_size = size;
+    return options;
+}
+
+} // namespace
+
+MessageArenaPool::Slot::Slot(size_t initial_block)
+    : block_(new char[initial_block]),
+      arena_(SlotArenaOptions(block_.get(), initial_block)) {
+    request_ = google::protobuf::Arena::CreateMessage<AgentMessage>(&arena_);
+    response_ = google::protobuf::Arena::CreateMessage<AgentMessage>(&arena_);
+}
+
+void MessageArenaPool::Slot::Reset() {
+    arena_.Reset();
+    request_ = google::protobuf::Arena::CreateMessage<AgentMessage>(&arena_);
+    response_ = google::protobuf::Arena::CreateMessage<AgentMessage>(&arena_);
+}
+
+MessageArenaPool::MessageArenaPool() : MessageArenaPool(Options()) {
+}
+
+MessageArenaPool::MessageArenaPool(const Options& options) : options_(options) {
+}
+
+MessageArenaPool::Slot* MessageArenaPool::Acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_.empty()) {
+        Slot* slot = free_.back();
+        free_.pop_back();
+        return slot;
+    }
+    slots_.push_back(std::unique_ptr<Slot>(new Slot(options_.initial_block)));
+    return slots_.back().get();
+}
+
+void MessageArenaPool::Release(Slot* slot) {
+    std::unique_ptr<Slot> trimmed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() >= options_.max_idle_slots) {
+            auto it = std::find_if(slots_.begin(), slots_.end(),
+                                   [slot](const auto& owned) { return owned.get() == slot; });
+            trimmed = std::move(*it);
+            *it = std::move(slots_.back());
+            slots_.pop_back();
+        }
+    }
+    if (trimmed) {
+        return; // Freed outside the lock
+    }
+    // Reset outside the lock; the slot is still exclusively ours
+    slot->Reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(slot);
+}
+
+size_t MessageArenaPool::slot_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.size();
+}
+
+} // namespace gmcp
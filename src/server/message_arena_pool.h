@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <google/protobuf/arena.h>
+#include "gmcp.grpc.pb.h"
+
+namespace gmcp {
+
+// Recycles protobuf arenas for the messages of one agent stream.
+//
+// A slot owns an arena holding one request and its response. The request is
+// parsed straight onto the arena and the response (tool output, query entries
+// and all their strings) is built next to it, so handling a message makes no
+// heap allocations of its own. Releasing a slot resets the arena, freeing
+// everything on it at once; the arena's first block is owned by the slot and
+// survives the reset, so once a stream is warm a typical message is served
+// entirely from memory that was already there.
+//
+// Every open stream has a pool, so what an idle stream keeps is bounded: the
+// first block is small and only a few released slots are kept.
+class MessageArenaPool {
+public:
+    struct Options {
+        // Size of each slot's reusable first block; larger messages spill
+        // into blocks that are freed on release
+        size_t initial_block = 4 << 10;
+        // Released slots kept for reuse; slots released beyond this, after
+        // a burst of concurrent messages, are freed
+        size_t max_idle_slots = 4;
+    };
+
+    class Slot {
+    public:
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+
+        AgentMessage* request() { return request_; }
+        AgentMessage* response() { return response_; }
+
+    private:
+        friend class MessageArenaPool;
+
+        explicit Slot(size_t initial_block);
+
+        // Drop both messages and start over from the retained first block
+        void Reset();
+
+        std::unique_ptr<char[]> block_;
+        google::protobuf::Arena arena_;
+        AgentMessage* request_ = nullptr;
+        AgentMessage* response_ = nullptr;
+    };
+
+    MessageArenaPool();
+    explicit MessageArenaPool(const Options& options);
+
+    MessageArenaPool(const MessageArenaPool&) = delete;
+    MessageArenaPool& operator=(const MessageArenaPool&) = delete;
+
+    // Take an idle slot, creating one if none is free
+    Slot* Acquire();
+
+    // Reset a slot and return it to the pool, or free it if enough are idle;
+    // safe from any thread
+    void Release(Slot* slot);
+
+    // Slots in use or kept for reuse
+    size_t slot_count() const;
+
+private:
+    const Options options_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::vector<Slot*> free_;
+};
+
+} // namespace gmcp
@@ -0,0 +1,285 @@
+#include "metrics.h"
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+
+namespace gmcp {
+
+namespace {
+
+// Distinct shard per thread, in order of first use
+size_t ThreadShardIndex() {
+    static std::atomic<size_t> next_index{0};
+    thread_local size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+void FillLatency(const char* kind, const std::string& name, const LatencyHistogram& histogram,
+                 StatsResponse* response) {
+    LatencyHistogram::Snapshot snapshot = histogram.Collect();
+    if (snapshot.count == 0) {
+        return;
+    }
+    LatencyStats* stats = response->add_latencies();
+    stats->set_kind(kind);
+    stats->set_name(name);
+    stats->set_count(snapshot.count);
+    stats->set_mean_us(snapshot.sum_ns / 1e3 / snapshot.count);
+    stats->set_p50_us(snapshot.Percentile(0.50) / 1e3);
+    stats->set_p90_us(snapshot.Percentile(0.90) / 1e3);
+    stats->set_p99_us(snapshot.Percentile(0.99) / 1e3);
+    stats->set_p999_us(snapshot.Percentile(0.999) / 1e3);
+    stats->set_max_us(snapshot.max_ns / 1e3);
+}
+
+// Label values may contain anything; escape per the exposition format
+std::string EscapeLabel(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped.push_back('\\');
+            escaped.push_back(c);
+        } else if (c == '\n') {
+            escaped.append("\\n");
+        } else {
+            escaped.push_back(c);
+        }
+    }
+    return escaped;
+}
+
+void AppendLine(std::string* out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+void AppendLine(std::string* out, const char* format, ...) {
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    int length = std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    out->append(line, std::min<size_t>(std::max(length, 0), sizeof(line) - 1));
+}
+
+} // namespace
+
+LatencyHistogram::~LatencyHistogram() {
+    for (auto& shard : shards_) {
+        delete shard.load(std::memory_order_relaxed);
+    }
+}
+
+size_t LatencyHistogram::BucketIndex(uint64_t nanos) {
+    if (nanos < kSubBuckets) {
+        return static_cast<size_t>(nanos);
+    }
+    int exponent = std::bit_width(nanos) - 1;
+    if (exponent >= kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    size_t sub_bucket = (nanos >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+    return (exponent - kSubBucketBits + 1) * kSubBuckets + sub_bucket;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    int exponent = static_cast<int>(index / kSubBuckets) + kSubBucketBits - 1;
+    uint64_t sub_bucket = index % kSubBuckets;
+    int shift = exponent - kSubBucketBits;
+    return ((kSubBuckets + sub_bucket + 1) << shift) - 1;
+}
+
+LatencyHistogram::Shard* LatencyHistogram::LocalShard() {
+    std::atomic<Shard*>& slot = shards_[ThreadShardIndex() % kMaxShards];
+    Shard* shard = slot.load(std::memory_order_acquire);
+    if (shard) {
+        return shard;
+    }
+    auto* created = new Shard();
+    if (slot.compare_exchange_strong(shard, created, std::memory_order_acq_rel)) {
+        return created;
+    }
+    // Another thread sharing this slot won the race
+    delete created;
+    return shard;
+}
+
+void LatencyHistogram::Record(uint64_t nanos) {
+    Shard* shard = LocalShard();
+    shard->counts[BucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+    shard->sum_ns.fetch_add(nanos, std::memory_order_relaxed);
+    uint64_t max = shard->max_ns.load(std::memory_order_relaxed);
+    while (nanos > max &&
+           !shard->max_ns.compare_exchange_weak(max, nanos, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Collect() const {
+    Snapshot snapshot;
+    snapshot.buckets.assign(kBucketCount, 0);
+    for (const auto& slot : shards_) {
+        const Shard* shard = slot.load(std::memory_order_acquire);
+        if (!shard) {
+            continue;
+        }
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            uint64_t count = shard->counts[i].load(std::memory_order_relaxed);
+            snapshot.buckets[i] += count;
+            snapshot.count += count;
+        }
+        snapshot.sum_ns += shard->sum_ns.load(std::memory_order_relaxed);
+        snapshot.max_ns = std::max(snapshot.max_ns, shard->max_ns.load(std::memory_order_relaxed));
+    }
+    return snapshot;
+}
+
+uint64_t LatencyHistogram::Snapshot::Percentile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * count + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(BucketUpperBound(i), max_ns);
+        }
+    }
+    return max_ns;
+}
+
+ServerMetrics::ServerMetrics() : start_(std::chrono::steady_clock::now()) {
+}
+
+LatencyHistogram* ServerMetrics::query(QueryType type) {
+    return QueryType_IsValid(type) ? &queries_[type] : nullptr;
+}
+
+LatencyHistogram* ServerMetrics::tool(const std::string& tool_id) const {
+    auto tools = tools_.Read();
+    auto it = tools->find(tool_id);
+    // Histograms are never removed, so the pointer outlives the snapshot
+    return it != tools->end() ? it->second.get() : nullptr;
+}
+
+void ServerMetrics::AddTool(const std::string& tool_id) {
+    if (tool(tool_id)) {
+        return;
+    }
+    tools_.Update([&](ToolTable& tools) {
+        return tools.emplace(tool_id, std::make_shared<LatencyHistogram>()).second;
+    });
+}
+
+const char* ServerMetrics::RpcName(Rpc rpc) {
+    switch (rpc) {
+        case Rpc::kStreamMessage: return "StreamAgentMessages";
+        case Rpc::kRegisterTool: return "RegisterTool";
+        case Rpc::kRegisterMemory: return "RegisterMemory";
+        case Rpc::kInvokeTool: return "InvokeTool";
+        case Rpc::kQueryMemory: return "QueryMemory";
+        case Rpc::kInvokeToolBatch: return "InvokeToolBatch";
+        case Rpc::kQueryMemoryBatch: return "QueryMemoryBatch";
+        case Rpc::kStoreMemory: return "StoreMemory";
+        case Rpc::kIngestMemory: return "IngestMemory";
+        case Rpc::kStreamQueryChunk: return "StreamQueryMemory";
+        case Rpc::kGetStats: return "GetStats";
+        default: return "unknown";
+    }
+}
+
+void ServerMetrics::Collect(StatsResponse* response) const {
+    response->set_uptime_ms(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::steady_clock::now() - start_).count());
+    for (size_t i = 0; i < rpcs_.size(); ++i) {
+        FillLatency("rpc", RpcName(static_cast<Rpc>(i)), rpcs_[i], response);
+    }
+    for (int type = QueryType_MIN; type <= QueryType_MAX; ++type) {
+        if (QueryType_IsValid(type)) {
+            FillLatency("query", QueryType_Name(static_cast<QueryType>(type)), queries_[type],
+                        response);
+        }
+    }
+    auto tools = tools_.Load();
+    for (const auto& [tool_id, histogram] : *tools) {
+        FillLatency("tool", tool_id, *histogram, response);
+    }
+
+    auto& counters = *response->mutable_counters();
+    counters["agent_messages"] = agent_messages.load(std::memory_order_relaxed);
+    counters["tool_errors"] = tool_errors.load(std::memory_order_relaxed);
+    auto& gauges = *response->mutable_gauges();
+    gauges["active_agent_streams"] = active_agent_streams.load(std::memory_order_relaxed);
+    gauges["active_query_streams"] = active_query_streams.load(std::memory_order_relaxed);
+    gauges["active_event_streams"] = active_event_streams.load(std::memory_order_relaxed);
+}
+
+std::string FormatPrometheus(const StatsResponse& stats) {
+    struct Family {
+        const char* kind;
+        const char* metric;
+        const char* label;
+        const char* help;
+    };
+    static const Family kFamilies[] = {
+        {"rpc", "gmcp_rpc_latency_seconds", "method", "Server-side RPC latency"},
+        {"tool", "gmcp_tool_latency_seconds", "tool_id", "Tool execution latency"},
+        {"query", "gmcp_memory_query_latency_seconds", "query_type", "Memory query latency"},
+    };
+    std::string out;
+    for (const Family& family : kFamilies) {
+        bool header = false;
+        for (const LatencyStats& latency : stats.latencies()) {
+            if (latency.kind() != family.kind) {
+                continue;
+            }
+            if (!header) {
+                AppendLine(&out, "# HELP %s %s\n# TYPE %s summary\n", family.metric, family.help,
+                           family.metric);
+                header = true;
+            }
+            std::string label = EscapeLabel(latency.name());
+            const std::pair<const char*, double> quantiles[] = {
+                {"0.5", latency.p50_us()},
+                {"0.9", latency.p90_us()},
+                {"0.99", latency.p99_us()},
+                {"0.999", latency.p999_us()},
+            };
+            for (const auto& [quantile, value_us] : quantiles) {
+                out.append(family.metric).append("{").append(family.label).append("=\"");
+                out.append(label);
+                AppendLine(&out, "\",quantile=\"%s\"} %.9g\n", quantile, value_us / 1e6);
+            }
+            out.append(family.metric).append("_sum{").append(family.label).append("=\"");
+            out.append(label);
+            AppendLine(&out, "\"} %.9g\n", latency.mean_us() * latency.count() / 1e6);
+            out.append(family.metric).append("_count{").append(family.label).append("=\"");
+            out.append(label);
+            AppendLine(&out, "\"} %" PRIu64 "\n", static_cast<uint64_t>(latency.count()));
+        }
+    }
+
+    // Map order is unspecified; sort for a stable dump
+    std::vector<std::pair<std::string, int64_t>> counters(stats.counters().begin(),
+                                                          stats.counters().end());
+    std::sort(counters.begin(), counters.end());
+    for (const auto& [name, value] : counters) {
+        AppendLine(&out, "# TYPE gmcp_%s_total counter\ngmcp_%s_total %" PRId64 "\n",
+                   name.c_str(), name.c_str(), value);
+    }
+    std::vector<std::pair<std::string, int64_t>> gauges(stats.gauges().begin(),
+                                                        stats.gauges().end());
+    std::sort(gauges.begin(), gauges.end());
+    for (const auto& [name, value] : gauges) {
+        AppendLine(&out, "# TYPE gmcp_%s gauge\ngmcp_%s %" PRId64 "\n", name.c_str(),
+                   name.c_str(), value);
+    }
+    AppendLine(&out, "# TYPE gmcp_uptime_seconds gauge\ngmcp_uptime_seconds %.3f\n",
+               stats.uptime_ms() / 1e3);
+    return out;
+}
+
+} // namespace gmcp
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "gmcp.grpc.pb.h"
+#include "rcu_snapshot.h"
+
+namespace gmcp {
+
+// Log-linear (HDR-style) latency histogram in nanoseconds.
+//
+// Each power of two is split into 16 linear sub-buckets, so any recorded
+// value is reported within 6.25% from 16ns up to ~18 minutes. Counts live in
+// per-thread shards: a thread only ever adds to its own shard with relaxed
+// atomics, so recording takes no lock and shares no cache line with other
+// recording threads. Collect merges the shards.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+    // Values at or above 2^40 ns land in the last bucket
+    static constexpr int kMaxExponent = 40;
+    static constexpr size_t kBucketCount = (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t sum_ns = 0;
+        uint64_t max_ns = 0;
+        std::vector<uint64_t> buckets;
+
+        // Upper bound of the bucket holding quantile `q` (0..1), capped at max_ns
+        uint64_t Percentile(double q) const;
+    };
+
+    LatencyHistogram() = default;
+    ~LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void Record(uint64_t nanos);
+    Snapshot Collect() const;
+
+    static size_t BucketIndex(uint64_t nanos);
+    // Largest value that maps to bucket `index`
+    static uint64_t BucketUpperBound(size_t index);
+
+private:
+    // Shards are created on a thread's first Record; threads beyond
+    // kMaxShards share shards, which stays correct, only less isolated
+    static constexpr size_t kMaxShards = 32;
+
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, kBucketCount> counts{};
+        std::atomic<uint64_t> sum_ns{0};
+        std::atomic<uint64_t> max_ns{0};
+    };
+
+    Shard* LocalShard();
+
+    std::array<std::atomic<Shard*>, kMaxShards> shards_{};
+};
+
+// Records the lifetime of the scope into a histogram (if any)
+class ScopedLatency {
+public:
+    explicit ScopedLatency(LatencyHistogram* histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedLatency() {
+        if (histogram_) {
+            histogram_->Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - start_).count());
+        }
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    LatencyHistogram* histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Holds a gauge one higher for the lifetime of the scope
+class ScopedGauge {
+public:
+    explicit ScopedGauge(std::atomic<int64_t>& gauge) : gauge_(gauge) {
+        gauge_.fetch_add(1, std::memory_order_relaxed);
+    }
+    ~ScopedGauge() { gauge_.fetch_sub(1, std::memory_order_relaxed); }
+
+    ScopedGauge(const ScopedGauge&) = delete;
+    ScopedGauge& operator=(const ScopedGauge&) = delete;
+
+private:
+    std::atomic<int64_t>& gauge_;
+};
+
+// Instrumentation of one server: latency per RPC, per tool and per memory
+// query type, plus counters and gauges. Histograms are created up front
+// (RPCs, query types) or when a tool is registered, so the recording path
+// is a lookup and a few relaxed atomic adds.
+class ServerMetrics {
+public:
+    enum class Rpc {
+        kStreamMessage,      // One message of StreamAgentMessages
+        kRegisterTool,
+        kRegisterMemory,
+        kInvokeTool,
+        kQueryMemory,
+        kInvokeToolBatch,
+        kQueryMemoryBatch,
+        kStoreMemory,
+        kIngestMemory,       // A whole ingest stream
+        kStreamQueryChunk,   // One chunk of StreamQueryMemory
+        kGetStats,
+        kCount,
+    };
+
+    ServerMetrics();
+
+    LatencyHistogram* rpc(Rpc rpc) { return &rpcs_[static_cast<size_t>(rpc)]; }
+
+    // Null for values outside the QueryType enum
+    LatencyHistogram* query(QueryType type);
+
+    // Histogram of a registered tool; null if the tool was never added, so
+    // unknown tool ids cannot grow the metric set
+    LatencyHistogram* tool(const std::string& tool_id) const;
+    void AddTool(const std::string& tool_id);
+
+    // Counters
+    std::atomic<int64_t> agent_messages{0};
+    std::atomic<int64_t> tool_errors{0};
+    // Gauges
+    std::atomic<int64_t> active_agent_streams{0};
+    std::atomic<int64_t> active_query_streams{0};
+    std::atomic<int64_t> active_event_streams{0};
+
+    // Fill the latency, counter and gauge sections of a stats response
+    void Collect(StatsResponse* response) const;
+
+    static const char* RpcName(Rpc rpc);
+
+private:
+    using ToolTable = std::unordered_map<std::string, std::shared_ptr<LatencyHistogram>>;
+
+    const std::chrono::steady_clock::time_point start_;
+    std::array<LatencyHistogram, static_cast<size_t>(Rpc::kCount)> rpcs_;
+    std::array<LatencyHistogram, QueryType_ARRAYSIZE> queries_;
+    RcuSnapshot<ToolTable> tools_;
+};
+
+// Render stats in the Prometheus text exposition format
+std::string FormatPrometheus(const StatsResponse& stats);
+
+} // namespace gmcp
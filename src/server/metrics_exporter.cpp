@@ -0,0 +1,188 @@
+#include "metrics_exporter.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include "common/logging.h"
+
+namespace gmcp {
+
+namespace {
+
+// A scrape request line and headers fit easily; anything larger is refused
+constexpr size_t kMaxRequestBytes = 8192;
+// A client that stalls mid-request is dropped after this long
+constexpr int kRequestTimeoutMs = 1000;
+
+bool WriteAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+void SendResponse(int fd, const char* status, const std::string& body) {
+    char header[256];
+    int length = std::snprintf(header, sizeof(header),
+                               "HTTP/1.1 %s\r\n"
+                               "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                               "Content-Length: %zu\r\n"
+                               "Connection: close\r\n\r\n",
+                               status, body.size());
+    if (WriteAll(fd, header, static_cast<size_t>(length))) {
+        WriteAll(fd, body.data(), body.size());
+    }
+}
+
+} // namespace
+
+MetricsExporter::MetricsExporter(const Options& options, RenderFn render)
+    : options_(options), render_(std::move(render)) {
+    if (options_.http_port != 0) {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0) {
+            throw std::runtime_error(std::string("metrics socket: ") + std::strerror(errno));
+        }
+        int reuse = 1;
+        ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(options_.http_port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(listen_fd_, 16) != 0) {
+            std::string error = std::strerror(errno);
+            ::close(listen_fd_);
+            throw std::runtime_error("cannot listen on metrics port " +
+                                     std::to_string(options_.http_port) + ": " + error);
+        }
+    }
+    if (::pipe2(wake_fds_, O_CLOEXEC) != 0) {
+        if (listen_fd_ >= 0) {
+            ::close(listen_fd_);
+        }
+        throw std::runtime_error(std::string("metrics pipe: ") + std::strerror(errno));
+    }
+    thread_ = std::thread([this] { Run(); });
+}
+
+MetricsExporter::~MetricsExporter() {
+    char byte = 0;
+    while (::write(wake_fds_[1], &byte, 1) < 0 && errno == EINTR) {
+    }
+    thread_.join();
+    // Leave a final dump behind for whoever reads the file after shutdown
+    if (!options_.file_path.empty()) {
+        WriteFile();
+    }
+    ::close(wake_fds_[0]);
+    ::close(wake_fds_[1]);
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+    }
+}
+
+void MetricsExporter::Run() {
+    const bool write_file = !options_.file_path.empty();
+    auto next_file_write = std::chrono::steady_clock::now();
+    while (true) {
+        int timeout_ms = -1;
+        if (write_file) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= next_file_write) {
+                WriteFile();
+                next_file_write = now + options_.file_interval;
+            }
+            timeout_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                next_file_write - now).count());
+        }
+
+        pollfd fds[2] = {{wake_fds_[0], POLLIN, 0}, {listen_fd_, POLLIN, 0}};
+        int ready = ::poll(fds, listen_fd_ >= 0 ? 2 : 1, timeout_ms);
+        if (ready < 0 && errno != EINTR) {
+            GMCP_LOG(kError) << "Metrics exporter poll failed: " << std::strerror(errno);
+            return;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+        if (fds[0].revents != 0) {
+            return;
+        }
+        if (listen_fd_ >= 0 && (fds[1].revents & POLLIN)) {
+            int client = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client >= 0) {
+                ServeConnection(client);
+                ::close(client);
+            }
+        }
+    }
+}
+
+void MetricsExporter::ServeConnection(int fd) {
+    // Read up to the end of the headers; the body of a GET is ignored
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (request.size() >= kMaxRequestBytes || ::poll(&pfd, 1, kRequestTimeoutMs) <= 0) {
+            return;
+        }
+        ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            return;
+        }
+        request.append(buffer, static_cast<size_t>(received));
+    }
+
+    size_t method_end = request.find(' ');
+    size_t path_end = request.find(' ', method_end + 1);
+    if (method_end == std::string::npos || path_end == std::string::npos) {
+        SendResponse(fd, "400 Bad Request", "bad request\n");
+        return;
+    }
+    std::string method = request.substr(0, method_end);
+    std::string path = request.substr(method_end + 1, path_end - method_end - 1);
+    if (method != "GET") {
+        SendResponse(fd, "405 Method Not Allowed", "only GET is supported\n");
+    } else if (path != "/metrics" && path != "/") {
+        SendResponse(fd, "404 Not Found", "metrics are served at /metrics\n");
+    } else {
+        SendResponse(fd, "200 OK", render_());
+    }
+}
+
+void MetricsExporter::WriteFile() {
+    // Write beside the target and rename, so readers never see a partial dump
+    std::string temp_path = options_.file_path + ".tmp";
+    std::string text = render_();
+    FILE* file = std::fopen(temp_path.c_str(), "w");
+    if (!file) {
+        GMCP_LOG(kWarning) << "Cannot write metrics file " << temp_path << ": "
+                           << std::strerror(errno);
+        return;
+    }
+    bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temp_path.c_str(), options_.file_path.c_str()) != 0) {
+        GMCP_LOG(kWarning) << "Cannot write metrics file " << options_.file_path << ": "
+                           << std::strerror(errno);
+        std::remove(temp_path.c_str());
+    }
+}
+
+} // namespace gmcp
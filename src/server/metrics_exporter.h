@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace gmcp {
+
+// Publishes a text rendering of the server metrics (normally Prometheus
+// format) outside gRPC, for scrapers that do not speak it: over plain HTTP
+// on a loopback port, to a file rewritten periodically, or both. One
+// background thread serves both; it only calls `render` when a scrape
+// arrives or the file is due, so an idle exporter costs nothing.
+class MetricsExporter {
+public:
+    struct Options {
+        // Serve GET /metrics on 127.0.0.1:http_port (0 disables)
+        uint16_t http_port = 0;
+        // Rewrite this file atomically every file_interval (empty disables)
+        std::string file_path;
+        std::chrono::milliseconds file_interval{10000};
+    };
+
+    using RenderFn = std::function<std::string()>;
+
+    // Starts the exporter thread. Throws std::runtime_error if the HTTP port
+    // cannot be bound.
+    MetricsExporter(const Options& options, RenderFn render);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+private:
+    void Run();
+    void ServeConnection(int fd);
+    void WriteFile();
+
+    const Options options_;
+    RenderFn render_;
+    int listen_fd_ = -1;
+    // Written by the destructor to wake the exporter thread
+    int wake_fds_[2] = {-1, -1};
+    std::thread thread_;
+};
+
+} // namespace gmcp
@@ -0,0 +1,312 @@
+#include "plugin_loader.h"
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include "common/logging.h"
+#include "tool_plugin.h"
+
+namespace gmcp {
+
+namespace {
+
+// One dlopen handle. Bound tool functions share ownership, so the code
+// stays mapped until the last registration using it is gone.
+class PluginLibrary {
+public:
+    explicit PluginLibrary(void* handle) : handle_(handle) {}
+    ~PluginLibrary() { ::dlclose(handle_); }
+
+    PluginLibrary(const PluginLibrary&) = delete;
+    PluginLibrary& operator=(const PluginLibrary&) = delete;
+
+    void* handle() const { return handle_; }
+
+private:
+    void* handle_;
+};
+
+// Server side of the gmcp_call handed to a plugin
+struct CallState {
+    gmcp_call call;
+    const CancellationToken* cancel;
+    std::string result;
+    std::string error;
+    bool failed = false;
+};
+
+void CallWrite(gmcp_call* call, const char* data, size_t size) {
+    auto* state = static_cast<CallState*>(call->host);
+    if (!state->failed) {
+        state->result.append(data, size);
+    }
+}
+
+void CallFail(gmcp_call* call, const char* message, size_t size) {
+    auto* state = static_cast<CallState*>(call->host);
+    state->failed = true;
+    state->error.assign(message, size);
+    state->result.clear();
+}
+
+int CallCancelled(const gmcp_call* call) {
+    return static_cast<const CallState*>(call->host)->cancel->cancelled() ? 1 : 0;
+}
+
+// Argument views are built on the stack up to this count
+constexpr size_t kInlineArguments = 16;
+
+NativeToolFunction Bind(std::shared_ptr<PluginLibrary> library,
+                        const gmcp_tool_descriptor& tool) {
+    return [library = std::move(library), invoke = tool.invoke, data = tool.data](
+               const google::protobuf::Map<std::string, std::string>& arguments,
+               const CancellationToken& cancel) -> std::string {
+        gmcp_argument inline_views[kInlineArguments];
+        std::vector<gmcp_argument> heap_views;
+        gmcp_argument* views = inline_views;
+        if (arguments.size() > kInlineArguments) {
+            heap_views.resize(arguments.size());
+            views = heap_views.data();
+        }
+        size_t count = 0;
+        for (const auto& [key, value] : arguments) {
+            views[count++] = {{key.data(), key.size()}, {value.data(), value.size()}};
+        }
+
+        CallState state;
+        state.call = {CallWrite, CallFail, CallCancelled, &state};
+        state.cancel = &cancel;
+        invoke(data, views, count, &state.call);
+        if (state.failed) {
+            // Reported like any other tool error
+            throw std::runtime_error(state.error);
+        }
+        return std::move(state.result);
+    };
+}
+
+const char* OrEmpty(const char* value) {
+    return value ? value : "";
+}
+
+ToolRegistration ToRegistration(const gmcp_tool_descriptor& tool) {
+    ToolRegistration registration;
+    registration.set_tool_id(tool.tool_id);
+    registration.set_name(OrEmpty(tool.name));
+    registration.set_description(OrEmpty(tool.description));
+    registration.set_return_type(OrEmpty(tool.return_type));
+    for (size_t i = 0; i < tool.parameter_count; ++i) {
+        const gmcp_tool_parameter& parameter = tool.parameters[i];
+        ToolParameter* added = registration.add_parameters();
+        added->set_name(OrEmpty(parameter.name));
+        added->set_type(OrEmpty(parameter.type));
+        added->set_required(parameter.required != 0);
+        added->set_description(OrEmpty(parameter.description));
+    }
+    registration.set_cacheable(tool.cacheable != 0);
+    registration.set_cache_ttl_ms(tool.cache_ttl_ms);
+    registration.set_max_concurrency(tool.max_concurrency);
+    return registration;
+}
+
+// The dynamic loader returns an already loaded object for a path it has
+// seen, so each version is opened from a copy under a fresh name. The copy
+// is unlinked once mapped.
+void* OpenPrivateCopy(const std::string& path, std::string* error) {
+    static std::atomic<uint64_t> next_copy{0};
+    std::filesystem::path copy =
+        std::filesystem::temp_directory_path() /
+        ("gmcp-plugin-" + std::to_string(::getpid()) + "-" +
+         std::to_string(next_copy.fetch_add(1, std::memory_order_relaxed)) + "-" +
+         std::filesystem::path(path).filename().string());
+    std::error_code copy_error;
+    if (!std::filesystem::copy_file(path, copy,
+                                    std::filesystem::copy_options::overwrite_existing,
+                                    copy_error)) {
+        *error = "cannot copy: " + copy_error.message();
+        return nullptr;
+    }
+    void* handle = ::dlopen(copy.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        *error = ::dlerror();
+    }
+    std::filesystem::remove(copy, copy_error);
+    return handle;
+}
+
+} // namespace
+
+PluginLoader::PluginLoader(const Options& options, RegisterFn register_tool,
+                           UnregisterFn unregister_tool)
+    : options_(options),
+      register_tool_(std::move(register_tool)),
+      unregister_tool_(std::move(unregister_tool)) {
+    std::error_code error;
+    if (!std::filesystem::is_directory(options_.directory, error)) {
+        throw std::runtime_error("plugin directory not found: " + options_.directory);
+    }
+    Scan();
+    if (options_.poll_interval.count() > 0) {
+        thread_ = std::thread([this] { Run(); });
+    }
+}
+
+PluginLoader::~PluginLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    stop_cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+size_t PluginLoader::tool_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& [path, file] : files_) {
+        count += file.tools.size();
+    }
+    return count;
+}
+
+void PluginLoader::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_cv_.wait_for(lock, options_.poll_interval, [this] { return stopping_; })) {
+        lock.unlock();
+        Scan();
+        lock.lock();
+    }
+}
+
+void PluginLoader::Scan() {
+    struct Version {
+        int64_t mtime_ns;
+        uint64_t size;
+        uint64_t inode;
+    };
+    std::map<std::string, Version> present;
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(options_.directory, error), end;
+         !error && it != end; it.increment(error)) {
+        if (it->path().extension() != ".so") {
+            continue;
+        }
+        struct stat info;
+        if (::stat(it->path().c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+            continue;
+        }
+        present[it->path().string()] = {
+            static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec,
+            static_cast<uint64_t>(info.st_size), static_cast<uint64_t>(info.st_ino)};
+    }
+    if (error) {
+        // Keep what is loaded rather than unregistering everything
+        GMCP_LOG(kWarning) << "Cannot scan plugin directory " << options_.directory << ": "
+                           << error.message();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [path, version] : present) {
+        LoadedFile& file = files_[path];
+        if (file.mtime_ns == version.mtime_ns && file.size == version.size &&
+            file.inode == version.inode) {
+            continue;
+        }
+        file.mtime_ns = version.mtime_ns;
+        file.size = version.size;
+        file.inode = version.inode;
+        Load(path, &file);
+    }
+    for (auto it = files_.begin(); it != files_.end();) {
+        if (present.count(it->first)) {
+            ++it;
+            continue;
+        }
+        Unload(it->first, it->second);
+        it = files_.erase(it);
+    }
+}
+
+bool PluginLoader::Load(const std::string& path, LoadedFile* file) {
+    std::string error;
+    void* handle = OpenPrivateCopy(path, &error);
+    if (!handle) {
+        GMCP_LOG(kError) << "Cannot load plugin " << path << ": " << error;
+        return false;
+    }
+    auto library = std::make_shared<PluginLibrary>(handle);
+    auto describe =
+        reinterpret_cast<gmcp_plugin_describe_fn>(::dlsym(library->handle(), GMCP_PLUGIN_ENTRY));
+    const gmcp_plugin* plugin = describe ? describe() : nullptr;
+    if (!plugin) {
+        GMCP_LOG(kError) << "Plugin " << path << " does not export " << GMCP_PLUGIN_ENTRY;
+        return false;
+    }
+    if (plugin->abi_version != GMCP_PLUGIN_ABI_VERSION) {
+        GMCP_LOG(kError) << "Plugin " << path << " was built for ABI version "
+                         << plugin->abi_version << ", server has " << GMCP_PLUGIN_ABI_VERSION;
+        return false;
+    }
+    // Validate everything before touching the registrations
+    for (size_t i = 0; i < plugin->tool_count; ++i) {
+        const gmcp_tool_descriptor& tool = plugin->tools[i];
+        if (!tool.tool_id || tool.tool_id[0] == '\0' || !tool.invoke) {
+            GMCP_LOG(kError) << "Plugin " << path << " has a tool without an id or function";
+            return false;
+        }
+    }
+
+    std::map<std::string, uint64_t> tools;
+    for (size_t i = 0; i < plugin->tool_count; ++i) {
+        const gmcp_tool_descriptor& tool = plugin->tools[i];
+        // Ids are unique across plugins; the file loaded first keeps one
+        bool taken = std::any_of(files_.begin(), files_.end(), [&](const auto& other) {
+            return &other.second != file && other.second.tools.count(tool.tool_id);
+        });
+        if (taken) {
+            GMCP_LOG(kWarning) << "Plugin " << path << ": tool " << tool.tool_id
+                               << " is provided by another plugin";
+            continue;
+        }
+        // A reload swaps out the registration this file installed before, and
+        // fails if anything else holds the id now
+        auto previous = file->tools.find(tool.tool_id);
+        uint64_t replaces = previous != file->tools.end() ? previous->second : 0;
+        uint64_t generation = register_tool_(ToRegistration(tool), Bind(library, tool), replaces);
+        if (generation != 0) {
+            tools[tool.tool_id] = generation;
+        } else if (replaces != 0) {
+            GMCP_LOG(kWarning) << "Plugin " << path << ": tool " << tool.tool_id
+                               << " was replaced by another registration; skipped";
+        } else {
+            GMCP_LOG(kWarning) << "Plugin " << path << ": tool " << tool.tool_id
+                               << " is already registered; skipped";
+        }
+    }
+    // Tools the previous version had but this one dropped
+    for (const auto& [tool_id, generation] : file->tools) {
+        if (!tools.count(tool_id)) {
+            unregister_tool_(tool_id, generation);
+        }
+    }
+    GMCP_LOG(kInfo) << (file->tools.empty() ? "Loaded" : "Reloaded") << " plugin " << path
+                    << " (" << tools.size() << " tools)";
+    file->tools = std::move(tools);
+    return true;
+}
+
+void PluginLoader::Unload(const std::string& path, const LoadedFile& file) {
+    for (const auto& [tool_id, generation] : file.tools) {
+        unregister_tool_(tool_id, generation);
+    }
+    GMCP_LOG(kInfo) << "Unloaded plugin " << path;
+}
+
+} // namespace gmcp
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gmcp.grpc.pb.h"
+#include "tool_manager.h"
+
+namespace gmcp {
+
+// Loads native tool plugins (see tool_plugin.h) from a directory and keeps
+// their registrations in sync with the files.
+//
+// Every *.so file is loaded once at construction. With a poll interval, a
+// background thread then rescans the directory: a new or changed file is
+// loaded from a private copy (so the dynamic loader cannot hand back the
+// old mapping) and its tools replace the previous version's; tools a file
+// no longer provides, and those of removed files, are unregistered. A plugin
+// only ever replaces or unregisters the exact registrations it installed: an
+// id taken by a built-in, RPC-registered or other plugin's tool is logged and
+// skipped, and a plugin tool that something else has since replaced is no
+// longer the plugin's. A
+// library stays mapped for as long as any of its registrations is, so
+// invocations running during a reload finish on the code they started on.
+// A file that fails to load is logged and leaves its previous version in
+// place.
+class PluginLoader {
+public:
+    struct Options {
+        std::string directory;
+        // Rescan for changes this often (0 = load once)
+        std::chrono::milliseconds poll_interval{1000};
+    };
+
+    // Install a tool in place of the registration with generation `replaces`
+    // (0: the id must be free); returns the new generation, 0 if the id holds
+    // any other registration
+    using RegisterFn =
+        std::function<uint64_t(const ToolRegistration&, NativeToolFunction, uint64_t replaces)>;
+    // Remove a tool only while `generation` is still its registration
+    using UnregisterFn = std::function<bool(const std::string& tool_id, uint64_t generation)>;
+
+    // Loads the directory and starts watching it. Throws std::runtime_error
+    // if the directory cannot be read.
+    PluginLoader(const Options& options, RegisterFn register_tool, UnregisterFn unregister_tool);
+    ~PluginLoader();
+
+    PluginLoader(const PluginLoader&) = delete;
+    PluginLoader& operator=(const PluginLoader&) = delete;
+
+    // Tools currently provided by plugins
+    size_t tool_count() const;
+
+private:
+    struct LoadedFile {
+        // Identity of the file version last loaded (or attempted, so a broken
+        // file is not retried until it changes again)
+        int64_t mtime_ns = 0;
+        uint64_t size = 0;
+        uint64_t inode = 0;
+        // Tool id -> generation of the registration this file installed
+        std::map<std::string, uint64_t> tools;
+    };
+
+    void Scan();
+    // Load one file version and swap its registrations in. False (with the
+    // previous version left registered) if it could not be loaded.
+    bool Load(const std::string& path, LoadedFile* file);
+    void Unload(const std::string& path, const LoadedFile& file);
+    void Run();
+
+    const Options options_;
+    RegisterFn register_tool_;
+    UnregisterFn unregister_tool_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable stop_cv_;
+    bool stopping_ = false;
+    // Plugin path -> what was loaded from it
+    std::map<std::string, LoadedFile> files_;
+    std::thread thread_;
+};
+
+} // namespace gmcp
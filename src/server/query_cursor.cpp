@@ -0,0 +1,96 @@
+#include "query_cursor.h"
+#include <cstring>
+
+namespace gmcp {
+
+namespace {
+
+void AppendInteger(uint64_t value, std::string* out) {
+    char bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    out->append(bytes, sizeof(bytes));
+}
+
+bool ReadInteger(const std::string& token, size_t offset, uint64_t* value) {
+    if (token.size() < offset + sizeof(*value)) {
+        return false;
+    }
+    std::memcpy(value, token.data() + offset, sizeof(*value));
+    return true;
+}
+
+} // namespace
+
+QueryCursor QueryCursor::AfterKey(const std::string& key) {
+    QueryCursor cursor;
+    cursor.kind = Kind::kKey;
+    cursor.key = key;
+    return cursor;
+}
+
+QueryCursor QueryCursor::AfterTime(int64_t timestamp, uint64_t sequence) {
+    QueryCursor cursor;
+    cursor.kind = Kind::kTime;
+    cursor.timestamp = timestamp;
+    cursor.sequence = sequence;
+    return cursor;
+}
+
+QueryCursor QueryCursor::AtPosition(uint64_t count) {
+    QueryCursor cursor;
+    cursor.kind = Kind::kPosition;
+    cursor.count = count;
+    return cursor;
+}
+
+std::string QueryCursor::Encode() const {
+    std::string token(1, static_cast<char>(kind));
+    switch (kind) {
+        case Kind::kKey:
+            token += key;
+            break;
+        case Kind::kTime:
+            AppendInteger(static_cast<uint64_t>(timestamp), &token);
+            AppendInteger(sequence, &token);
+            break;
+        case Kind::kPosition:
+            AppendInteger(count, &token);
+            break;
+        case Kind::kStart:
+            return std::string();
+    }
+    return token;
+}
+
+bool QueryCursor::Decode(const MemoryQuery& query, Kind expected, QueryCursor* cursor) {
+    const std::string& token = query.cursor();
+    *cursor = QueryCursor();
+    if (token.empty()) {
+        return true;
+    }
+    if (static_cast<Kind>(token[0]) != expected) {
+        return false;
+    }
+    cursor->kind = expected;
+    switch (expected) {
+        case Kind::kKey:
+            cursor->key = token.substr(1);
+            return true;
+        case Kind::kTime: {
+            uint64_t timestamp;
+            if (token.size() != 17 || !ReadInteger(token, 1, &timestamp) ||
+                !ReadInteger(token, 9, &cursor->sequence)) {
+                return false;
+            }
+            cursor->timestamp = static_cast<int64_t>(timestamp);
+            return true;
+        }
+        case Kind::kPosition:
+            return token.size() == 9 && ReadInteger(token, 1, &cursor->count);
+        case Kind::kStart:
+            break;
+    }
+    return false;
+}
+
+} // namespace gmcp
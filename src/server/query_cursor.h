@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "gmcp.grpc.pb.h"
+
+namespace gmcp {
+
+// Continuation token carried in MemoryQuery.cursor and MemoryResult.next_cursor.
+// It records where a page stopped in the store's result order, so the next
+// page resumes there with no per-client state on the server and no lock held
+// between pages. Clients treat the encoded form as opaque.
+struct QueryCursor {
+    enum class Kind : char {
+        kStart = 0,      // no cursor: first page
+        kKey = 'k',      // key-ordered results: resume after `key`
+        kTime = 't',     // time-ordered results: resume after the entry at `timestamp`
+                         // with insertion sequence `sequence`
+        kPosition = 'p', // resume at the `count`th result (or scan position)
+    };
+
+    Kind kind = Kind::kStart;
+    std::string key;
+    int64_t timestamp = 0;
+    uint64_t sequence = 0;
+    uint64_t count = 0;
+
+    static QueryCursor AfterKey(const std::string& key);
+    static QueryCursor AfterTime(int64_t timestamp, uint64_t sequence);
+    static QueryCursor AtPosition(uint64_t count);
+
+    std::string Encode() const;
+
+    // Decode the query's cursor. Succeeds for an empty cursor (kStart) or one
+    // of the expected kind; fails for malformed tokens or a token from a
+    // different kind of query.
+    static bool Decode(const MemoryQuery& query, Kind expected, QueryCursor* cursor);
+
+    bool at_start() const { return kind == Kind::kStart; }
+};
+
+} // namespace gmcp
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace gmcp {
+
+// Copy-on-write snapshot of an immutable value with RCU-style reads.
+//
+// Writers copy the current value, mutate the copy and publish it under a
+// writer-only mutex. Readers never take a lock: each thread caches the last
+// snapshot it saw together with its version, so a read on an unchanged
+// snapshot touches only the shared (read-mostly) version counter and no
+// reference counts. A thread only drops a cached snapshot once it is outside
+// every read section, which makes nested reads (a tool invoking another tool)
+// safe against concurrent replacement.
+template <typename T>
+class RcuSnapshot {
+public:
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const RcuSnapshot& owner);
+        ~ReadGuard();
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        const T& operator*() const { return *value_; }
+        const T* operator->() const { return value_; }
+
+    private:
+        const T* value_;
+    };
+
+    RcuSnapshot() : RcuSnapshot(std::make_shared<const T>()) {}
+    explicit RcuSnapshot(std::shared_ptr<const T> initial)
+        : id_(NextInstanceId()), current_(std::move(initial)) {}
+
+    // Lock-free read section; the value stays valid for the guard's lifetime
+    ReadGuard Read() const { return ReadGuard(*this); }
+
+    // Reference-counted copy of the current snapshot, for long-lived holders
+    std::shared_ptr<const T> Load() const { return current_.load(std::memory_order_acquire); }
+
+    // Copy the current value, apply `mutate` and publish the copy if it
+    // returns true. Returns whatever `mutate` returned.
+    template <typename Mutator>
+    bool Update(Mutator&& mutate) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        auto next = std::make_shared<T>(*current_.load(std::memory_order_relaxed));
+        if (!mutate(*next)) {
+            return false;
+        }
+        current_.store(std::move(next), std::memory_order_release);
+        version_.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // Per-thread cache; one slot per T, keyed by the owning instance
+    struct ThreadCache {
+        uint64_t owner_id = 0;
+        uint64_t version = 0;
+        std::shared_ptr<const T> value;
+        int depth = 0;
+        std::vector<std::shared_ptr<const T>> retired;
+    };
+
+    static uint64_t NextInstanceId() {
+        static std::atomic<uint64_t> next_id{1};
+        return next_id.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static ThreadCache& LocalCache() {
+        thread_local ThreadCache cache;
+        return cache;
+    }
+
+    const uint64_t id_;
+    std::mutex writer_mutex_;
+    std::atomic<uint64_t> version_{0};
+    std::atomic<std::shared_ptr<const T>> current_;
+};
+
+template <typename T>
+RcuSnapshot<T>::ReadGuard::ReadGuard(const RcuSnapshot& owner) {
+    ThreadCache& cache = LocalCache();
+    uint64_t version = owner.version_.load(std::memory_order_acquire);
+    if (cache.owner_id != owner.id_ || cache.version != version || !cache.value) {
+        if (cache.depth > 0 && cache.value) {
+            // An outer read section on this thread may still use the old value
+            cache.retired.push_back(std::move(cache.value));
+        }
+        cache.owner_id = owner.id_;
+        cache.version = version;
+        cache.value = owner.current_.load(std::memory_order_acquire);
+    }
+    ++cache.depth;
+    value_ = cache.value.get();
+}
+
+template <typename T>
+RcuSnapshot<T>::ReadGuard::~ReadGuard() {
+    ThreadCache& cache = LocalCache();
+    if (--cache.depth == 0 && !cache.retired.empty()) {
+        cache.retired.clear();
+    }
+}
+
+} // namespace gmcp
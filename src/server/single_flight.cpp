@@ -0,0 +1,70 @@
+#include "single_flight.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+namespace gmcp {
+
+const SingleFlight::Outcome& SingleFlight::Call::Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return done_; });
+    return outcome_;
+}
+
+const SingleFlight::Outcome* SingleFlight::Call::Wait(const CancellationToken& cancel) {
+    // A probe cannot notify the condition variable, so check it periodically
+    constexpr auto kCheckInterval = std::chrono::milliseconds(10);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!done_) {
+        if (cancel.cancelled()) {
+            return nullptr;
+        }
+        done_cv_.wait_until(lock, std::min(cancel.deadline(),
+                                           CancellationToken::Clock::now() + kCheckInterval));
+    }
+    return &outcome_;
+}
+
+SingleFlight::SingleFlight(size_t shard_count) {
+    shard_count = std::max<size_t>(shard_count, 1);
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+SingleFlight::Shard& SingleFlight::ShardOf(const std::string& key) {
+    return *shards_[std::hash<std::string>{}(key) % shards_.size()];
+}
+
+std::shared_ptr<SingleFlight::Call> SingleFlight::Join(const std::string& key, bool* leader) {
+    Shard& shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto [it, inserted] = shard.calls.try_emplace(key);
+    if (inserted) {
+        it->second = std::make_shared<Call>();
+    } else {
+        coalesced_.fetch_add(1, std::memory_order_relaxed);
+    }
+    *leader = inserted;
+    return it->second;
+}
+
+void SingleFlight::Complete(const std::string& key, const std::shared_ptr<Call>& call,
+                            Outcome outcome) {
+    // Retire the key first: a caller arriving from here on starts a new call
+    // rather than joining one whose result it might not wait for
+    {
+        Shard& shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.calls.erase(key);
+    }
+    {
+        std::lock_guard<std::mutex> lock(call->mutex_);
+        call->outcome_ = std::move(outcome);
+        call->done_ = true;
+    }
+    call->done_cv_.notify_all();
+}
+
+} // namespace gmcp
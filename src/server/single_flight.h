@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cancellation.h"
+
+namespace gmcp {
+
+// Coalesces identical concurrent calls: the first caller for a key becomes
+// the leader and executes, callers arriving while it runs wait for its
+// outcome instead of executing again. A key is only shared while its call is
+// in flight; once the leader completes, the next caller starts a new call.
+// Keys live in hash shards with their own locks, so unrelated calls do not
+// contend.
+class SingleFlight {
+public:
+    struct Outcome {
+        bool success = false;
+        std::string value;
+        std::string error;
+        // grpc::StatusCode of a failure outside the call itself (e.g. the
+        // leader was cancelled); 0 otherwise
+        int status_code = 0;
+    };
+
+    class Call {
+    public:
+        // Blocks until the leader completes the call
+        const Outcome& Wait();
+        // Like Wait, but gives up once `cancel` fires; null in that case
+        const Outcome* Wait(const CancellationToken& cancel);
+
+    private:
+        friend class SingleFlight;
+
+        std::mutex mutex_;
+        std::condition_variable done_cv_;
+        bool done_ = false;
+        Outcome outcome_;
+    };
+
+    explicit SingleFlight(size_t shard_count = 16);
+
+    SingleFlight(const SingleFlight&) = delete;
+    SingleFlight& operator=(const SingleFlight&) = delete;
+
+    // The in-flight call for `key`, creating it if there is none. Sets
+    // `*leader` if the caller created it and must Complete it.
+    std::shared_ptr<Call> Join(const std::string& key, bool* leader);
+
+    // Publish the leader's outcome to every waiter and retire the key
+    void Complete(const std::string& key, const std::shared_ptr<Call>& call, Outcome outcome);
+
+    // Callers that waited on another caller's execution
+    uint64_t coalesced() const { return coalesced_.load(std::memory_order_relaxed); }
+
+private:
+    // Padded so neighbouring shard locks do not share a cache line
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<Call>> calls;
+    };
+
+    Shard& ShardOf(const std::string& key);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint64_t> coalesced_{0};
+};
+
+} // namespace gmcp
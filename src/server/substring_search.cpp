@@ -0,0 +1,115 @@
+#include "substring_search.h"
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define GMCP_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace gmcp {
+
+namespace {
+
+bool ContainsScalar(std::string_view haystack, std::string_view needle) {
+    return haystack.find(needle) != std::string_view::npos;
+}
+
+#ifdef GMCP_X86_SIMD
+
+// Block-wise filter: compare the needle's first and last bytes against every
+// position of a block at once and only memcmp the positions where both match.
+// Positions that do not fit a full block are finished by the scalar search.
+
+bool ContainsSse2(std::string_view haystack, std::string_view needle) {
+    const size_t n = needle.size();
+    if (n < 2 || haystack.size() < n) {
+        return ContainsScalar(haystack, needle);
+    }
+    
+    const char* data = haystack.data();
+    const __m128i first = _mm_set1_epi8(needle.front());
+    const __m128i last = _mm_set1_epi8(needle.back());
+    
+    size_t i = 0;
+    for (; i + n - 1 + 16 <= haystack.size(); i += 16) {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + n - 1));
+        unsigned mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last)));
+        while (mask != 0) {
+            unsigned bit = __builtin_ctz(mask);
+            if (std::memcmp(data + i + bit + 1, needle.data() + 1, n - 2) == 0) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return ContainsScalar(haystack.substr(i), needle);
+}
+
+__attribute__((target("avx2")))
+bool ContainsAvx2(std::string_view haystack, std::string_view needle) {
+    const size_t n = needle.size();
+    if (n < 2 || haystack.size() < n) {
+        return ContainsScalar(haystack, needle);
+    }
+    
+    const char* data = haystack.data();
+    const __m256i first = _mm256_set1_epi8(needle.front());
+    const __m256i last = _mm256_set1_epi8(needle.back());
+    
+    size_t i = 0;
+    for (; i + n - 1 + 32 <= haystack.size(); i += 32) {
+        __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i block_last =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + n - 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last))));
+        while (mask != 0) {
+            unsigned bit = __builtin_ctz(mask);
+            if (std::memcmp(data + i + bit + 1, needle.data() + 1, n - 2) == 0) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return ContainsSse2(haystack.substr(i), needle);
+}
+
+#endif // GMCP_X86_SIMD
+
+using ContainsFn = bool (*)(std::string_view, std::string_view);
+
+struct Implementation {
+    ContainsFn contains;
+    const char* name;
+};
+
+Implementation SelectImplementation() {
+#ifdef GMCP_X86_SIMD
+    if (__builtin_cpu_supports("avx2")) {
+        return {ContainsAvx2, "avx2"};
+    }
+    // SSE2 is part of the x86-64 baseline
+    return {ContainsSse2, "sse2"};
+#else
+    return {ContainsScalar, "scalar"};
+#endif
+}
+
+const Implementation& Selected() {
+    static const Implementation implementation = SelectImplementation();
+    return implementation;
+}
+
+} // namespace
+
+bool ContainsSubstring(std::string_view haystack, std::string_view needle) {
+    return Selected().contains(haystack, needle);
+}
+
+const char* SubstringSearchImplementation() {
+    return Selected().name;
+}
+
+} // namespace gmcp
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string_view>
+
+namespace gmcp {
+
+// True if `needle` occurs in `haystack`. Uses AVX2 or SSE2 when the CPU
+// supports them (selected once at startup) and std::string_view::find
+// otherwise.
+bool ContainsSubstring(std::string_view haystack, std::string_view needle);
+
+// Name of the implementation selected for this CPU ("avx2", "sse2", "scalar")
+const char* SubstringSearchImplementation();
+
+} // namespace gmcp
@@ -0,0 +1,434 @@
+#include "temporal_store.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <tuple>
+#include <utility>
+#include "query_cursor.h"
+#include "substring_search.h"
+
+namespace gmcp {
+
+namespace {
+
+constexpr int kDefaultLimit = 100;
+
+size_t EffectiveLimit(const MemoryQuery& query) {
+    return query.limit() > 0 ? query.limit() : kDefaultLimit;
+}
+
+// Time-ordered run of entries taking part in a k-way merge
+struct Slice {
+    const int64_t* timestamps;
+    const uint64_t* sequences;
+    const MemoryEntry* entries;
+    size_t position;
+    size_t end;
+};
+
+// Emit up to `limit` entries from the slices in (timestamp, sequence) order;
+// stops early once `emit` returns false
+template <typename Emit>
+void MergeSlices(std::vector<Slice>& slices, size_t limit, Emit&& emit) {
+    using Head = std::tuple<int64_t, uint64_t, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    auto push = [&](size_t i) {
+        const Slice& slice = slices[i];
+        heads.emplace(slice.timestamps[slice.position], slice.sequences[slice.position], i);
+    };
+    for (size_t i = 0; i < slices.size(); ++i) {
+        if (slices[i].position < slices[i].end) {
+            push(i);
+        }
+    }
+    for (size_t emitted = 0; emitted < limit && !heads.empty(); ++emitted) {
+        size_t i = std::get<2>(heads.top());
+        heads.pop();
+        Slice& slice = slices[i];
+        if (!emit(slice.timestamps[slice.position], slice.sequences[slice.position],
+                  slice.entries[slice.position])) {
+            return;
+        }
+        if (++slice.position < slice.end) {
+            push(i);
+        }
+    }
+}
+
+// First position in [0, end) ordered after the entry at (timestamp, sequence)
+size_t PositionAfter(const int64_t* timestamps, const uint64_t* sequences, size_t end,
+                     int64_t timestamp, uint64_t sequence) {
+    const int64_t* first = std::lower_bound(timestamps, timestamps + end, timestamp);
+    const int64_t* last = std::upper_bound(first, timestamps + end, timestamp);
+    return std::upper_bound(sequences + (first - timestamps), sequences + (last - timestamps),
+                            sequence) -
+           sequences;
+}
+
+} // namespace
+
+TemporalStore::TemporalStore() : TemporalStore(Options()) {
+}
+
+TemporalStore::TemporalStore(const Options& options)
+    : options_{std::max<size_t>(options.segment_size, 1),
+               std::max<size_t>(options.merge_fan_in, 2)},
+      segments_(std::make_shared<SegmentList>()) {
+    merge_thread_ = std::thread([this] { MergeLoop(); });
+}
+
+TemporalStore::~TemporalStore() {
+    {
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        stopping_ = true;
+    }
+    merge_cv_.notify_one();
+    merge_thread_.join();
+}
+
+bool TemporalStore::Put(MemoryEntry&& entry) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    PutLocked(std::move(entry));
+    return true;
+}
+
+size_t TemporalStore::PutBatch(std::vector<MemoryEntry>&& entries) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (auto& entry : entries) {
+        PutLocked(std::move(entry));
+    }
+    return entries.size();
+}
+
+void TemporalStore::PutLocked(MemoryEntry&& entry) {
+    // Appends are usually in time order, making this an O(1) push_back;
+    // late entries are inserted in place, after any with the same timestamp
+    int64_t timestamp = entry.timestamp();
+    auto position = std::upper_bound(head_.timestamps.begin(), head_.timestamps.end(), timestamp);
+    size_t index = position - head_.timestamps.begin();
+    head_.timestamps.insert(position, timestamp);
+    head_.sequences.insert(head_.sequences.begin() + index, next_sequence_++);
+    head_.entries.insert(head_.entries.begin() + index, std::move(entry));
+    
+    if (head_.timestamps.size() >= options_.segment_size) {
+        SealLocked();
+    }
+}
+
+void TemporalStore::SealLocked() {
+    auto sealed = std::make_shared<Segment>(std::move(head_));
+    head_ = Segment();
+    head_.timestamps.reserve(options_.segment_size);
+    head_.sequences.reserve(options_.segment_size);
+    head_.entries.reserve(options_.segment_size);
+    sealed_entries_ += sealed->timestamps.size();
+    
+    auto next = std::make_shared<SegmentList>(*segments_);
+    next->push_back(std::move(sealed));
+    bool merge = next->size() >= options_.merge_fan_in;
+    segments_ = std::move(next);
+    
+    if (merge) {
+        {
+            std::lock_guard<std::mutex> lock(merge_mutex_);
+            merge_requested_ = true;
+        }
+        merge_cv_.notify_one();
+    }
+}
+
+void TemporalStore::Query(const MemoryQuery& query, MemoryResult* result) const {
+    switch (query.query_type()) {
+        case QueryType::RANGE: {
+            // Zero leaves a bound open
+            int64_t start = query.start_time() != 0 ? query.start_time()
+                                                    : std::numeric_limits<int64_t>::min();
+            int64_t end = query.end_time() != 0 ? query.end_time()
+                                                : std::numeric_limits<int64_t>::max();
+            Range(start, end, query, result);
+            break;
+        }
+        
+        case QueryType::LIST:
+            Range(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), query,
+                  result);
+            break;
+        
+        case QueryType::GET:
+            Get(query, result);
+            break;
+        
+        case QueryType::SEARCH:
+            Search(query, result);
+            break;
+        
+        default:
+            break;
+    }
+}
+
+size_t TemporalStore::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return sealed_entries_ + head_.timestamps.size();
+}
+
+void TemporalStore::ForEach(const std::function<void(const MemoryEntry&)>& visit,
+                            const std::function<void()>& pinned) const {
+    // Sealed segments are immutable, so only the head is copied and writers
+    // are not held off while the entries are visited
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::shared_ptr<const SegmentList> segments = segments_;
+    std::vector<MemoryEntry> head = head_.entries;
+    pinned();
+    lock.unlock();
+
+    for (const auto& segment : *segments) {
+        for (const MemoryEntry& entry : segment->entries) {
+            visit(entry);
+        }
+    }
+    for (const MemoryEntry& entry : head) {
+        visit(entry);
+    }
+}
+
+size_t TemporalStore::segment_count() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return segments_->size();
+}
+
+void TemporalStore::Range(int64_t start, int64_t end, const MemoryQuery& query,
+                          MemoryResult* result) const {
+    QueryCursor cursor;
+    if (!QueryCursor::Decode(query, QueryCursor::Kind::kTime, &cursor)) {
+        return;
+    }
+    // A later page resumes after the last entry the previous page returned
+    bool resume = !cursor.at_start() && cursor.timestamp >= start;
+    size_t limit = EffectiveLimit(query);
+    
+    std::shared_ptr<const SegmentList> segments;
+    Segment head;
+    size_t total = 0;
+    size_t remaining = 0;
+    auto bounds = [&](const Segment& segment, size_t* lo, size_t* hi) {
+        const int64_t* timestamps = segment.timestamps.data();
+        size_t size = segment.timestamps.size();
+        *hi = std::lower_bound(timestamps, timestamps + size, end) - timestamps;
+        size_t first = std::lower_bound(timestamps, timestamps + *hi, start) - timestamps;
+        *lo = resume ? PositionAfter(timestamps, segment.sequences.data(), *hi, cursor.timestamp,
+                                     cursor.sequence)
+                     : first;
+        total += *hi - first;
+        remaining += *hi - *lo;
+    };
+    {
+        // Sealed segments are immutable, so only the head is copied (at most
+        // one page) while the lock is held
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        segments = segments_;
+        size_t lo, hi;
+        bounds(head_, &lo, &hi);
+        size_t copy = std::min(hi - lo, limit);
+        head.timestamps.assign(head_.timestamps.begin() + lo,
+                               head_.timestamps.begin() + lo + copy);
+        head.sequences.assign(head_.sequences.begin() + lo, head_.sequences.begin() + lo + copy);
+        head.entries.assign(head_.entries.begin() + lo, head_.entries.begin() + lo + copy);
+    }
+    
+    std::vector<Slice> slices;
+    slices.reserve(segments->size() + 1);
+    slices.push_back({head.timestamps.data(), head.sequences.data(), head.entries.data(), 0,
+                      head.timestamps.size()});
+    for (const auto& segment : *segments) {
+        const auto& timestamps = segment->timestamps;
+        if (timestamps.back() < start || timestamps.front() >= end) {
+            continue;
+        }
+        size_t lo, hi;
+        bounds(*segment, &lo, &hi);
+        slices.push_back(
+            {timestamps.data(), segment->sequences.data(), segment->entries.data(), lo, hi});
+    }
+    
+    int64_t last_timestamp = 0;
+    uint64_t last_sequence = 0;
+    MergeSlices(slices, limit,
+                [&](int64_t timestamp, uint64_t sequence, const MemoryEntry& entry) {
+        *result->add_entries() = entry;
+        last_timestamp = timestamp;
+        last_sequence = sequence;
+        return true;
+    });
+    result->set_total_count(total);
+    if (remaining > static_cast<size_t>(result->entries_size()) && result->entries_size() > 0) {
+        result->set_has_more(true);
+        result->set_next_cursor(QueryCursor::AfterTime(last_timestamp, last_sequence).Encode());
+    }
+}
+
+void TemporalStore::Get(const MemoryQuery& query, MemoryResult* result) const {
+    // Point lookups scan; temporal stores are meant to be queried by RANGE.
+    // The most recent entry for the key wins, the later write on a tie.
+    const MemoryEntry* latest = nullptr;
+    uint64_t latest_sequence = 0;
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto consider = [&](const Segment& segment) {
+        for (size_t i = segment.entries.size(); i-- > 0;) {
+            if (segment.entries[i].key() == query.query()) {
+                if (!latest || std::make_pair(segment.timestamps[i], segment.sequences[i]) >
+                                   std::make_pair(latest->timestamp(), latest_sequence)) {
+                    latest = &segment.entries[i];
+                    latest_sequence = segment.sequences[i];
+                }
+                break;
+            }
+        }
+    };
+    consider(head_);
+    for (const auto& segment : *segments_) {
+        consider(*segment);
+    }
+    if (latest) {
+        *result->add_entries() = *latest;
+        result->set_total_count(1);
+    }
+}
+
+void TemporalStore::Search(const MemoryQuery& query, MemoryResult* result) const {
+    QueryCursor cursor;
+    if (!QueryCursor::Decode(query, QueryCursor::Kind::kTime, &cursor)) {
+        return;
+    }
+    
+    // Substring scan in time order. A later page resumes after the last
+    // entry the previous page returned and stops at the first match past the
+    // page.
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<Slice> slices;
+    slices.reserve(segments_->size() + 1);
+    auto add_slice = [&](const Segment& segment) {
+        const auto& timestamps = segment.timestamps;
+        size_t lo = cursor.at_start()
+                        ? 0
+                        : PositionAfter(timestamps.data(), segment.sequences.data(),
+                                        timestamps.size(), cursor.timestamp, cursor.sequence);
+        slices.push_back({timestamps.data(), segment.sequences.data(), segment.entries.data(), lo,
+                          timestamps.size()});
+    };
+    add_slice(head_);
+    for (const auto& segment : *segments_) {
+        add_slice(*segment);
+    }
+    
+    size_t limit = EffectiveLimit(query);
+    size_t total = 0;
+    int64_t last_timestamp = 0;
+    uint64_t last_sequence = 0;
+    MergeSlices(slices, std::numeric_limits<size_t>::max(),
+                [&](int64_t timestamp, uint64_t sequence, const MemoryEntry& entry) {
+        if (!ContainsSubstring(entry.key(), query.query()) &&
+            !ContainsSubstring(entry.value(), query.query())) {
+            return true;
+        }
+        if (total < limit) {
+            *result->add_entries() = entry;
+            last_timestamp = timestamp;
+            last_sequence = sequence;
+        }
+        total++;
+        return cursor.at_start() || total <= limit;
+    });
+    if (cursor.at_start()) {
+        result->set_total_count(total);
+    }
+    result->set_has_more(total > limit);
+    if (total > limit) {
+        result->set_next_cursor(QueryCursor::AfterTime(last_timestamp, last_sequence).Encode());
+    }
+}
+
+void TemporalStore::MergeLoop() {
+    std::unique_lock<std::mutex> lock(merge_mutex_);
+    while (true) {
+        merge_cv_.wait(lock, [this] { return stopping_ || merge_requested_; });
+        if (stopping_) {
+            return;
+        }
+        merge_requested_ = false;
+        lock.unlock();
+        while (MergeOnce()) {
+        }
+        lock.lock();
+    }
+}
+
+bool TemporalStore::MergeOnce() {
+    std::shared_ptr<const SegmentList> segments;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        segments = segments_;
+    }
+    
+    // Size-tiered: merge `merge_fan_in` segments of the same size class
+    auto tier_of = [this](size_t size) {
+        size_t tier = 0;
+        for (size_t cap = options_.segment_size * options_.merge_fan_in; size >= cap;
+             cap *= options_.merge_fan_in) {
+            tier++;
+        }
+        return tier;
+    };
+    std::vector<std::vector<const Segment*>> tiers;
+    std::vector<const Segment*> victims;
+    for (const auto& segment : *segments) {
+        size_t tier = tier_of(segment->timestamps.size());
+        if (tiers.size() <= tier) {
+            tiers.resize(tier + 1);
+        }
+        tiers[tier].push_back(segment.get());
+        if (tiers[tier].size() == options_.merge_fan_in) {
+            victims = tiers[tier];
+            break;
+        }
+    }
+    if (victims.empty()) {
+        return false;
+    }
+    
+    // Built outside the store lock; readers keep using the old segments
+    auto merged = std::make_shared<Segment>();
+    size_t count = 0;
+    std::vector<Slice> slices;
+    for (const Segment* segment : victims) {
+        count += segment->timestamps.size();
+        slices.push_back({segment->timestamps.data(), segment->sequences.data(),
+                          segment->entries.data(), 0, segment->timestamps.size()});
+    }
+    merged->timestamps.reserve(count);
+    merged->sequences.reserve(count);
+    merged->entries.reserve(count);
+    MergeSlices(slices, count,
+                [&](int64_t timestamp, uint64_t sequence, const MemoryEntry& entry) {
+        merged->timestamps.push_back(timestamp);
+        merged->sequences.push_back(sequence);
+        merged->entries.push_back(entry);
+        return true;
+    });
+    
+    // Only this thread removes segments, so every victim is still present
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto next = std::make_shared<SegmentList>();
+    next->reserve(segments_->size() - victims.size() + 1);
+    for (const auto& segment : *segments_) {
+        if (std::find(victims.begin(), victims.end(), segment.get()) == victims.end()) {
+            next->push_back(segment);
+        }
+    }
+    next->push_back(std::move(merged));
+    segments_ = std::move(next);
+    return true;
+}
+
+} // namespace gmcp
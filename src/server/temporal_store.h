@@ -0,0 +1,82 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+#include "memory_store.h"
+
+namespace gmcp {
+
+// Append-optimized store for entries queried by time window, ordered by
+// MemoryEntry.timestamp and then by insertion, so equal timestamps keep one
+// order across seals and merges and page cursors can resume after an exact
+// entry. Writes go to a small time-sorted head; a full head is sealed into an
+// immutable segment holding timestamp and sequence columns and a parallel
+// payload column. RANGE binary-searches the timestamp column of each
+// overlapping segment and k-way merges the slices, so a query costs
+// O(segments * log n + k). A background thread merges segments of similar
+// size to keep the segment count logarithmic in the store size.
+class TemporalStore final : public MemoryStore {
+public:
+    struct Options {
+        // Entries per sealed head segment
+        size_t segment_size = 4096;
+        // Segments of one size tier merged together in the background
+        size_t merge_fan_in = 4;
+    };
+
+    TemporalStore();
+    explicit TemporalStore(const Options& options);
+    ~TemporalStore() override;
+
+    bool Put(MemoryEntry&& entry) override;
+    size_t PutBatch(std::vector<MemoryEntry>&& entries) override;
+    void Query(const MemoryQuery& query, MemoryResult* result) const override;
+    size_t size() const override;
+    void ForEach(const std::function<void(const MemoryEntry&)>& visit,
+                 const std::function<void()>& pinned) const override;
+
+    // Number of sealed segments (for diagnostics and benchmarks)
+    size_t segment_count() const;
+
+private:
+    struct Segment {
+        std::vector<int64_t> timestamps;   // sorted ascending
+        std::vector<uint64_t> sequences;   // insertion order, ascending within a timestamp
+        std::vector<MemoryEntry> entries;  // payload, parallel to timestamps
+    };
+    using SegmentList = std::vector<std::shared_ptr<const Segment>>;
+
+    void PutLocked(MemoryEntry&& entry);
+    void SealLocked();
+
+    // One page of the entries with start <= timestamp < end in time order,
+    // resumed from the query's cursor; total_count is the whole window
+    void Range(int64_t start, int64_t end, const MemoryQuery& query, MemoryResult* result) const;
+    void Get(const MemoryQuery& query, MemoryResult* result) const;
+    void Search(const MemoryQuery& query, MemoryResult* result) const;
+
+    void MergeLoop();
+    bool MergeOnce();
+
+    const Options options_;
+
+    mutable std::shared_mutex mutex_;
+    Segment head_;
+    std::shared_ptr<const SegmentList> segments_;
+    size_t sealed_entries_ = 0;
+    uint64_t next_sequence_ = 1;
+
+    std::mutex merge_mutex_;
+    std::condition_variable merge_cv_;
+    bool merge_requested_ = false;
+    bool stopping_ = false;
+    std::thread merge_thread_;
+};
+
+} // namespace gmcp
@@ -0,0 +1,98 @@
+#include "tool_arguments.h"
+#include <charconv>
+
+namespace gmcp {
+
+ToolArgumentPlan::ToolArgumentPlan(
+    const google::protobuf::RepeatedPtrField<ToolParameter>& parameters) {
+    parameters_.reserve(parameters.size());
+    for (const ToolParameter& declared : parameters) {
+        if (Slot(declared.name()) >= 0) {
+            throw ToolArgumentError("duplicate parameter: " + declared.name());
+        }
+        Parameter parameter;
+        parameter.name = declared.name();
+        parameter.type = ParseType(declared.type());
+        parameter.required = declared.required();
+        parameter.fallback.type = parameter.type;
+        if (!declared.default_value().empty()) {
+            parameter.default_text = std::make_shared<const std::string>(declared.default_value());
+            if (!Parse(parameter, *parameter.default_text, &parameter.fallback)) {
+                throw ToolArgumentError("invalid default for parameter " + declared.name() +
+                                        ": " + declared.default_value());
+            }
+        }
+        parameters_.push_back(std::move(parameter));
+    }
+}
+
+ToolArgument::Type ToolArgumentPlan::ParseType(std::string_view type) {
+    if (type == "number" || type == "integer" || type == "float" || type == "double") {
+        return ToolArgument::Type::kNumber;
+    }
+    if (type == "bool" || type == "boolean") {
+        return ToolArgument::Type::kBool;
+    }
+    // Anything else (string, object, ...) is passed through as text
+    return ToolArgument::Type::kString;
+}
+
+int ToolArgumentPlan::Slot(std::string_view name) const {
+    for (size_t i = 0; i < parameters_.size(); ++i) {
+        if (parameters_[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool ToolArgumentPlan::Parse(const Parameter& parameter, std::string_view text,
+                             ToolArgument* slot) {
+    slot->type = parameter.type;
+    slot->present = true;
+    slot->text = text;
+    switch (parameter.type) {
+        case ToolArgument::Type::kNumber: {
+            const char* end = text.data() + text.size();
+            auto [parsed_end, error] = std::from_chars(text.data(), end, slot->number);
+            return error == std::errc() && parsed_end == end;
+        }
+        case ToolArgument::Type::kBool:
+            if (text == "true" || text == "1") {
+                slot->boolean = true;
+                return true;
+            }
+            if (text == "false" || text == "0") {
+                slot->boolean = false;
+                return true;
+            }
+            return false;
+        case ToolArgument::Type::kString:
+            return true;
+    }
+    return false;
+}
+
+void ToolArgumentPlan::Bind(const google::protobuf::Map<std::string, std::string>& arguments,
+                            ToolArgument* slots) const {
+    for (size_t i = 0; i < parameters_.size(); ++i) {
+        const Parameter& parameter = parameters_[i];
+        auto it = arguments.find(parameter.name);
+        if (it == arguments.end()) {
+            if (parameter.required) {
+                throw ToolArgumentError("missing required argument: " + parameter.name);
+            }
+            slots[i] = parameter.fallback;
+            continue;
+        }
+        slots[i] = ToolArgument();
+        if (!Parse(parameter, it->second, &slots[i])) {
+            throw ToolArgumentError("argument " + parameter.name + " is not a valid " +
+                                    (parameter.type == ToolArgument::Type::kNumber ? "number"
+                                                                                   : "bool") +
+                                    ": " + it->second);
+        }
+    }
+}
+
+} // namespace gmcp
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "gmcp.grpc.pb.h"
+
+namespace gmcp {
+
+// One argument after binding. Slot i of a tool's arguments is its
+// registration's parameters(i), so tools address arguments by index.
+struct ToolArgument {
+    enum class Type {
+        kString,
+        kNumber,   // "number", "integer", "float" or "double"
+        kBool,     // "bool" or "boolean"
+    };
+
+    Type type = Type::kString;
+    // False for an optional parameter the call omitted and that has no
+    // default; the typed fields are then zero
+    bool present = false;
+    // The raw text; points into the invocation (or the registration's
+    // default) and is valid for the duration of the call
+    std::string_view text;
+    double number = 0;
+    bool boolean = false;
+};
+
+// Flat, index-addressed view of a call's bound arguments
+class ToolArguments {
+public:
+    ToolArguments(const ToolArgument* slots, size_t size) : slots_(slots), size_(size) {}
+
+    size_t size() const { return size_; }
+    const ToolArgument& operator[](size_t slot) const { return slots_[slot]; }
+
+    bool has(size_t slot) const { return slots_[slot].present; }
+    std::string_view text(size_t slot) const { return slots_[slot].text; }
+    double number(size_t slot) const { return slots_[slot].number; }
+    bool boolean(size_t slot) const { return slots_[slot].boolean; }
+
+private:
+    const ToolArgument* slots_;
+    size_t size_;
+};
+
+// Arguments that do not match the tool's parameters. Reported to the caller
+// as INVALID_ARGUMENT rather than as an error of the tool.
+class ToolArgumentError : public std::invalid_argument {
+public:
+    using std::invalid_argument::invalid_argument;
+};
+
+// A tool's parameter list compiled once at registration: slot types, the
+// required set, and pre-parsed defaults. Binding a call looks each
+// parameter up in the invocation's argument map once, parses typed values
+// with std::from_chars, and fills caller-provided slots, so a call
+// allocates nothing. Arguments without a matching parameter are ignored.
+class ToolArgumentPlan {
+public:
+    // Throws ToolArgumentError for duplicate names or a default that does
+    // not parse as the parameter's type
+    explicit ToolArgumentPlan(const google::protobuf::RepeatedPtrField<ToolParameter>& parameters);
+
+    size_t size() const { return parameters_.size(); }
+
+    // Slot of the named parameter, or -1
+    int Slot(std::string_view name) const;
+
+    // Fill `slots` (size() entries). Throws ToolArgumentError when a
+    // required argument is missing or a value does not parse.
+    void Bind(const google::protobuf::Map<std::string, std::string>& arguments,
+              ToolArgument* slots) const;
+
+    static ToolArgument::Type ParseType(std::string_view type);
+
+private:
+    struct Parameter {
+        std::string name;
+        ToolArgument::Type type;
+        bool required;
+        // Bound default; `present` is false without one
+        ToolArgument fallback;
+        // Owns the text the default points into
+        std::shared_ptr<const std::string> default_text;
+    };
+
+    // Parse `text` as `parameter`'s type into `slot`; false if it does not parse
+    static bool Parse(const Parameter& parameter, std::string_view text, ToolArgument* slot);
+
+    std::vector<Parameter> parameters_;
+};
+
+} // namespace gmcp
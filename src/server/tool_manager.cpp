@@ -1,72 +1,380 @@
 #include "tool_manager.h"
+#include <algorithm>
 #include <chrono>
 #include <stdexcept>
+#include <thread>
 
 namespace gmcp {
 
+ToolManager::ToolManager() : ToolManager(Options()) {
+}
+
+namespace {
+
+size_t DefaultMaxConcurrent() {
+    return 4 * std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Typed tools bind this many arguments on the stack
+constexpr size_t kInlineArguments = 16;
+
+std::map<std::string, std::string> ToStdMap(
+    const google::protobuf::Map<std::string, std::string>& arguments) {
+    return std::map<std::string, std::string>(arguments.begin(), arguments.end());
+}
+
+} // namespace
+
+ToolManager::ToolManager(const Options& options)
+    : coalesce_(options.coalesce),
+      coalesce_min_ns_(std::chrono::nanoseconds(options.coalesce_min_time).count()),
+      queue_budget_(options.queue_budget),
+      limiter_(options.max_concurrent > 0 ? options.max_concurrent : DefaultMaxConcurrent()),
+      cache_(options.cache) {
+}
+
 bool ToolManager::RegisterTool(const ToolRegistration& registration, ToolFunction function) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    if (tools_.find(registration.tool_id()) != tools_.end()) {
-        return false; // Tool already registered
+    return RegisterTool(registration,
+                        [function = std::move(function)](
+                            const google::protobuf::Map<std::string, std::string>& arguments,
+                            const CancellationToken&) { return function(ToStdMap(arguments)); });
+}
+
+bool ToolManager::RegisterTool(const ToolRegistration& registration,
+                               CancellableToolFunction function) {
+    return RegisterTool(registration,
+                        [function = std::move(function)](
+                            const google::protobuf::Map<std::string, std::string>& arguments,
+                            const CancellationToken& cancel) {
+                            return function(ToStdMap(arguments), cancel);
+                        });
+}
+
+bool ToolManager::RegisterTool(const ToolRegistration& registration,
+                               TypedToolFunction function) {
+    auto plan = std::make_shared<const ToolArgumentPlan>(registration.parameters());
+    return RegisterTool(
+        registration,
+        [plan, function = std::move(function)](
+            const google::protobuf::Map<std::string, std::string>& arguments,
+            const CancellationToken& cancel) {
+            ToolArgument inline_slots[kInlineArguments];
+            std::vector<ToolArgument> heap_slots;
+            ToolArgument* slots = inline_slots;
+            if (plan->size() > kInlineArguments) {
+                heap_slots.resize(plan->size());
+                slots = heap_slots.data();
+            }
+            plan->Bind(arguments, slots);
+            return function(ToolArguments(slots, plan->size()), cancel);
+        });
+}
+
+bool ToolManager::RegisterTool(const ToolRegistration& registration,
+                               NativeToolFunction function) {
+    return Install(registration, std::move(function), [&](const ToolEntry* current) {
+        return !current || registration.replace();
+    }) != 0;
+}
+
+uint64_t ToolManager::ReplaceTool(const ToolRegistration& registration,
+                                  NativeToolFunction function, uint64_t replaces) {
+    return Install(registration, std::move(function), [replaces](const ToolEntry* current) {
+        return (current ? current->generation : 0) == replaces;
+    });
+}
+
+uint64_t ToolManager::Install(const ToolRegistration& registration, NativeToolFunction function,
+                              const std::function<bool(const ToolEntry*)>& accept) {
+    auto entry = std::make_shared<ToolEntry>();
+    entry->registration = std::make_shared<ToolRegistration>(registration);
+    entry->function = std::move(function);
+    if (registration.max_concurrency() > 0) {
+        entry->limiter = std::make_unique<ConcurrencyLimiter>(registration.max_concurrency());
     }
+    uint64_t generation = next_generation_.fetch_add(1, std::memory_order_relaxed);
+    entry->generation = generation;
     
-    auto tool_reg = std::make_shared<ToolRegistration>(registration);
-    tools_[registration.tool_id()] = tool_reg;
-    tool_functions_[registration.tool_id()] = function;
-    
-    return true;
+    bool replaced = false;
+    bool success = tools_.Update([&](ToolTable& tools) {
+        auto it = tools.find(registration.tool_id());
+        if (!accept(it != tools.end() ? it->second.get() : nullptr)) {
+            return false;
+        }
+        if (it == tools.end()) {
+            tools.emplace(registration.tool_id(), std::move(entry));
+            return true;
+        }
+        it->second = std::move(entry);
+        replaced = true;
+        return true;
+    });
+    // The new generation already misses old entries; this frees their memory
+    if (replaced) {
+        cache_.EraseTool(registration.tool_id());
+    }
+    return success ? generation : 0;
 }
 
-ToolResult ToolManager::InvokeTool(const ToolInvocation& invocation) {
+bool ToolManager::UnregisterTool(const std::string& tool_id) {
+    bool removed = tools_.Update([&](ToolTable& tools) { return tools.erase(tool_id) > 0; });
+    if (removed) {
+        cache_.EraseTool(tool_id);
+    }
+    return removed;
+}
+
+bool ToolManager::UnregisterTool(const std::string& tool_id, uint64_t generation) {
+    bool removed = tools_.Update([&](ToolTable& tools) {
+        auto it = tools.find(tool_id);
+        if (it == tools.end() || it->second->generation != generation) {
+            return false;
+        }
+        tools.erase(it);
+        return true;
+    });
+    if (removed) {
+        cache_.EraseTool(tool_id);
+    }
+    return removed;
+}
+
+ToolResult ToolManager::InvokeTool(const ToolInvocation& invocation,
+                                   const CancellationToken& cancel) {
     ToolResult result;
-    result.set_request_id(invocation.request_id());
+    InvokeTool(invocation, &result, cancel);
+    return result;
+}
+
+void ToolManager::InvokeTool(const ToolInvocation& invocation, ToolResult* result,
+                             const CancellationToken& cancel) {
+    result->set_request_id(invocation.request_id());
+    
+    auto tools = tools_.Read();
+    
+    auto it = tools->find(invocation.tool_id());
+    if (it == tools->end()) {
+        result->set_success(false);
+        result->set_error_message("Tool not found: " + invocation.tool_id());
+        return;
+    }
     
+    if (invocation.timeout_ms() > 0) {
+        CancellationToken timeout(
+            CancellationToken::Clock::now() + std::chrono::milliseconds(invocation.timeout_ms()),
+            nullptr, &cancel);
+        Invoke(*it->second, invocation, result, timeout);
+    } else {
+        Invoke(*it->second, invocation, result, cancel);
+    }
+}
+
+void ToolManager::Invoke(const ToolEntry& tool, const ToolInvocation& invocation,
+                         ToolResult* result, const CancellationToken& cancel) {
     auto start = std::chrono::high_resolution_clock::now();
     
-    std::lock_guard<std::mutex> lock(mutex_);
+    const bool cacheable = tool.registration->cacheable() && cache_.enabled();
+    // A tool not yet timed counts as slow
+    const int64_t average_ns = tool.average_ns.load(std::memory_order_relaxed);
+    const bool coalesce = coalesce_ && (average_ns < 0 || average_ns >= coalesce_min_ns_);
+    // The cache and the in-flight table share one canonical key
+    std::string key;
+    if (cacheable || coalesce) {
+        key = ToolResultCache::MakeKey(invocation.tool_id(), tool.generation,
+                                       invocation.arguments());
+    }
+    if (cacheable && cache_.Lookup(key, result->mutable_result())) {
+        result->set_success(true);
+        result->set_cache_hit(true);
+        SetElapsed(start, result);
+        return;
+    }
     
-    auto it = tool_functions_.find(invocation.tool_id());
-    if (it == tool_functions_.end()) {
-        result.set_success(false);
-        result.set_error_message("Tool not found: " + invocation.tool_id());
-        return result;
+    if (!coalesce) {
+        SingleFlight::Outcome outcome = Run(tool, invocation, cancel);
+        if (cacheable && outcome.success) {
+            cache_.Insert(key, outcome.value,
+                          std::chrono::milliseconds(tool.registration->cache_ttl_ms()));
+        }
+        ApplyOutcome(std::move(outcome), result);
+        SetElapsed(start, result);
+        return;
     }
     
-    try {
-        // Convert arguments
-        std::map<std::string, std::string> args;
-        for (const auto& [key, value] : invocation.arguments()) {
-            args[key] = value;
+    while (true) {
+        bool leader = false;
+        std::shared_ptr<SingleFlight::Call> call = in_flight_.Join(key, &leader);
+        if (!leader) {
+            // Same tool and arguments already running: share its outcome. The
+            // timing reported is this caller's own wait.
+            const SingleFlight::Outcome* shared = call->Wait(cancel);
+            if (!shared) {
+                ApplyOutcome(Cancelled(cancel), result);
+                break;
+            }
+            // The leader's caller gave up, which says nothing about this one
+            if ((shared->status_code == grpc::StatusCode::CANCELLED ||
+                 shared->status_code == grpc::StatusCode::DEADLINE_EXCEEDED) &&
+                !cancel.cancelled()) {
+                continue;
+            }
+            ApplyOutcome(*shared, result);
+            result->set_coalesced(true);
+            break;
         }
-        
-        // Execute tool function
-        std::string tool_result = it->second(args);
-        
-        result.set_success(true);
-        result.set_result(tool_result);
-    } catch (const std::exception& e) {
-        result.set_success(false);
-        result.set_error_message(std::string("Tool execution error: ") + e.what());
+        SingleFlight::Outcome outcome = Run(tool, invocation, cancel);
+        // Cache before retiring the call, so a caller arriving in between hits
+        if (cacheable && outcome.success) {
+            cache_.Insert(key, outcome.value,
+                          std::chrono::milliseconds(tool.registration->cache_ttl_ms()));
+        }
+        ApplyOutcome(outcome, result);
+        in_flight_.Complete(key, call, std::move(outcome));
+        break;
+    }
+    SetElapsed(start, result);
+}
+
+SingleFlight::Outcome ToolManager::Run(const ToolEntry& tool, const ToolInvocation& invocation,
+                                       const CancellationToken& cancel) {
+    if (cancel.cancelled()) {
+        return Cancelled(cancel);
     }
     
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-    result.set_execution_time_ms(duration.count());
+    // Expected waits are estimated from this tool's typical run time
+    const int64_t service_ns = std::max<int64_t>(
+        tool.average_ns.load(std::memory_order_relaxed), 0);
+    using Admission = ConcurrencyLimiter::Admission;
+    using Clock = ConcurrencyLimiter::Clock;
+    SingleFlight::Outcome outcome;
+    // The budget covers both queues: the global limiter only gets what is
+    // left after waiting for the tool's slot
+    const Clock::time_point queue_deadline = Clock::now() + queue_budget_;
+    // The tool's own slot first, so calls queued on a saturated tool do not
+    // hold global slots other tools could use
+    ConcurrencyLimiter* tool_limiter = tool.limiter.get();
+    Admission admission = tool_limiter
+                              ? tool_limiter->Acquire(service_ns, queue_budget_, cancel)
+                              : Admission::kAdmitted;
+    if (admission == Admission::kAdmitted) {
+        admission = limiter_.Acquire(
+            service_ns, std::max(queue_deadline - Clock::now(), Clock::duration::zero()),
+            cancel);
+        if (admission == Admission::kAdmitted) {
+            outcome = Execute(tool, invocation, cancel);
+            limiter_.Release();
+        }
+        if (tool_limiter) {
+            tool_limiter->Release();
+        }
+    }
     
-    return result;
+    if (admission == Admission::kRejected) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        outcome.error = "Tool overloaded: " + invocation.tool_id() +
+                        " cannot start within its latency budget";
+        outcome.status_code = grpc::StatusCode::RESOURCE_EXHAUSTED;
+        return outcome;
+    }
+    // A tool that stopped early may have returned a partial result; never
+    // hand it out or cache it
+    if (admission == Admission::kCancelled || cancel.cancelled()) {
+        return Cancelled(cancel);
+    }
+    return outcome;
+}
+
+SingleFlight::Outcome ToolManager::Cancelled(const CancellationToken& cancel) {
+    SingleFlight::Outcome outcome;
+    if (cancel.expired()) {
+        outcome.error = "Tool invocation deadline exceeded";
+        outcome.status_code = grpc::StatusCode::DEADLINE_EXCEEDED;
+    } else {
+        outcome.error = "Tool invocation cancelled";
+        outcome.status_code = grpc::StatusCode::CANCELLED;
+    }
+    return outcome;
+}
+
+SingleFlight::Outcome ToolManager::Execute(const ToolEntry& tool,
+                                           const ToolInvocation& invocation,
+                                           const CancellationToken& cancel) {
+    SingleFlight::Outcome outcome;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        outcome.value = tool.function(invocation.arguments(), cancel);
+        outcome.success = true;
+    } catch (const ToolArgumentError& e) {
+        outcome.error = std::string("Invalid arguments: ") + e.what();
+        outcome.status_code = grpc::StatusCode::INVALID_ARGUMENT;
+    } catch (const std::exception& e) {
+        outcome.error = std::string("Tool execution error: ") + e.what();
+    } catch (...) {
+        // Waiters depend on the leader completing, whatever the tool throws
+        outcome.error = "Tool execution error: unknown exception";
+    }
+    
+    // Concurrent updates may lose a sample, which an average tolerates
+    int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    int64_t average = tool.average_ns.load(std::memory_order_relaxed);
+    tool.average_ns.store(average < 0 ? elapsed : average + (elapsed - average) / 8,
+                          std::memory_order_relaxed);
+    return outcome;
+}
+
+void ToolManager::ApplyOutcome(const SingleFlight::Outcome& outcome, ToolResult* result) {
+    result->set_success(outcome.success);
+    result->set_status_code(outcome.status_code);
+    if (outcome.success) {
+        result->set_result(outcome.value);
+    } else {
+        result->set_error_message(outcome.error);
+    }
+}
+
+void ToolManager::ApplyOutcome(SingleFlight::Outcome&& outcome, ToolResult* result) {
+    result->set_success(outcome.success);
+    result->set_status_code(outcome.status_code);
+    if (outcome.success) {
+        result->set_result(std::move(outcome.value));
+    } else {
+        result->set_error_message(std::move(outcome.error));
+    }
+}
+
+void ToolManager::SetElapsed(std::chrono::high_resolution_clock::time_point start,
+                             ToolResult* result) {
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - start);
+    result->set_execution_time_ms(duration.count() / 1000);
+    result->set_execution_time_us(duration.count());
 }
 
 std::shared_ptr<ToolRegistration> ToolManager::GetTool(const std::string& tool_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = tools_.find(tool_id);
-    return (it != tools_.end()) ? it->second : nullptr;
+    auto tools = tools_.Read();
+    auto it = tools->find(tool_id);
+    return (it != tools->end()) ? it->second->registration : nullptr;
+}
+
+ToolManager::AdmissionStats ToolManager::admission_stats() const {
+    AdmissionStats stats;
+    stats.running = limiter_.active();
+    stats.queued = limiter_.waiting();
+    auto tools = tools_.Read();
+    for (const auto& [id, tool] : *tools) {
+        if (tool->limiter) {
+            stats.queued += tool->limiter->waiting();
+        }
+    }
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+    return stats;
 }
 
 std::vector<std::string> ToolManager::ListTools() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto tools = tools_.Read();
     std::vector<std::string> tool_ids;
-    for (const auto& [id, _] : tools_) {
+    for (const auto& [id, _] : *tools) {
         tool_ids.push_back(id);
     }
     return tool_ids;
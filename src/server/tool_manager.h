@@ -1,38 +1,163 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <map>
 #include <functional>
 #include <memory>
-#include <mutex>
+#include <vector>
 #include "gmcp.grpc.pb.h"
+#include "cancellation.h"
+#include "concurrency_limiter.h"
+#include "rcu_snapshot.h"
+#include "tool_arguments.h"
+#include "single_flight.h"
+#include "tool_result_cache.h"
 
 namespace gmcp {
 
 // Tool function signature
 using ToolFunction = std::function<std::string(const std::map<std::string, std::string>&)>;
 
+// Tool function that can stop early: it should poll the token between units
+// of work and return once it fires, as the caller no longer waits for it
+using CancellableToolFunction = std::function<std::string(
+    const std::map<std::string, std::string>&, const CancellationToken&)>;
+
+// Tool function taking its arguments bound to the registration's parameters:
+// slot i is parameters(i), typed and validated, with defaults applied
+using TypedToolFunction =
+    std::function<std::string(const ToolArguments&, const CancellationToken&)>;
+
+// Tool function reading the invocation's arguments in place, with no copy
+// into a std::map per call; native plugins are bound through it
+using NativeToolFunction = std::function<std::string(
+    const google::protobuf::Map<std::string, std::string>&, const CancellationToken&)>;
+
 class ToolManager {
 public:
-    ToolManager() = default;
+    struct Options {
+        // Results of tools registered as cacheable
+        ToolResultCache::Options cache;
+        // Run identical concurrent invocations (same tool and arguments) once
+        // and hand every caller the result
+        bool coalesce = true;
+        // Only coalesce tools averaging at least this execution time; for
+        // faster tools a duplicate run costs less than the bookkeeping
+        std::chrono::microseconds coalesce_min_time{20};
+        // Tool executions running at once across all tools (0 = four per
+        // hardware thread); registrations may set a lower per-tool limit
+        size_t max_concurrent = 0;
+        // Longest a call may queue for its tool's slot and a global slot
+        // together. Calls whose expected wait exceeds it (or their deadline)
+        // fail with RESOURCE_EXHAUSTED at once.
+        std::chrono::milliseconds queue_budget{100};
+    };
+
+    struct AdmissionStats {
+        // Executions holding a global slot
+        size_t running = 0;
+        // Calls waiting for a global or per-tool slot
+        size_t queued = 0;
+        // Calls refused because their wait would exceed the budget
+        uint64_t rejected = 0;
+    };
+
+    ToolManager();
+    explicit ToolManager(const Options& options);
     ~ToolManager() = default;
 
-    // Register a new tool
+    // Register a new tool. Fails if the id is taken, unless the registration
+    // sets `replace`; replacing drops the tool's cached results.
     bool RegisterTool(const ToolRegistration& registration, ToolFunction function);
+    bool RegisterTool(const ToolRegistration& registration, CancellableToolFunction function);
+    bool RegisterTool(const ToolRegistration& registration, NativeToolFunction function);
+    // Compiles the registration's parameters into a binding plan; throws
+    // ToolArgumentError if they are inconsistent
+    bool RegisterTool(const ToolRegistration& registration, TypedToolFunction function);
+    
+    // Install a tool in place of the registration with generation `replaces`
+    // (0: the id must be free), whatever the registration's `replace` says.
+    // Returns the new registration's generation, or 0 if the id is held by
+    // any other registration; lets an owner never replace another's tool.
+    uint64_t ReplaceTool(const ToolRegistration& registration, NativeToolFunction function,
+                         uint64_t replaces);
+    
+    // Remove a tool and its cached results. Invocations already running
+    // finish; false if no such tool is registered.
+    bool UnregisterTool(const std::string& tool_id);
+    // Remove the tool only while `generation` is still its registration
+    bool UnregisterTool(const std::string& tool_id, uint64_t generation);
     
-    // Invoke a registered tool
-    ToolResult InvokeTool(const ToolInvocation& invocation);
+    // Invoke a registered tool; cacheable tools may be answered from the
+    // cache, and an invocation identical to one in flight waits for its result.
+    // Executions are admitted by the global and per-tool concurrency limits;
+    // failures of admission or cancellation set the result's status_code.
+    ToolResult InvokeTool(const ToolInvocation& invocation,
+                          const CancellationToken& cancel = CancellationToken::None());
+    
+    // Invoke a registered tool, building the result in place (e.g. inside an
+    // arena-allocated reply)
+    void InvokeTool(const ToolInvocation& invocation, ToolResult* result,
+                    const CancellationToken& cancel = CancellationToken::None());
     
     // Get tool registration by ID
     std::shared_ptr<ToolRegistration> GetTool(const std::string& tool_id);
     
     // List all registered tools
     std::vector<std::string> ListTools() const;
+    
+    ToolResultCache::Stats cache_stats() const { return cache_.stats(); }
+    
+    // Invocations answered by another caller's execution
+    uint64_t coalesced_count() const { return in_flight_.coalesced(); }
+    
+    AdmissionStats admission_stats() const;
 
 private:
-    std::mutex mutex_;
-    std::map<std::string, std::shared_ptr<ToolRegistration>> tools_;
-    std::map<std::string, ToolFunction> tool_functions_;
+    struct ToolEntry {
+        std::shared_ptr<ToolRegistration> registration;
+        NativeToolFunction function;
+        // Null without a per-tool limit
+        std::unique_ptr<ConcurrencyLimiter> limiter;
+        // Distinguishes this registration's cache entries from those of an
+        // earlier registration under the same id
+        uint64_t generation = 0;
+        // Moving average of execution time; -1 until the first run
+        mutable std::atomic<int64_t> average_ns{-1};
+    };
+    using ToolTable = std::map<std::string, std::shared_ptr<const ToolEntry>>;
+
+    // Publish the entry when `accept` allows replacing the id's current
+    // entry (null if the id is free); returns its generation, 0 if refused
+    uint64_t Install(const ToolRegistration& registration, NativeToolFunction function,
+                     const std::function<bool(const ToolEntry*)>& accept);
+
+    // Execute once admitted by the tool's and the global limiter
+    SingleFlight::Outcome Run(const ToolEntry& tool, const ToolInvocation& invocation,
+                              const CancellationToken& cancel);
+    void Invoke(const ToolEntry& tool, const ToolInvocation& invocation, ToolResult* result,
+                const CancellationToken& cancel);
+    static SingleFlight::Outcome Execute(const ToolEntry& tool, const ToolInvocation& invocation,
+                                         const CancellationToken& cancel);
+    static SingleFlight::Outcome Cancelled(const CancellationToken& cancel);
+    static void ApplyOutcome(const SingleFlight::Outcome& outcome, ToolResult* result);
+    static void ApplyOutcome(SingleFlight::Outcome&& outcome, ToolResult* result);
+    static void SetElapsed(std::chrono::high_resolution_clock::time_point start,
+                           ToolResult* result);
+
+    // Registrations publish a new table; invocations read it without locking,
+    // so a slow tool never blocks other callers or registrations
+    RcuSnapshot<ToolTable> tools_;
+    std::atomic<uint64_t> next_generation_{1};
+    const bool coalesce_;
+    const int64_t coalesce_min_ns_;
+    const std::chrono::milliseconds queue_budget_;
+    ConcurrencyLimiter limiter_;
+    std::atomic<uint64_t> rejected_{0};
+    ToolResultCache cache_;
+    SingleFlight in_flight_;
 };
 
 } // namespace gmcp
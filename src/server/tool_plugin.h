@@ -0,0 +1,126 @@
+/*
+ * C ABI of native tool plugins.
+ *
+ * A plugin is a shared object that exports gmcp_plugin_describe(), returning
+ * a static table of tools. The server loads every plugin in its plugin
+ * directory and registers the tools; when a file changes it loads the new
+ * version next to the old one and swaps the registrations, so calls already
+ * running finish on the old code. Install plugins by renaming a complete
+ * file into place.
+ *
+ * Calls pass arguments as views of the server's own request, so no strings
+ * are copied or converted on the way in. Views are valid only for the
+ * duration of the call. A tool writes its result (or its error) through the
+ * gmcp_call it receives.
+ *
+ * Plain C so plugins may be built with any compiler or language that can
+ * export C symbols.
+ */
+#ifndef GMCP_TOOL_PLUGIN_H
+#define GMCP_TOOL_PLUGIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped on any incompatible change; plugins built against another version
+ * are refused */
+#define GMCP_PLUGIN_ABI_VERSION 1
+
+/* Symbol every plugin exports */
+#define GMCP_PLUGIN_ENTRY "gmcp_plugin_describe"
+
+#if defined(__GNUC__)
+#define GMCP_PLUGIN_EXPORT __attribute__((visibility("default")))
+#else
+#define GMCP_PLUGIN_EXPORT
+#endif
+
+/* Not NUL-terminated */
+typedef struct {
+    const char* data;
+    size_t size;
+} gmcp_string_view;
+
+typedef struct {
+    gmcp_string_view key;
+    gmcp_string_view value;
+} gmcp_argument;
+
+typedef struct gmcp_call gmcp_call;
+
+/* Provided by the server for one invocation */
+struct gmcp_call {
+    /* Append bytes to the result */
+    void (*write)(gmcp_call* call, const char* data, size_t size);
+    /* Fail the invocation; anything written is discarded */
+    void (*fail)(gmcp_call* call, const char* message, size_t size);
+    /* Nonzero once the caller gave up or its deadline passed. Long-running
+     * tools poll it between units of work and return early. */
+    int (*cancelled)(const gmcp_call* call);
+    /* Server state; opaque to the plugin */
+    void* host;
+};
+
+/* Arguments arrive in no particular order. Must not throw or unwind into
+ * the server; report failures through call->fail. */
+typedef void (*gmcp_tool_invoke_fn)(void* tool_data, const gmcp_argument* arguments,
+                                    size_t argument_count, gmcp_call* call);
+
+typedef struct {
+    const char* name;
+    const char* type;
+    int required;
+    const char* description;
+} gmcp_tool_parameter;
+
+/* Mirrors the ToolRegistration message */
+typedef struct {
+    const char* tool_id;
+    const char* name;
+    const char* description;
+    const char* return_type;
+    const gmcp_tool_parameter* parameters;
+    size_t parameter_count;
+    /* Equal arguments give equal results */
+    int cacheable;
+    int64_t cache_ttl_ms;
+    /* 0 = no per-tool limit */
+    int32_t max_concurrency;
+    gmcp_tool_invoke_fn invoke;
+    /* Passed back to invoke */
+    void* data;
+} gmcp_tool_descriptor;
+
+typedef struct {
+    /* GMCP_PLUGIN_ABI_VERSION the plugin was built against */
+    uint32_t abi_version;
+    const gmcp_tool_descriptor* tools;
+    size_t tool_count;
+} gmcp_plugin;
+
+typedef const gmcp_plugin* (*gmcp_plugin_describe_fn)(void);
+
+/* Value of the argument named `key`, or NULL */
+static inline const gmcp_string_view* gmcp_find_argument(const gmcp_argument* arguments,
+                                                         size_t argument_count,
+                                                         const char* key) {
+    size_t key_size = strlen(key);
+    for (size_t i = 0; i < argument_count; ++i) {
+        if (arguments[i].key.size == key_size &&
+            memcmp(arguments[i].key.data, key, key_size) == 0) {
+            return &arguments[i].value;
+        }
+    }
+    return NULL;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* GMCP_TOOL_PLUGIN_H */
@@ -0,0 +1,149 @@
+#include "tool_result_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace gmcp {
+
+namespace {
+
+// Rough cost of an entry beyond its strings: list node, index node, bucket
+constexpr size_t kEntryOverhead = 128;
+
+void AppendField(std::string* out, const std::string& value) {
+    uint32_t length = static_cast<uint32_t>(value.size());
+    out->append(reinterpret_cast<const char*>(&length), sizeof(length));
+    out->append(value);
+}
+
+} // namespace
+
+ToolResultCache::ToolResultCache() : ToolResultCache(Options()) {
+}
+
+ToolResultCache::ToolResultCache(const Options& options) {
+    if (options.max_bytes == 0) {
+        return;
+    }
+    size_t shard_count = std::max<size_t>(options.shard_count, 1);
+    shard_budget_ = options.max_bytes / shard_count;
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+std::string ToolResultCache::MakeKey(
+    const std::string& tool_id, uint64_t generation,
+    const google::protobuf::Map<std::string, std::string>& arguments) {
+    // Length-prefixed fields, so no choice of ids or values can collide
+    std::string key;
+    AppendField(&key, tool_id);
+    key.append(reinterpret_cast<const char*>(&generation), sizeof(generation));
+
+    using Argument = google::protobuf::Map<std::string, std::string>::value_type;
+    std::vector<const Argument*> sorted;
+    sorted.reserve(arguments.size());
+    for (const auto& argument : arguments) {
+        sorted.push_back(&argument);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Argument* a, const Argument* b) { return a->first < b->first; });
+    for (const Argument* argument : sorted) {
+        AppendField(&key, argument->first);
+        AppendField(&key, argument->second);
+    }
+    return key;
+}
+
+ToolResultCache::Shard& ToolResultCache::ShardOf(std::string_view key) {
+    return *shards_[std::hash<std::string_view>{}(key) % shards_.size()];
+}
+
+void ToolResultCache::EraseLocked(Shard& shard, std::list<Entry>::iterator it) {
+    shard.bytes -= it->bytes;
+    shard.index.erase(it->key);
+    shard.lru.erase(it);
+}
+
+bool ToolResultCache::Lookup(const std::string& key, std::string* result) {
+    if (!enabled()) {
+        return false;
+    }
+    Shard& shard = ShardOf(key);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.index.find(key);
+        if (found != shard.index.end()) {
+            auto it = found->second;
+            if (Clock::now() < it->expires_at) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, it);
+                *result = it->result;
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            EraseLocked(shard, it);
+            expirations_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void ToolResultCache::Insert(const std::string& key, const std::string& result,
+                             std::chrono::milliseconds ttl) {
+    if (!enabled()) {
+        return;
+    }
+    size_t bytes = key.size() + result.size() + kEntryOverhead;
+    if (bytes > shard_budget_) {
+        return;
+    }
+    Clock::time_point expires_at =
+        ttl.count() > 0 ? Clock::now() + ttl : Clock::time_point::max();
+
+    Shard& shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) {
+        EraseLocked(shard, found->second);
+    }
+    shard.lru.push_front(Entry{key, result, expires_at, bytes});
+    shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+    shard.bytes += bytes;
+    while (shard.bytes > shard_budget_) {
+        EraseLocked(shard, std::prev(shard.lru.end()));
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ToolResultCache::EraseTool(const std::string& tool_id) {
+    std::string prefix;
+    AppendField(&prefix, tool_id);
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (auto it = shard->lru.begin(); it != shard->lru.end();) {
+            auto next = std::next(it);
+            if (it->key.compare(0, prefix.size(), prefix) == 0) {
+                EraseLocked(*shard, it);
+            }
+            it = next;
+        }
+    }
+}
+
+ToolResultCache::Stats ToolResultCache::stats() const {
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+    stats.expirations = expirations_.load(std::memory_order_relaxed);
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.entries += shard->lru.size();
+        stats.bytes += shard->bytes;
+    }
+    return stats;
+}
+
+} // namespace gmcp
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "gmcp.grpc.pb.h"
+
+namespace gmcp {
+
+// Memory-bounded LRU of tool results, for tools registered as cacheable.
+//
+// Keys combine the tool id, the registration generation and the arguments in
+// key order, so a map's iteration order never causes a miss and a
+// re-registered tool never serves results of its previous implementation.
+// The cache is split into hash shards, each with its own lock, LRU list and
+// share of the byte budget; a lookup locks one shard.
+class ToolResultCache {
+public:
+    struct Options {
+        // Budget for keys and results across all shards (0 disables caching)
+        size_t max_bytes = 64 << 20;
+        size_t shard_count = 16;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        // Entries dropped to stay within the byte budget
+        uint64_t evictions = 0;
+        // Entries found past their TTL
+        uint64_t expirations = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+    };
+
+    ToolResultCache();
+    explicit ToolResultCache(const Options& options);
+
+    ToolResultCache(const ToolResultCache&) = delete;
+    ToolResultCache& operator=(const ToolResultCache&) = delete;
+
+    bool enabled() const { return !shards_.empty(); }
+
+    // Canonical key of one invocation of a tool registration
+    static std::string MakeKey(const std::string& tool_id, uint64_t generation,
+                               const google::protobuf::Map<std::string, std::string>& arguments);
+
+    // Copies a live cached result into `result`; false on a miss
+    bool Lookup(const std::string& key, std::string* result);
+
+    // Cache a result; a zero `ttl` keeps it until evicted
+    void Insert(const std::string& key, const std::string& result, std::chrono::milliseconds ttl);
+
+    // Drop every entry of a tool, e.g. when it is re-registered
+    void EraseTool(const std::string& tool_id);
+
+    Stats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string key;
+        std::string result;
+        Clock::time_point expires_at;
+        size_t bytes;
+    };
+
+    // Padded so neighbouring shard locks do not share a cache line
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        // Most recently used first
+        std::list<Entry> lru;
+        // Views into the keys held by `lru`
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    Shard& ShardOf(std::string_view key);
+    // Caller holds the shard's mutex
+    void EraseLocked(Shard& shard, std::list<Entry>::iterator it);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t shard_budget_ = 0;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> expirations_{0};
+};
+
+} // namespace gmcp
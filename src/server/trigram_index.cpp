@@ -0,0 +1,126 @@
+#include "trigram_index.h"
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+
+namespace gmcp {
+
+namespace {
+
+void AppendGrams(std::string_view text, std::vector<uint32_t>* grams) {
+    for (size_t i = 0; i + TrigramIndex::kGramSize <= text.size(); ++i) {
+        grams->push_back(static_cast<uint32_t>(static_cast<unsigned char>(text[i])) << 16 |
+                         static_cast<uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8 |
+                         static_cast<uint32_t>(static_cast<unsigned char>(text[i + 2])));
+    }
+}
+
+void SortUnique(std::vector<uint32_t>* values) {
+    std::sort(values->begin(), values->end());
+    values->erase(std::unique(values->begin(), values->end()), values->end());
+}
+
+} // namespace
+
+std::vector<TrigramIndex::Gram> TrigramIndex::GramsOf(std::string_view key,
+                                                      std::string_view value) {
+    // Key and value are indexed separately so no trigram spans both
+    std::vector<Gram> grams;
+    AppendGrams(key, &grams);
+    AppendGrams(value, &grams);
+    SortUnique(&grams);
+    return grams;
+}
+
+void TrigramIndex::Update(const MemoryEntry& entry) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    UpdateLocked(entry);
+}
+
+void TrigramIndex::Update(const std::vector<MemoryEntry*>& entries) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (const MemoryEntry* entry : entries) {
+        UpdateLocked(*entry);
+    }
+}
+
+void TrigramIndex::UpdateLocked(const MemoryEntry& entry) {
+    std::vector<Gram> grams = GramsOf(entry.key(), entry.value());
+    
+    auto [it, inserted] = doc_ids_.try_emplace(entry.key(), static_cast<DocId>(keys_.size()));
+    DocId doc = it->second;
+    if (inserted) {
+        // New documents get the highest id, so appending keeps postings sorted
+        keys_.push_back(entry.key());
+        for (Gram gram : grams) {
+            postings_[gram].push_back(doc);
+        }
+        doc_grams_.push_back(std::move(grams));
+        return;
+    }
+    
+    // Re-indexed document: only touch the postings whose membership changed
+    const std::vector<Gram>& old_grams = doc_grams_[doc];
+    std::vector<Gram> removed;
+    std::vector<Gram> added;
+    std::set_difference(old_grams.begin(), old_grams.end(), grams.begin(), grams.end(),
+                        std::back_inserter(removed));
+    std::set_difference(grams.begin(), grams.end(), old_grams.begin(), old_grams.end(),
+                        std::back_inserter(added));
+    
+    for (Gram gram : removed) {
+        auto posting = postings_.find(gram);
+        auto& docs = posting->second;
+        docs.erase(std::lower_bound(docs.begin(), docs.end(), doc));
+        if (docs.empty()) {
+            postings_.erase(posting);
+        }
+    }
+    for (Gram gram : added) {
+        auto& docs = postings_[gram];
+        docs.insert(std::lower_bound(docs.begin(), docs.end(), doc), doc);
+    }
+    doc_grams_[doc] = std::move(grams);
+}
+
+std::vector<std::string> TrigramIndex::Candidates(std::string_view needle) const {
+    std::vector<Gram> grams;
+    AppendGrams(needle, &grams);
+    SortUnique(&grams);
+    
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    
+    std::vector<const std::vector<DocId>*> lists;
+    lists.reserve(grams.size());
+    for (Gram gram : grams) {
+        auto it = postings_.find(gram);
+        if (it == postings_.end()) {
+            return {};
+        }
+        lists.push_back(&it->second);
+    }
+    if (lists.empty()) {
+        return {};
+    }
+    
+    // Intersect smallest first so the working set only shrinks
+    std::sort(lists.begin(), lists.end(),
+              [](const auto* a, const auto* b) { return a->size() < b->size(); });
+    std::vector<DocId> docs = *lists.front();
+    std::vector<DocId> next;
+    for (size_t i = 1; i < lists.size() && !docs.empty(); ++i) {
+        next.clear();
+        std::set_intersection(docs.begin(), docs.end(), lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(next));
+        docs.swap(next);
+    }
+    
+    std::vector<std::string> keys;
+    keys.reserve(docs.size());
+    for (DocId doc : docs) {
+        keys.push_back(keys_[doc]);
+    }
+    return keys;
+}
+
+} // namespace gmcp
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "gmcp.grpc.pb.h"
+
+namespace gmcp {
+
+// Inverted index from byte trigrams to the keys whose key or value contains
+// them. Maintained incrementally on every write; a substring query intersects
+// the posting lists of the needle's trigrams, smallest first, to produce a
+// candidate set that the caller verifies against the stored entries.
+class TrigramIndex {
+public:
+    static constexpr size_t kGramSize = 3;
+
+    // Index (or re-index) one entry
+    void Update(const MemoryEntry& entry);
+
+    // Index many entries under a single lock acquisition
+    void Update(const std::vector<MemoryEntry*>& entries);
+
+    // Keys that may contain `needle`. Only meaningful for needles of at least
+    // kGramSize bytes; candidates must still be verified.
+    std::vector<std::string> Candidates(std::string_view needle) const;
+
+private:
+    using DocId = uint32_t;
+    using Gram = uint32_t;
+
+    static std::vector<Gram> GramsOf(std::string_view key, std::string_view value);
+    void UpdateLocked(const MemoryEntry& entry);
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, DocId> doc_ids_;
+    // Indexed by DocId
+    std::vector<std::string> keys_;
+    std::vector<std::vector<Gram>> doc_grams_;
+    // Sorted DocIds per trigram
+    std::unordered_map<Gram, std::vector<DocId>> postings_;
+};
+
+} // namespace gmcp
@@ -0,0 +1,138 @@
+#include "vector_kernels.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define GMCP_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace gmcp {
+
+namespace {
+
+float DotScalar(const float* a, const float* b, size_t n) {
+    // Independent accumulators let the compiler keep several FMAs in flight
+    float sum[4] = {0, 0, 0, 0};
+    for (size_t i = 0; i < n; i += 4) {
+        sum[0] += a[i] * b[i];
+        sum[1] += a[i + 1] * b[i + 1];
+        sum[2] += a[i + 2] * b[i + 2];
+        sum[3] += a[i + 3] * b[i + 3];
+    }
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+float L2Scalar(const float* a, const float* b, size_t n) {
+    float sum[4] = {0, 0, 0, 0};
+    for (size_t i = 0; i < n; i += 4) {
+        for (size_t j = 0; j < 4; ++j) {
+            float d = a[i + j] - b[i + j];
+            sum[j] += d * d;
+        }
+    }
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+#ifdef GMCP_X86_SIMD
+
+__attribute__((target("avx2,fma")))
+float HorizontalSum(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+__attribute__((target("avx2,fma")))
+float DotAvx2(const float* a, const float* b, size_t n) {
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    for (size_t i = 0; i < n; i += 16) {
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), sum1);
+    }
+    return HorizontalSum(_mm256_add_ps(sum0, sum1));
+}
+
+__attribute__((target("avx2,fma")))
+float L2Avx2(const float* a, const float* b, size_t n) {
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    for (size_t i = 0; i < n; i += 16) {
+        __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+        sum0 = _mm256_fmadd_ps(d0, d0, sum0);
+        sum1 = _mm256_fmadd_ps(d1, d1, sum1);
+    }
+    return HorizontalSum(_mm256_add_ps(sum0, sum1));
+}
+
+__attribute__((target("avx512f")))
+float DotAvx512(const float* a, const float* b, size_t n) {
+    __m512 sum = _mm512_setzero_ps();
+    for (size_t i = 0; i < n; i += 16) {
+        sum = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), sum);
+    }
+    return _mm512_reduce_add_ps(sum);
+}
+
+__attribute__((target("avx512f")))
+float L2Avx512(const float* a, const float* b, size_t n) {
+    __m512 sum = _mm512_setzero_ps();
+    for (size_t i = 0; i < n; i += 16) {
+        __m512 d = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        sum = _mm512_fmadd_ps(d, d, sum);
+    }
+    return _mm512_reduce_add_ps(sum);
+}
+
+#endif // GMCP_X86_SIMD
+
+struct Kernels {
+    DistanceFn dot;
+    DistanceFn l2;
+    const char* name;
+};
+
+Kernels SelectKernels() {
+#ifdef GMCP_X86_SIMD
+    if (__builtin_cpu_supports("avx512f")) {
+        return {DotAvx512, L2Avx512, "avx512"};
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return {DotAvx2, L2Avx2, "avx2"};
+    }
+#endif
+    return {DotScalar, L2Scalar, "scalar"};
+}
+
+const Kernels& Selected() {
+    static const Kernels kernels = SelectKernels();
+    return kernels;
+}
+
+float NegativeDot(const float* a, const float* b, size_t n) {
+    return -Selected().dot(a, b, n);
+}
+
+} // namespace
+
+float DotProduct(const float* a, const float* b, size_t n) {
+    return Selected().dot(a, b, n);
+}
+
+float L2SquaredDistance(const float* a, const float* b, size_t n) {
+    return Selected().l2(a, b, n);
+}
+
+DistanceFn DistanceFor(VectorMetric metric) {
+    if (metric == VectorMetric::kL2) {
+        return Selected().l2;
+    }
+    return NegativeDot;
+}
+
+const char* VectorKernelImplementation() {
+    return Selected().name;
+}
+
+} // namespace gmcp
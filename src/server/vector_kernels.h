@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+namespace gmcp {
+
+enum class VectorMetric { kCosine, kL2, kDot };
+
+// Kernels process whole blocks of this many floats; callers pad vectors with
+// zeros up to a multiple of it, which changes neither dot products nor L2
+// distances
+constexpr size_t kVectorLanes = 16;
+
+// Inner product of two padded vectors of length n
+float DotProduct(const float* a, const float* b, size_t n);
+
+// Squared Euclidean distance of two padded vectors of length n
+float L2SquaredDistance(const float* a, const float* b, size_t n);
+
+// Distance to minimize for a metric: squared L2, or the negated inner product
+// for dot and cosine (cosine vectors are stored normalized)
+using DistanceFn = float (*)(const float* a, const float* b, size_t n);
+DistanceFn DistanceFor(VectorMetric metric);
+
+// Name of the kernels selected for this CPU ("avx512", "avx2", "scalar")
+const char* VectorKernelImplementation();
+
+} // namespace gmcp
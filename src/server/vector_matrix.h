@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <vector>
+#include "vector_kernels.h"
+
+namespace gmcp {
+
+// Allocator returning cache-line aligned storage
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(Alignment)); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+};
+
+// Row-major float matrix in one contiguous, 64-byte aligned buffer. Rows are
+// zero-padded to a multiple of kVectorLanes floats (64 bytes), so every row
+// starts on a cache line and kernels never need a scalar tail.
+class VectorMatrix {
+public:
+    explicit VectorMatrix(size_t dimension)
+        : dimension_(dimension),
+          stride_((dimension + kVectorLanes - 1) / kVectorLanes * kVectorLanes) {}
+
+    size_t dimension() const { return dimension_; }
+    size_t stride() const { return stride_; }
+    size_t rows() const { return stride_ == 0 ? 0 : data_.size() / stride_; }
+
+    const float* row(size_t index) const { return data_.data() + index * stride_; }
+
+    void Reserve(size_t rows) { data_.reserve(rows * stride_); }
+
+    // Append `dimension()` floats as a new row; returns its index
+    size_t AppendRow(const float* values) {
+        size_t index = rows();
+        data_.resize(data_.size() + stride_, 0.0f);
+        std::memcpy(data_.data() + index * stride_, values, dimension_ * sizeof(float));
+        return index;
+    }
+
+    // Overwrite an existing row
+    void SetRow(size_t index, const float* values) {
+        std::memcpy(data_.data() + index * stride_, values, dimension_ * sizeof(float));
+    }
+
+private:
+    size_t dimension_;
+    size_t stride_;
+    std::vector<float, AlignedAllocator<float>> data_;
+};
+
+} // namespace gmcp
@@ -0,0 +1,291 @@
+#include "vector_store.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <queue>
+#include "query_cursor.h"
+#include "substring_search.h"
+
+namespace gmcp {
+
+namespace {
+
+constexpr int kDefaultListLimit = 100;
+constexpr int kDefaultTopK = 10;
+
+bool FilterIs(const MemoryQuery& query, const std::string& name, const std::string& value) {
+    auto it = query.filters().find(name);
+    return it != query.filters().end() && it->second == value;
+}
+
+size_t FilterNumber(const MemoryQuery& query, const std::string& name, size_t fallback) {
+    auto it = query.filters().find(name);
+    if (it == query.filters().end()) {
+        return fallback;
+    }
+    size_t value = std::strtoull(it->second.c_str(), nullptr, 10);
+    return value > 0 ? value : fallback;
+}
+
+void Normalize(float* values, size_t n) {
+    float norm = std::sqrt(DotProduct(values, values, n));
+    if (norm > 0.0f) {
+        for (size_t i = 0; i < n; ++i) {
+            values[i] /= norm;
+        }
+    }
+}
+
+} // namespace
+
+VectorStore::VectorStore() : VectorStore(Options()) {
+}
+
+VectorStore::VectorStore(const Options& options)
+    : options_(options), distance_(DistanceFor(options.metric)) {
+    if (options_.dimension > 0) {
+        vectors_ = std::make_unique<VectorMatrix>(options_.dimension);
+    }
+}
+
+bool VectorStore::Put(MemoryEntry&& entry) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return PutLocked(std::move(entry));
+}
+
+size_t VectorStore::PutBatch(std::vector<MemoryEntry>&& entries) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    size_t stored = 0;
+    for (auto& entry : entries) {
+        stored += PutLocked(std::move(entry));
+    }
+    return stored;
+}
+
+bool VectorStore::PutLocked(MemoryEntry&& entry) {
+    if (entry.embedding_size() == 0) {
+        return false;
+    }
+    if (!vectors_) {
+        vectors_ = std::make_unique<VectorMatrix>(entry.embedding_size());
+    }
+    if (static_cast<size_t>(entry.embedding_size()) != vectors_->dimension()) {
+        return false;
+    }
+    if (!index_ && options_.hnsw) {
+        index_ = std::make_unique<HnswIndex>(vectors_.get(), distance_, options_.hnsw_options);
+    }
+    
+    std::vector<float, AlignedAllocator<float>> values(vectors_->stride(), 0.0f);
+    std::copy(entry.embedding().begin(), entry.embedding().end(), values.begin());
+    if (options_.metric == VectorMetric::kCosine) {
+        // The matrix holds the unit vector searched against; the entry keeps
+        // the embedding as stored so reads return it unchanged
+        Normalize(values.data(), values.size());
+    } else {
+        entry.clear_embedding();
+    }
+    
+    uint32_t row;
+    auto it = rows_.find(entry.key());
+    if (it != rows_.end()) {
+        row = it->second;
+        vectors_->SetRow(row, values.data());
+        entries_[row] = std::move(entry);
+    } else {
+        row = static_cast<uint32_t>(vectors_->AppendRow(values.data()));
+        rows_.emplace(entry.key(), row);
+        entries_.push_back(std::move(entry));
+    }
+    
+    if (index_) {
+        index_->Insert(row);
+    }
+    return true;
+}
+
+void VectorStore::Query(const MemoryQuery& query, MemoryResult* result) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    
+    switch (query.query_type()) {
+        case QueryType::GET: {
+            auto it = rows_.find(query.query());
+            if (it != rows_.end()) {
+                AppendEntry(it->second, result);
+                result->set_total_count(1);
+            }
+            break;
+        }
+        
+        case QueryType::LIST: {
+            QueryCursor cursor;
+            if (!QueryCursor::Decode(query, QueryCursor::Kind::kKey, &cursor)) {
+                break;
+            }
+            int limit = query.limit() > 0 ? query.limit() : kDefaultListLimit;
+            int count = 0;
+            auto it = cursor.at_start() ? rows_.begin() : rows_.upper_bound(cursor.key);
+            for (; it != rows_.end(); ++it) {
+                if (count >= limit) {
+                    result->set_has_more(true);
+                    result->set_next_cursor(QueryCursor::AfterKey(std::prev(it)->first).Encode());
+                    break;
+                }
+                AppendEntry(it->second, result);
+                count++;
+            }
+            result->set_total_count(rows_.size());
+            break;
+        }
+        
+        case QueryType::SEARCH: {
+            if (query.query_embedding_size() > 0) {
+                Similar(query, result);
+            } else {
+                TextSearch(query, result);
+            }
+            break;
+        }
+        
+        default:
+            break;
+    }
+}
+
+size_t VectorStore::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void VectorStore::ForEach(const std::function<void(const MemoryEntry&)>& visit,
+                          const std::function<void()>& pinned) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    pinned();
+    MemoryEntry entry;
+    for (uint32_t row = 0; row < entries_.size(); ++row) {
+        entry = entries_[row];
+        RestoreEmbedding(row, &entry);
+        visit(entry);
+    }
+}
+
+void VectorStore::AppendEntry(uint32_t row, MemoryResult* result) const {
+    MemoryEntry* entry = result->add_entries();
+    *entry = entries_[row];
+    RestoreEmbedding(row, entry);
+}
+
+void VectorStore::RestoreEmbedding(uint32_t row, MemoryEntry* entry) const {
+    if (entry->embedding_size() == 0) {
+        const float* values = vectors_->row(row);
+        entry->mutable_embedding()->Add(values, values + vectors_->dimension());
+    }
+}
+
+void VectorStore::Similar(const MemoryQuery& query, MemoryResult* result) const {
+    if (!vectors_ || static_cast<size_t>(query.query_embedding_size()) != vectors_->dimension()) {
+        return;
+    }
+    
+    std::vector<float, AlignedAllocator<float>> padded(vectors_->stride(), 0.0f);
+    std::copy(query.query_embedding().begin(), query.query_embedding().end(), padded.begin());
+    if (options_.metric == VectorMetric::kCosine) {
+        Normalize(padded.data(), padded.size());
+    }
+    
+    // Later pages rank the first offset + k rows and return the tail
+    QueryCursor cursor;
+    if (!QueryCursor::Decode(query, QueryCursor::Kind::kPosition, &cursor)) {
+        return;
+    }
+    size_t page = query.limit() > 0 ? query.limit() : kDefaultTopK;
+    size_t offset = cursor.count;
+    size_t k = offset + page;
+    bool exact = !index_ || entries_.size() < options_.exact_search_threshold ||
+                 FilterIs(query, "exact", "true");
+    std::vector<Neighbor> nearest;
+    if (exact) {
+        nearest = ExactSearch(padded.data(), k);
+    } else {
+        size_t ef = FilterNumber(query, "ef_search", options_.ef_search);
+        nearest = index_->Search(padded.data(), k, ef);
+    }
+    
+    for (size_t i = offset; i < nearest.size(); ++i) {
+        AppendEntry(nearest[i].second, result);
+        result->add_scores(ScoreOf(nearest[i].first));
+    }
+    result->set_total_count(result->entries_size());
+    if (nearest.size() == k && k < entries_.size()) {
+        result->set_has_more(true);
+        result->set_next_cursor(QueryCursor::AtPosition(k).Encode());
+    }
+}
+
+std::vector<VectorStore::Neighbor> VectorStore::ExactSearch(const float* query, size_t k) const {
+    // Bounded max-heap: the root is the worst of the current top-k
+    std::priority_queue<Neighbor> heap;
+    size_t rows = vectors_->rows();
+    size_t stride = vectors_->stride();
+    for (size_t row = 0; row < rows; ++row) {
+        float d = distance_(query, vectors_->row(row), stride);
+        if (heap.size() < k) {
+            heap.emplace(d, static_cast<uint32_t>(row));
+        } else if (d < heap.top().first) {
+            heap.pop();
+            heap.emplace(d, static_cast<uint32_t>(row));
+        }
+    }
+    
+    std::vector<Neighbor> nearest(heap.size());
+    for (size_t i = heap.size(); i-- > 0;) {
+        nearest[i] = heap.top();
+        heap.pop();
+    }
+    return nearest;
+}
+
+void VectorStore::TextSearch(const MemoryQuery& query, MemoryResult* result) const {
+    // Without a query embedding, fall back to substring search of keys and
+    // values. Pages after the first stop at the first match past the page.
+    QueryCursor cursor;
+    if (!QueryCursor::Decode(query, QueryCursor::Kind::kKey, &cursor)) {
+        return;
+    }
+    int limit = query.limit() > 0 ? query.limit() : kDefaultListLimit;
+    int total = 0;
+    auto it = cursor.at_start() ? rows_.begin() : rows_.upper_bound(cursor.key);
+    for (; it != rows_.end(); ++it) {
+        const auto& [key, row] = *it;
+        if (ContainsSubstring(key, query.query()) ||
+            ContainsSubstring(entries_[row].value(), query.query())) {
+            if (total < limit) {
+                AppendEntry(row, result);
+            }
+            total++;
+            if (!cursor.at_start() && total > limit) {
+                break;
+            }
+        }
+    }
+    if (cursor.at_start()) {
+        result->set_total_count(total);
+    }
+    result->set_has_more(total > limit);
+    if (total > limit) {
+        result->set_next_cursor(
+            QueryCursor::AfterKey(result->entries(limit - 1).key()).Encode());
+    }
+}
+
+float VectorStore::ScoreOf(float distance) const {
+    if (options_.metric == VectorMetric::kL2) {
+        return std::sqrt(std::max(distance, 0.0f));
+    }
+    return -distance;
+}
+
+} // namespace gmcp
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "hnsw_index.h"
+#include "memory_store.h"
+#include "vector_kernels.h"
+#include "vector_matrix.h"
+
+namespace gmcp {
+
+// Similarity search over MemoryEntry.embedding. Embeddings live in one
+// cache-aligned VectorMatrix (normalized for cosine, so all metrics reduce to
+// dot or L2 kernels); the rest of each entry is kept alongside by row. With
+// cosine the entry also keeps the embedding as stored, so reads return it
+// rather than its normalized form.
+// SEARCH with a query_embedding returns the top-k rows, exactly by a SIMD
+// scan for small stores or on request, otherwise through an HNSW graph.
+// Writers take the store lock exclusively; searches share it.
+class VectorStore final : public MemoryStore {
+public:
+    struct Options {
+        // Embedding size; 0 takes it from the first stored entry
+        size_t dimension = 0;
+        VectorMetric metric = VectorMetric::kCosine;
+        // Maintain an HNSW graph for approximate search
+        bool hnsw = true;
+        HnswIndex::Options hnsw_options;
+        // Candidates explored per approximate search (at least k)
+        size_t ef_search = 64;
+        // Stores smaller than this are always searched exactly
+        size_t exact_search_threshold = 10000;
+    };
+
+    VectorStore();
+    explicit VectorStore(const Options& options);
+
+    bool Put(MemoryEntry&& entry) override;
+    size_t PutBatch(std::vector<MemoryEntry>&& entries) override;
+    void Query(const MemoryQuery& query, MemoryResult* result) const override;
+    size_t size() const override;
+    void ForEach(const std::function<void(const MemoryEntry&)>& visit,
+                 const std::function<void()>& pinned) const override;
+
+private:
+    using Neighbor = HnswIndex::Neighbor;
+
+    bool PutLocked(MemoryEntry&& entry);
+
+    // Copy of a row's entry with its embedding restored
+    void AppendEntry(uint32_t row, MemoryResult* result) const;
+    // Fill in the embedding from the matrix unless the entry kept its own
+    void RestoreEmbedding(uint32_t row, MemoryEntry* entry) const;
+
+    void Similar(const MemoryQuery& query, MemoryResult* result) const;
+    std::vector<Neighbor> ExactSearch(const float* query, size_t k) const;
+    void TextSearch(const MemoryQuery& query, MemoryResult* result) const;
+
+    // Score reported to clients: similarity for dot/cosine, distance for L2
+    float ScoreOf(float distance) const;
+
+    Options options_;
+    DistanceFn distance_;
+
+    mutable std::shared_mutex mutex_;
+    std::unique_ptr<VectorMatrix> vectors_;
+    std::unique_ptr<HnswIndex> index_;
+    // Entries by row; only cosine entries keep their embedding
+    std::vector<MemoryEntry> entries_;
+    std::map<std::string, uint32_t> rows_;
+};
+
+} // namespace gmcp
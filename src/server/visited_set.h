@@ -0,0 +1,42 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gmcp {
+
+// Per-thread visited marks for graph searches over dense ids. Begin() resets
+// the set in O(1) by bumping an epoch instead of clearing the marks.
+class VisitedSet {
+public:
+    static VisitedSet& Begin(size_t size) {
+        thread_local VisitedSet visited;
+        if (visited.marks_.size() < size) {
+            visited.marks_.resize(size, 0);
+        }
+        if (++visited.epoch_ == 0) {
+            std::fill(visited.marks_.begin(), visited.marks_.end(), 0);
+            visited.epoch_ = 1;
+        }
+        return visited;
+    }
+
+    // Returns true the first time `id` is seen since Begin()
+    bool Insert(uint32_t id) {
+        if (marks_[id] == epoch_) {
+            return false;
+        }
+        marks_[id] = epoch_;
+        return true;
+    }
+
+    bool Contains(uint32_t id) const { return marks_[id] == epoch_; }
+
+private:
+    std::vector<uint32_t> marks_;
+    uint32_t epoch_ = 0;
+};
+
+} // namespace gmcp
@@ -0,0 +1,295 @@
+#include "write_ahead_log.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include "common/logging.h"
+
+namespace gmcp {
+
+namespace {
+
+// Record layout (host byte order):
+//   u32 payload length | u32 crc32 of the rest | u64 lsn | u8 type | payload
+constexpr size_t kHeaderSize = 17;
+constexpr size_t kChecksummedOffset = 8;
+constexpr char kSegmentPrefix[] = "wal-";
+constexpr char kSegmentSuffix[] = ".log";
+
+constexpr std::array<uint32_t, 256> MakeCrcTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> kCrcTable = MakeCrcTable();
+
+uint32_t Crc32(const char* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = kCrcTable[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void EncodeRecord(uint64_t lsn, WriteAheadLog::RecordType type, std::string_view payload,
+                  std::string* out) {
+    size_t start = out->size();
+    out->resize(start + kHeaderSize + payload.size());
+    char* record = out->data() + start;
+    uint32_t length = static_cast<uint32_t>(payload.size());
+    uint8_t type_byte = static_cast<uint8_t>(type);
+    std::memcpy(record, &length, sizeof(length));
+    std::memcpy(record + 8, &lsn, sizeof(lsn));
+    std::memcpy(record + 16, &type_byte, sizeof(type_byte));
+    std::memcpy(record + kHeaderSize, payload.data(), payload.size());
+    uint32_t crc = Crc32(record + kChecksummedOffset,
+                         kHeaderSize - kChecksummedOffset + payload.size());
+    std::memcpy(record + 4, &crc, sizeof(crc));
+}
+
+std::string SegmentName(uint64_t first_lsn) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s%020llu%s", kSegmentPrefix,
+                  static_cast<unsigned long long>(first_lsn), kSegmentSuffix);
+    return name;
+}
+
+bool WriteAll(int fd, const std::string& data) {
+    const char* position = data.data();
+    size_t remaining = data.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, position, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        position += written;
+        remaining -= written;
+    }
+    return true;
+}
+
+// Make a newly created file's directory entry durable
+void SyncDirectory(const std::string& directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+} // namespace
+
+WriteAheadLog::WriteAheadLog(const std::string& directory, const Options& options)
+    : directory_(directory), options_(options) {
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    if (error || !std::filesystem::is_directory(directory_)) {
+        throw std::runtime_error("cannot use log directory " + directory_);
+    }
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+std::vector<WriteAheadLog::SegmentFile> WriteAheadLog::ListSegments() const {
+    const std::string_view prefix = kSegmentPrefix;
+    const std::string_view suffix = kSegmentSuffix;
+    std::vector<SegmentFile> segments;
+    for (const auto& file : std::filesystem::directory_iterator(directory_)) {
+        std::string name = file.path().filename().string();
+        if (name.size() <= prefix.size() + suffix.size() || name.rfind(prefix, 0) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        uint64_t first_lsn = 0;
+        const char* digits = name.data() + prefix.size();
+        const char* digits_end = name.data() + name.size() - suffix.size();
+        auto [end, ec] = std::from_chars(digits, digits_end, first_lsn);
+        if (ec == std::errc() && end == digits_end) {
+            segments.push_back({first_lsn, file.path().string()});
+        }
+    }
+    std::sort(segments.begin(), segments.end(),
+              [](const SegmentFile& a, const SegmentFile& b) { return a.first_lsn < b.first_lsn; });
+    return segments;
+}
+
+size_t WriteAheadLog::Replay(uint64_t after_lsn, const ReplayFn& fn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<SegmentFile> segments = ListSegments();
+    uint64_t last_lsn = after_lsn;
+    size_t replayed = 0;
+
+    for (size_t i = 0; i < segments.size(); ++i) {
+        std::ifstream in(segments[i].path, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        size_t offset = 0;
+        bool intact = true;
+        uint64_t previous_lsn = 0;
+        while (offset < data.size()) {
+            if (data.size() - offset < kHeaderSize) {
+                intact = false;
+                break;
+            }
+            const char* record = data.data() + offset;
+            uint32_t length, crc;
+            uint64_t lsn;
+            std::memcpy(&length, record, sizeof(length));
+            std::memcpy(&crc, record + 4, sizeof(crc));
+            std::memcpy(&lsn, record + 8, sizeof(lsn));
+            if (data.size() - offset - kHeaderSize < length ||
+                Crc32(record + kChecksummedOffset, kHeaderSize - kChecksummedOffset + length) !=
+                    crc ||
+                lsn <= previous_lsn) {
+                intact = false;
+                break;
+            }
+            previous_lsn = lsn;
+            if (lsn > after_lsn) {
+                auto type = static_cast<RecordType>(static_cast<uint8_t>(record[16]));
+                fn(lsn, type, std::string_view(record + kHeaderSize, length));
+                ++replayed;
+                // Counts toward the next snapshot, which stops this replay
+                bytes_since_rotate_ += kHeaderSize + length;
+            }
+            last_lsn = std::max(last_lsn, lsn);
+            offset += kHeaderSize + length;
+        }
+
+        if (!intact) {
+            // A crash mid-append leaves a torn record; nothing after it was
+            // acknowledged, so cut the log there
+            GMCP_LOG(kWarning) << "Write-ahead log " << segments[i].path << " truncated at byte "
+                               << offset;
+            std::filesystem::resize_file(segments[i].path, offset);
+            for (size_t j = i + 1; j < segments.size(); ++j) {
+                std::filesystem::remove(segments[j].path);
+            }
+            break;
+        }
+    }
+
+    last_lsn_ = last_lsn;
+    durable_lsn_ = last_lsn;
+    if (fd_ < 0) {
+        OpenSegmentLocked(last_lsn_ + 1);
+    }
+    return replayed;
+}
+
+bool WriteAheadLog::OpenSegmentLocked(uint64_t first_lsn) {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    std::string path = (std::filesystem::path(directory_) / SegmentName(first_lsn)).string();
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        failed_ = true;
+        return false;
+    }
+    SyncDirectory(directory_);
+    return true;
+}
+
+uint64_t WriteAheadLog::Append(RecordType type, std::string_view payload) {
+    uint64_t lsn = Enqueue(type, payload);
+    return lsn != 0 && WaitDurable(lsn) ? lsn : 0;
+}
+
+uint64_t WriteAheadLog::Enqueue(RecordType type, std::string_view payload) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (failed_ || (fd_ < 0 && !OpenSegmentLocked(last_lsn_ + 1))) {
+        return 0;
+    }
+    uint64_t lsn = ++last_lsn_;
+    EncodeRecord(lsn, type, payload, &pending_);
+    bytes_since_rotate_ += kHeaderSize + payload.size();
+    return lsn;
+}
+
+bool WriteAheadLog::WaitDurable(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (durable_lsn_ < lsn && !failed_) {
+        if (flushing_) {
+            flushed_cv_.wait(lock);
+            continue;
+        }
+        // Become the group leader: write everything queued so far
+        flushing_ = true;
+        spare_.clear();
+        pending_.swap(spare_);
+        uint64_t group_end = last_lsn_;
+        int fd = fd_;
+        lock.unlock();
+
+        bool ok = WriteAll(fd, spare_) && (!options_.sync || ::fdatasync(fd) == 0);
+
+        lock.lock();
+        flushing_ = false;
+        if (ok) {
+            durable_lsn_ = group_end;
+        } else {
+            GMCP_LOG(kError) << "Write-ahead log write failed: " << std::strerror(errno);
+            failed_ = true;
+        }
+        flushed_cv_.notify_all();
+    }
+    return durable_lsn_ >= lsn;
+}
+
+uint64_t WriteAheadLog::last_lsn() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_lsn_;
+}
+
+size_t WriteAheadLog::bytes_since_rotate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_since_rotate_;
+}
+
+uint64_t WriteAheadLog::Rotate() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    flushed_cv_.wait(lock, [this] { return failed_ || (!flushing_ && pending_.empty()); });
+    if (!failed_) {
+        OpenSegmentLocked(last_lsn_ + 1);
+        bytes_since_rotate_ = 0;
+    }
+    return last_lsn_;
+}
+
+void WriteAheadLog::Truncate(uint64_t lsn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<SegmentFile> segments = ListSegments();
+    // A segment ends where the next begins; the newest one is always kept
+    for (size_t i = 0; i + 1 < segments.size(); ++i) {
+        if (segments[i + 1].first_lsn - 1 > lsn) {
+            break;
+        }
+        std::error_code error;
+        std::filesystem::remove(segments[i].path, error);
+    }
+}
+
+} // namespace gmcp
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gmcp {
+
+// Append-only log of memory store mutations, split into segment files named
+// after the sequence number (LSN) of their first record. Every record carries
+// its LSN and a CRC32, so replay stops cleanly at a torn tail.
+//
+// Appends are group committed: the first writer to find no flush in progress
+// writes and syncs everything queued so far, while writers arriving during
+// that flush queue behind it and are acknowledged together by the next one.
+// One fdatasync therefore covers a whole group of concurrent writes.
+class WriteAheadLog {
+public:
+    enum class RecordType : uint8_t {
+        kRegister = 1,  // payload: MemoryRegistration
+        kWrite = 2,     // payload: MemoryWrite
+    };
+
+    struct Options {
+        // fdatasync each commit group before acknowledging it
+        bool sync = true;
+    };
+
+    using ReplayFn = std::function<void(uint64_t lsn, RecordType type, std::string_view payload)>;
+
+    // Opens (creating if needed) the log in `directory`. Throws
+    // std::runtime_error if the directory cannot be used.
+    WriteAheadLog(const std::string& directory, const Options& options);
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Calls `fn` for every intact record with an LSN above `after_lsn`, in
+    // LSN order, and cuts off any torn tail. Must run before the first Append.
+    // Returns the number of records replayed.
+    size_t Replay(uint64_t after_lsn, const ReplayFn& fn);
+
+    // Append a record and wait until it is durable. Returns its LSN, or 0 if
+    // the log could not be written.
+    uint64_t Append(RecordType type, std::string_view payload);
+
+    // The two halves of Append: queue a record and return its LSN (0 if the
+    // log could not be written), then wait until it is durable. Records are
+    // numbered in the order they are queued.
+    uint64_t Enqueue(RecordType type, std::string_view payload);
+    bool WaitDurable(uint64_t lsn);
+
+    // LSN of the last appended record
+    uint64_t last_lsn() const;
+
+    // Bytes appended (or replayed) since the last Rotate
+    size_t bytes_since_rotate() const;
+
+    // Start a new segment once everything queued is durable. Returns the last
+    // LSN held by the earlier segments.
+    uint64_t Rotate();
+
+    // Delete segments all of whose records have LSNs up to `lsn`
+    void Truncate(uint64_t lsn);
+
+private:
+    struct SegmentFile {
+        uint64_t first_lsn;
+        std::string path;
+    };
+
+    std::vector<SegmentFile> ListSegments() const;
+    bool OpenSegmentLocked(uint64_t first_lsn);
+
+    const std::string directory_;
+    const Options options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable flushed_cv_;
+    int fd_ = -1;
+    uint64_t last_lsn_ = 0;
+    uint64_t durable_lsn_ = 0;
+    bool flushing_ = false;
+    bool failed_ = false;
+    size_t bytes_since_rotate_ = 0;
+    // Records encoded but not yet written; swapped with spare_ by the flusher
+    std::string pending_;
+    std::string spare_;
+};
+
+} // namespace gmcp
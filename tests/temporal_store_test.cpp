@@ -0,0 +1,116 @@
+// Pagination tests for TemporalStore.
+//
+// Pages through RANGE and SEARCH results that share one timestamp while new
+// entries keep arriving, sealing the head and merging segments between
+// pages, and checks that every entry is returned exactly once.
+//
+// Usage: temporal_store_test
+
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <thread>
+#include "server/temporal_store.h"
+
+namespace {
+
+constexpr int64_t kTimestamp = 1000;
+constexpr int kInitial = 20;
+constexpr int kAppendedPerPage = 5;
+constexpr int kAppendingPages = 12;
+constexpr int kPageSize = 3;
+
+int failures = 0;
+
+void Check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", what.c_str());
+        ++failures;
+    }
+}
+
+void Append(gmcp::TemporalStore& store, int64_t timestamp, int* next_key) {
+    gmcp::MemoryEntry entry;
+    entry.set_key("k" + std::to_string((*next_key)++));
+    entry.set_value("v");
+    entry.set_timestamp(timestamp);
+    store.Put(std::move(entry));
+}
+
+// Wait for the background merge to finish. With a fan-in of two, fully
+// merged segments hold distinct powers of two of sealed heads.
+bool WaitForMerge(const gmcp::TemporalStore& store, size_t segment_size) {
+    size_t merged = std::popcount(store.size() / segment_size);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (store.segment_count() != merged) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void TestEqualTimestampPaging(gmcp::QueryType type) {
+    gmcp::TemporalStore::Options options;
+    options.segment_size = 8;
+    options.merge_fan_in = 2;
+    gmcp::TemporalStore store(options);
+
+    int next_key = 0;
+    for (int i = 0; i < kInitial; ++i) {
+        Append(store, kTimestamp, &next_key);
+    }
+
+    std::map<std::string, int> seen;
+    gmcp::MemoryQuery query;
+    query.set_query_type(type);
+    query.set_limit(kPageSize);
+    if (type == gmcp::QueryType::SEARCH) {
+        query.set_query("k");
+    }
+    for (int page = 0;; ++page) {
+        gmcp::MemoryResult result;
+        store.Query(query, &result);
+        for (const auto& entry : result.entries()) {
+            seen[entry.key()]++;
+        }
+        if (!result.has_more()) {
+            break;
+        }
+        query.set_cursor(result.next_cursor());
+
+        // Appends at the same timestamp seal the head, and the merge thread
+        // then combines the sealed segments before the next page
+        if (page < kAppendingPages) {
+            for (int i = 0; i < kAppendedPerPage; ++i) {
+                Append(store, kTimestamp, &next_key);
+            }
+            Check(WaitForMerge(store, options.segment_size), "segments merged");
+        }
+    }
+
+    std::string name = type == gmcp::QueryType::SEARCH ? "SEARCH" : "RANGE";
+    Check(static_cast<int>(seen.size()) == next_key,
+          name + " returned " + std::to_string(seen.size()) + " of " +
+              std::to_string(next_key) + " entries");
+    for (const auto& [key, count] : seen) {
+        Check(count == 1, name + " returned " + key + " " + std::to_string(count) + " times");
+    }
+}
+
+} // namespace
+
+int main() {
+    TestEqualTimestampPaging(gmcp::QueryType::RANGE);
+    TestEqualTimestampPaging(gmcp::QueryType::SEARCH);
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("temporal_store_test: OK\n");
+    return EXIT_SUCCESS;
+}